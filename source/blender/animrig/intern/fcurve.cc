@@ -13,6 +13,7 @@
 #include "ANIM_animdata.hh"
 #include "ANIM_fcurve.hh"
 #include "BKE_fcurve.hh"
+#include "BLI_array.hh"
 #include "BLI_math_base.h"
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
@@ -382,10 +383,11 @@ void sample_fcurve_segment(const FCurve *fcu,
                            float *samples,
                            const int sample_count)
 {
+  Array<float> evaluation_times(sample_count);
   for (int i = 0; i < sample_count; i++) {
-    const float evaluation_time = start_frame + (float(i) / sample_rate);
-    samples[i] = evaluate_fcurve(fcu, evaluation_time);
+    evaluation_times[i] = start_frame + (float(i) / sample_rate);
   }
+  evaluate_fcurve(fcu, evaluation_times, {samples, sample_count});
 }
 
 static void remove_fcurve_key_range(FCurve *fcu,
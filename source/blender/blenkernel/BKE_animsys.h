@@ -359,6 +359,11 @@ void BKE_animsys_eval_driver(struct Depsgraph *depsgraph,
 
 void BKE_animsys_update_driver_array(struct ID *id);
 
+/**
+ * Free the RNA paths that were resolved while evaluating the animation of an evaluated ID.
+ */
+void BKE_animsys_free_path_cache(struct AnimData *adt);
+
 /* ************************************* */
 
 #ifdef __cplusplus
@@ -650,6 +650,12 @@ void BKE_pose_eval_cleanup(Depsgraph *depsgraph, Scene *scene, Object *object);
 /* Note that we could have a 'BKE_armature_deform_coords' that doesn't take object data
  * currently there are no callers for this though. */
 
+namespace blender::bke {
+struct ArmatureDeformWeights;
+/** Free the weights cache filled by #BKE_armature_deform_coords_with_mesh. */
+void armature_deform_weights_free(ArmatureDeformWeights *weights);
+}  // namespace blender::bke
+
 void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
                                                     const Object *ob_target,
                                                     float (*vert_coords)[3],
@@ -670,15 +676,23 @@ void BKE_armature_deform_coords_with_curves(
     int deformflag,
     blender::StringRefNull defgrp_name);
 
-void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
-                                          const Object *ob_target,
-                                          float (*vert_coords)[3],
-                                          float (*vert_deform_mats)[3][3],
-                                          int vert_coords_len,
-                                          int deformflag,
-                                          float (*vert_coords_prev)[3],
-                                          const char *defgrp_name,
-                                          const Mesh *me_target);
+/**
+ * \param weights_cache: Optional storage for the vertex group weights of the mesh, compacted to
+ * the groups with deforming bones. It is reused on the next call as long as the vertex groups of
+ * the mesh and the bones they map to don't change. Free it with
+ * #blender::bke::armature_deform_weights_free.
+ */
+void BKE_armature_deform_coords_with_mesh(
+    const Object *ob_arm,
+    const Object *ob_target,
+    float (*vert_coords)[3],
+    float (*vert_deform_mats)[3][3],
+    int vert_coords_len,
+    int deformflag,
+    float (*vert_coords_prev)[3],
+    const char *defgrp_name,
+    const Mesh *me_target,
+    blender::bke::ArmatureDeformWeights **weights_cache = nullptr);
 
 void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                                               const Object *ob_target,
@@ -23,6 +23,10 @@ struct MFace;
 struct Mesh;
 struct PointCloud;
 
+namespace blender {
+class WideBVHTree;
+}
+
 /**
  * Struct that stores basic information about a #BVHTree built from a mesh.
  */
@@ -121,6 +125,15 @@ BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
                                    BVHCacheType bvh_cache_type,
                                    int tree_type);
 
+/**
+ * Get a #blender::WideBVHTree for the cached BVH-tree in \a data, which has to be filled by
+ * #BKE_bvhtree_from_mesh_get with the same type. The wide tree is built on first use and freed
+ * together with the cache. Returns null when the tree isn't cached or can't be converted.
+ */
+const blender::WideBVHTree *BKE_bvhtree_from_mesh_wide_tree_get(const BVHTreeFromMesh *data,
+                                                                 const Mesh *mesh,
+                                                                 BVHCacheType bvh_cache_type);
+
 /**
  * Build a bvh tree from the triangles in the mesh that correspond to the faces in the given mask.
  */
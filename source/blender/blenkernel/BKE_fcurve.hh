@@ -9,6 +9,7 @@
  */
 
 #include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
 #include "BLI_string_ref.hh"
 #include "DNA_curve_types.h"
 
@@ -599,6 +600,23 @@ void BKE_fcurve_correct_bezpart(const float v1[2], float v2[2], float v3[2], con
 
 /* evaluate fcurve */
 float evaluate_fcurve(const FCurve *fcu, float evaltime);
+/**
+ * Evaluate the F-Curve at many times at once, e.g. for baking. This is faster than evaluating
+ * every time separately, because the keyframes around a time are found by walking forward from
+ * the previous time instead of searching them, and the Bézier segments are only prepared once.
+ *
+ * \param evaltimes: The times to evaluate the curve at, sorted in ascending order.
+ */
+void evaluate_fcurve(const FCurve *fcu,
+                     blender::Span<float> evaltimes,
+                     blender::MutableSpan<float> r_values);
+/**
+ * Evaluate multiple F-Curves at the same times in parallel. The values of every curve are stored
+ * consecutively in \a r_values, which has to have space for all curves and times.
+ */
+void evaluate_fcurves(blender::Span<const FCurve *> fcurves,
+                      blender::Span<float> evaltimes,
+                      blender::MutableSpan<float> r_values);
 float evaluate_fcurve_only_curve(const FCurve *fcu, float evaltime);
 float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
                              FCurve *fcu,
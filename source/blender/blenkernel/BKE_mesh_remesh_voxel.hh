@@ -8,6 +8,8 @@
  * \ingroup bke
  */
 
+#include <cstdint>
+
 struct Mesh;
 
 Mesh *BKE_mesh_remesh_voxel_fix_poles(const Mesh *mesh);
@@ -23,4 +25,17 @@ Mesh *BKE_mesh_remesh_quadriflow(const Mesh *mesh,
 
 namespace blender::bke {
 void mesh_remesh_reproject_attributes(const Mesh &src, Mesh &dst);
+
+/** Temporary memory used by #BKE_mesh_remesh_voxel when it is built without OpenVDB. */
+constexpr int64_t remesh_voxel_tiled_memory_budget = 256 * 1024 * 1024;
+
+/**
+ * Voxel remesh that doesn't depend on OpenVDB. The distance field is evaluated in tiles that use
+ * at most \a memory_budget bytes, and only in a narrow band around the surface. The result is
+ * watertight across tile borders and consists of quads, without adaptivity.
+ */
+Mesh *mesh_remesh_voxel_tiled(const Mesh &mesh,
+                              float voxel_size,
+                              float isovalue,
+                              int64_t memory_budget);
 }
@@ -73,6 +73,17 @@ namespace blender::bke::shrinkwrap {
 
 const ShrinkwrapBoundaryData &boundary_cache_ensure(const Mesh &mesh);
 
+/**
+ * The target triangle that was nearest to each vertex in the previous evaluation of a modifier.
+ * When the vertices and the target only move a little between evaluations, that triangle is
+ * still close, and starting the search with its distance lets the BVH tree skip most of the
+ * target. The indices are only a starting point for the search, so they don't have to be
+ * invalidated when the target changes.
+ */
+struct NearestHitCache {
+  Array<int> tri_indices;
+};
+
 }  // namespace blender::bke::shrinkwrap
 
 /* Information about a mesh and BVH tree. */
@@ -110,6 +121,9 @@ void BKE_shrinkwrap_free_tree(ShrinkwrapTreeData *data);
 
 /**
  * Main shrink-wrap function (implementation of the shrink-wrap modifier).
+ *
+ * \param hit_cache: Optional storage for the nearest target triangles of the nearest surface
+ * mode, used to speed up the search on the next call. Free it with #MEM_delete.
  */
 void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
                                const ModifierEvalContext *ctx,
@@ -119,7 +133,8 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
                                const MDeformVert *dvert,
                                int defgrp_index,
                                float (*vertexCos)[3],
-                               int numVerts);
+                               int numVerts,
+                               blender::bke::shrinkwrap::NearestHitCache **hit_cache = nullptr);
 /* Implementation of the Shrinkwrap Grease Pencil modifier. */
 void shrinkwrapGpencilModifier_deform(ShrinkwrapGpencilModifierData *mmd,
                                       Object *ob,
@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
+#include <string>
 
 #include "MEM_guardedalloc.h"
 
@@ -19,10 +20,12 @@
 #include "BLI_blenlib.h"
 #include "BLI_dynstr.h"
 #include "BLI_listbase.h"
+#include "BLI_map.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
@@ -555,6 +558,134 @@ static void animsys_write_orig_anim_rna(PointerRNA *ptr,
   }
 }
 
+/* ----------------------------------------- */
+
+namespace blender::bke {
+
+/**
+ * RNA path of an F-Curve, resolved when the F-Curve was evaluated for the first time. Resolving
+ * the path string every time the animation is evaluated is expensive for IDs with many animated
+ * properties, like rigs.
+ */
+struct ResolvedFCurvePath {
+  enum class State : int8_t {
+    /** The path has not been resolved yet. */
+    Empty,
+    /**
+     * The path doesn't point to an existing property, the F-Curve is skipped. Properties that
+     * exist but can't be animated are not cached, because that can change without the path
+     * changing, e.g. when an array property is resized.
+     */
+    Invalid,
+    /** The resolved pointer belongs to another ID, so it can change independently. */
+    Uncached,
+    Resolved,
+  };
+  State state = State::Empty;
+  /** Path and index at the time of resolving, to detect changes of the F-Curve. */
+  std::string rna_path;
+  int array_index = 0;
+  PathResolvedRNA result;
+};
+
+/**
+ * Resolved RNA paths of the F-Curves of an evaluated ID, stored in #AnimData.path_cache.
+ *
+ * The pointers stay valid as long as the evaluated ID is not copied from the original again.
+ * That frees the #AnimData and with it the cache. Changes to the F-Curves, e.g. when the action
+ * is copied again, are detected by comparing the path with the one that was resolved before.
+ *
+ * The cache is only accessed by the animation evaluation of its ID, so no locking is needed.
+ */
+struct AnimDataPathCache {
+  /** Resolved paths of every F-Curve in a list, in the same order as the F-Curves. */
+  Map<const ListBase *, Vector<ResolvedFCurvePath>> paths_by_list;
+};
+
+}  // namespace blender::bke
+
+void BKE_animsys_free_path_cache(AnimData *adt)
+{
+  MEM_delete(adt->path_cache);
+  adt->path_cache = nullptr;
+}
+
+/**
+ * Get the cached paths of the F-Curves in the list. Only the evaluated copies of IDs have a
+ * cache, the data of original IDs can be changed at any time.
+ */
+static blender::Vector<blender::bke::ResolvedFCurvePath> *animsys_resolved_fcurve_paths(
+    const PointerRNA *ptr, const ListBase *list)
+{
+  ID *id = ptr->owner_id;
+  if (id == nullptr || ptr->data != id || (id->tag & LIB_TAG_COPIED_ON_EVAL) == 0) {
+    return nullptr;
+  }
+  AnimData *adt = BKE_animdata_from_id(id);
+  if (adt == nullptr) {
+    return nullptr;
+  }
+  if (adt->path_cache == nullptr) {
+    adt->path_cache = MEM_new<blender::bke::AnimDataPathCache>(__func__);
+  }
+  return &adt->path_cache->paths_by_list.lookup_or_add_default(list);
+}
+
+/**
+ * Same as #BKE_animsys_rna_path_resolve, but reuses the result from a previous evaluation if
+ * the F-Curve did not change.
+ */
+static bool animsys_rna_path_resolve_cached(PointerRNA *ptr,
+                                            const FCurve *fcu,
+                                            blender::bke::ResolvedFCurvePath &cached,
+                                            PathResolvedRNA *r_result)
+{
+  using State = blender::bke::ResolvedFCurvePath::State;
+  if (fcu->rna_path == nullptr) {
+    return false;
+  }
+  if (cached.state == State::Empty || cached.array_index != fcu->array_index ||
+      cached.rna_path != fcu->rna_path)
+  {
+    cached.rna_path = fcu->rna_path;
+    cached.array_index = fcu->array_index;
+    if (!BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, &cached.result)) {
+      const bool path_exists = RNA_path_resolve_property(
+          ptr, fcu->rna_path, &cached.result.ptr, &cached.result.prop);
+      cached.state = path_exists ? State::Empty : State::Invalid;
+      return false;
+    }
+    cached.state = cached.result.ptr.owner_id == ptr->owner_id ? State::Resolved :
+                                                                 State::Uncached;
+    *r_result = cached.result;
+    return true;
+  }
+  switch (cached.state) {
+    case State::Invalid:
+      return false;
+    case State::Uncached:
+      return BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, r_result);
+    case State::Resolved:
+      /* Whether a property can be animated and the length of arrays can change without the path
+       * changing, so check them again. */
+      if (!RNA_property_animateable(&cached.result.ptr, cached.result.prop)) {
+        return false;
+      }
+      if (cached.result.prop_index >= 0 &&
+          cached.result.prop_index >=
+              RNA_property_array_length(&cached.result.ptr, cached.result.prop))
+      {
+        return false;
+      }
+      *r_result = cached.result;
+      return true;
+    case State::Empty:
+      break;
+  }
+  BLI_assert_unreachable();
+  return false;
+}
+
 /**
  * Evaluate all the F-Curves in the given list
  * This performs a set of standard checks. If extra checks are required,
@@ -565,15 +696,30 @@ static void animsys_evaluate_fcurves(PointerRNA *ptr,
                                      const AnimationEvalContext *anim_eval_context,
                                      bool flush_to_original)
 {
+  blender::Vector<blender::bke::ResolvedFCurvePath> *cached_paths =
+      animsys_resolved_fcurve_paths(ptr, list);
+
   /* Calculate then execute each curve. */
-  LISTBASE_FOREACH (FCurve *, fcu, list) {
+  int fcu_index;
+  LISTBASE_FOREACH_INDEX (FCurve *, fcu, list, fcu_index) {
 
     if (!is_fcurve_evaluatable(fcu)) {
       continue;
     }
 
     PathResolvedRNA anim_rna;
-    if (BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, &anim_rna)) {
+    bool is_resolved;
+    if (cached_paths) {
+      if (cached_paths->size() <= fcu_index) {
+        cached_paths->resize(fcu_index + 1);
+      }
+      is_resolved = animsys_rna_path_resolve_cached(
+          ptr, fcu, (*cached_paths)[fcu_index], &anim_rna);
+    }
+    else {
+      is_resolved = BKE_animsys_rna_path_resolve(ptr, fcu->rna_path, fcu->array_index, &anim_rna);
+    }
+    if (is_resolved) {
       const float curval = calculate_fcurve(&anim_rna, fcu, anim_eval_context);
       BKE_animsys_write_to_rna_path(&anim_rna, curval);
       if (flush_to_original) {
@@ -0,0 +1,157 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "testing/testing.h"
+
+#include "BKE_anim_data.hh"
+#include "BKE_animsys.h"
+#include "BKE_fcurve.hh"
+#include "BKE_idprop.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_object.hh"
+
+#include "ANIM_fcurve.hh"
+
+#include "DNA_action_types.h"
+#include "DNA_anim_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "CLG_log.h"
+
+namespace blender::bke::tests {
+using namespace blender::animrig;
+
+class AnimSysPathCacheTest : public testing::Test {
+ protected:
+  Main *bmain;
+  Object *object;
+  FCurve *fcu;
+
+ public:
+  static void SetUpTestSuite()
+  {
+    CLG_init();
+    BKE_idtype_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    object = BKE_object_add_only_object(bmain, OB_EMPTY, "Object");
+
+    fcu = BKE_fcurve_create();
+    fcu->rna_path = BLI_strdup("location");
+    fcu->array_index = 1;
+    const KeyframeSettings settings = get_keyframe_settings(false);
+    insert_vert_fcurve(fcu, {1.0f, 5.0f}, settings, INSERTKEY_NOFLAGS);
+
+    bAction *action = static_cast<bAction *>(BKE_id_new(bmain, ID_AC, "Action"));
+    BLI_addtail(&action->curves, fcu);
+    AnimData *adt = BKE_animdata_ensure_id(&object->id);
+    adt->action = action;
+    id_us_plus(&action->id);
+
+    /* Only evaluated copies of IDs cache the resolved paths. */
+    object->id.tag |= LIB_TAG_COPIED_ON_EVAL;
+  }
+
+  void TearDown() override
+  {
+    object->id.tag &= ~LIB_TAG_COPIED_ON_EVAL;
+    BKE_main_free(bmain);
+  }
+
+  void evaluate()
+  {
+    const AnimationEvalContext anim_eval_context = BKE_animsys_eval_context_construct(nullptr,
+                                                                                      1.0f);
+    BKE_animsys_evaluate_animdata(
+        &object->id, object->adt, &anim_eval_context, ADT_RECALC_ANIM, false);
+  }
+
+  void set_path(const char *rna_path, const int array_index)
+  {
+    MEM_freeN(fcu->rna_path);
+    fcu->rna_path = BLI_strdup(rna_path);
+    fcu->array_index = array_index;
+  }
+};
+
+TEST_F(AnimSysPathCacheTest, ReuseResolvedPath)
+{
+  evaluate();
+  EXPECT_NE(object->adt->path_cache, nullptr);
+  EXPECT_EQ(object->loc[1], 5.0f);
+
+  object->loc[1] = 0.0f;
+  evaluate();
+  EXPECT_EQ(object->loc[1], 5.0f);
+}
+
+TEST_F(AnimSysPathCacheTest, NoCacheForOriginalID)
+{
+  object->id.tag &= ~LIB_TAG_COPIED_ON_EVAL;
+  evaluate();
+  EXPECT_EQ(object->adt->path_cache, nullptr);
+  EXPECT_EQ(object->loc[1], 5.0f);
+}
+
+TEST_F(AnimSysPathCacheTest, ChangedPath)
+{
+  evaluate();
+  EXPECT_EQ(object->loc[1], 5.0f);
+
+  set_path("location", 2);
+  evaluate();
+  EXPECT_EQ(object->loc[2], 5.0f);
+
+  set_path("scale", 0);
+  evaluate();
+  EXPECT_EQ(object->scale[0], 5.0f);
+}
+
+TEST_F(AnimSysPathCacheTest, InvalidPath)
+{
+  set_path("does_not_exist", 0);
+  evaluate();
+  evaluate();
+
+  /* A fixed path is resolved again. */
+  set_path("location", 0);
+  evaluate();
+  EXPECT_EQ(object->loc[0], 5.0f);
+}
+
+TEST_F(AnimSysPathCacheTest, ArrayResize)
+{
+  /* An existing property that can't be animated with the index of the F-Curve is not cached as
+   * invalid, since the array can grow without the path changing. */
+  IDProperty *prop = idprop::create("prop", Span<float>({1.0f, 2.0f})).release();
+  IDP_AddToGroup(IDP_EnsureProperties(&object->id), prop);
+  set_path("[\"prop\"]", 2);
+
+  evaluate();
+  EXPECT_EQ(prop->len, 2);
+
+  IDP_ResizeArray(prop, 3);
+  static_cast<float *>(IDP_Array(prop))[2] = 0.0f;
+  evaluate();
+  EXPECT_EQ(static_cast<float *>(IDP_Array(prop))[2], 5.0f);
+
+  /* A resolved index that is out of range after shrinking the array is not written. */
+  IDP_ResizeArray(prop, 2);
+  evaluate();
+  EXPECT_EQ(prop->len, 2);
+}
+
+}  // namespace blender::bke::tests
@@ -17,11 +17,15 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
+#include "BLI_implicit_sharing.hh"
 #include "BLI_listbase.h"
 #include "BLI_math_matrix.h"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_offset_indices.hh"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_armature_types.h"
@@ -229,6 +233,137 @@ static void pchan_bone_deform(const bPoseChannel *pchan,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Armature Deform Weights
+ *
+ * The vertex group weights of a mesh, compacted to the groups that have a deforming bone.
+ * \{ */
+
+namespace blender::bke {
+
+struct ArmatureDeformWeights : NonCopyable, NonMovable {
+  /** Weak user of the vertex group layer the weights are built from. */
+  const ImplicitSharingInfo *sharing_info = nullptr;
+  int64_t version = 0;
+  /** Whether each vertex group had a deforming bone when the weights were built. */
+  Array<bool> mapped_groups;
+  /** Whether each vertex is in a group with a bone, even if all its weights are zero. */
+  Array<bool> has_mapped_group;
+  /** Range of every vertex in #groups and #weights. Zero weights are skipped. */
+  Array<int> offsets;
+  Array<int> groups;
+  Array<float> weights;
+
+  ~ArmatureDeformWeights()
+  {
+    if (this->sharing_info) {
+      this->sharing_info->remove_weak_user_and_delete_if_last();
+    }
+  }
+};
+
+void armature_deform_weights_free(ArmatureDeformWeights *weights)
+{
+  MEM_delete(weights);
+}
+
+static void armature_deform_weights_build(ArmatureDeformWeights &r_weights,
+                                          const Span<MDeformVert> dverts,
+                                          const Span<bool> mapped_groups)
+{
+  const auto is_mapped = [&](const MDeformWeight &dw) {
+    return uint(dw.def_nr) < uint(mapped_groups.size()) && mapped_groups[dw.def_nr];
+  };
+
+  r_weights.mapped_groups = mapped_groups;
+  r_weights.has_mapped_group.reinitialize(dverts.size());
+  r_weights.offsets.reinitialize(dverts.size() + 1);
+  threading::parallel_for(dverts.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      bool has_mapped_group = false;
+      int count = 0;
+      for (const MDeformWeight &dw : Span(dverts[i].dw, dverts[i].totweight)) {
+        if (is_mapped(dw)) {
+          has_mapped_group = true;
+          count += dw.weight != 0.0f;
+        }
+      }
+      r_weights.has_mapped_group[i] = has_mapped_group;
+      r_weights.offsets[i] = count;
+    }
+  });
+  const OffsetIndices<int> offsets = offset_indices::accumulate_counts_to_offsets(
+      r_weights.offsets);
+
+  r_weights.groups.reinitialize(offsets.total_size());
+  r_weights.weights.reinitialize(offsets.total_size());
+  threading::parallel_for(dverts.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      int dst = offsets[i].start();
+      for (const MDeformWeight &dw : Span(dverts[i].dw, dverts[i].totweight)) {
+        if (is_mapped(dw) && dw.weight != 0.0f) {
+          r_weights.groups[dst] = dw.def_nr;
+          r_weights.weights[dst] = dw.weight;
+          dst++;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * Get the compacted weights of the mesh, reusing the cached ones if neither the vertex groups nor
+ * the groups that map to deforming bones have changed since they were built.
+ *
+ * \return Null if changes to the vertex groups can't be detected.
+ */
+static const ArmatureDeformWeights *armature_deform_weights_ensure(
+    ArmatureDeformWeights *&cache,
+    const Mesh &mesh,
+    const Span<MDeformVert> dverts,
+    const Span<bPoseChannel *> pchan_from_defbase)
+{
+  const int layer_index = CustomData_get_layer_index(&mesh.vert_data, CD_MDEFORMVERT);
+  if (layer_index == -1) {
+    return nullptr;
+  }
+  const ImplicitSharingInfo *sharing_info = mesh.vert_data.layers[layer_index].sharing_info;
+  if (sharing_info == nullptr) {
+    return nullptr;
+  }
+
+  Array<bool> mapped_groups(pchan_from_defbase.size());
+  for (const int i : pchan_from_defbase.index_range()) {
+    mapped_groups[i] = pchan_from_defbase[i] != nullptr;
+  }
+
+  if (cache && cache->sharing_info == sharing_info &&
+      cache->version == sharing_info->version() &&
+      cache->offsets.size() == dverts.size() + 1 &&
+      cache->mapped_groups.as_span() == mapped_groups.as_span())
+  {
+    return cache;
+  }
+
+  if (cache == nullptr) {
+    cache = MEM_new<ArmatureDeformWeights>(__func__);
+  }
+  if (cache->sharing_info != sharing_info) {
+    if (cache->sharing_info) {
+      cache->sharing_info->remove_weak_user_and_delete_if_last();
+    }
+    sharing_info->add_weak_user();
+    cache->sharing_info = sharing_info;
+  }
+  cache->version = sharing_info->version();
+  armature_deform_weights_build(*cache, dverts, mapped_groups);
+  return cache;
+}
+
+}  // namespace blender::bke
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Armature Deform #BKE_armature_deform_coords API
  *
@@ -255,6 +390,9 @@ struct ArmatureUserdata {
   bPoseChannel **pchan_from_defbase;
   int defbase_len;
 
+  /** Compacted weights used instead of #dverts when available. */
+  const blender::bke::ArmatureDeformWeights *weights;
+
   float premat[4][4];
   float postmat[4][4];
 
@@ -338,38 +476,37 @@ static void armature_vert_task_with_dvert(const ArmatureUserdata *data,
   /* Apply the object's matrix */
   mul_m4_v3(data->premat, co);
 
-  if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
+  const auto deform_by_group = [&](const bPoseChannel *pchan, float weight) {
+    const Bone *bone = pchan->bone;
+    if (bone && bone->flag & BONE_MULT_VG_ENV) {
+      weight *= distfactor_to_bone(
+          co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
+    }
+    pchan_bone_deform(pchan, weight, vec, dq, smat, co, full_deform, &contrib);
+  };
+
+  bool deformed = false;
+  if (const blender::bke::ArmatureDeformWeights *weights = data->weights) {
+    const blender::OffsetIndices<int> offsets = weights->offsets.as_span();
+    for (const int j : offsets[i]) {
+      deform_by_group(data->pchan_from_defbase[weights->groups[j]], weights->weights[j]);
+    }
+    deformed = weights->has_mapped_group[i];
+  }
+  else if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
     const MDeformWeight *dw = dvert->dw;
-    int deformed = 0;
     uint j;
     for (j = dvert->totweight; j != 0; j--, dw++) {
       const uint index = dw->def_nr;
       if (index < data->defbase_len && (pchan = data->pchan_from_defbase[index])) {
-        float weight = dw->weight;
-        const Bone *bone = pchan->bone;
-
-        deformed = 1;
-
-        if (bone && bone->flag & BONE_MULT_VG_ENV) {
-          weight *= distfactor_to_bone(
-              co, bone->arm_head, bone->arm_tail, bone->rad_head, bone->rad_tail, bone->dist);
-        }
-
-        pchan_bone_deform(pchan, weight, vec, dq, smat, co, full_deform, &contrib);
-      }
-    }
-    /* If there are vertex-groups but not groups with bones (like for soft-body groups). */
-    if (deformed == 0 && use_envelope) {
-      for (pchan = static_cast<const bPoseChannel *>(data->ob_arm->pose->chanbase.first); pchan;
-           pchan = pchan->next)
-      {
-        if (!(pchan->bone->flag & BONE_NO_DEFORM)) {
-          contrib += dist_bone_deform(pchan, vec, dq, smat, co, full_deform);
-        }
+        deformed = true;
+        deform_by_group(pchan, dw->weight);
       }
     }
   }
-  else if (use_envelope) {
+
+  /* If there are no vertex-groups or no groups with bones (like for soft-body groups). */
+  if (!deformed && use_envelope) {
     for (pchan = static_cast<const bPoseChannel *>(data->ob_arm->pose->chanbase.first); pchan;
          pchan = pchan->next)
     {
@@ -490,7 +627,8 @@ static void armature_deform_coords_impl(const Object *ob_arm,
                                         blender::Span<MDeformVert> dverts,
                                         const Mesh *me_target,
                                         const BMEditMesh *em_target,
-                                        bGPDstroke *gps_target)
+                                        bGPDstroke *gps_target,
+                                        blender::bke::ArmatureDeformWeights **weights_cache)
 {
   const bArmature *arm = static_cast<const bArmature *>(ob_arm->data);
   bPoseChannel **pchan_from_defbase = nullptr;
@@ -501,6 +639,8 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   bool use_dverts = false;
   int armature_def_nr = -1;
   int cd_dvert_offset = -1;
+  const Mesh *mesh = nullptr;
+  const blender::bke::ArmatureDeformWeights *weights = nullptr;
 
   /* in editmode, or not an armature */
   if (arm->edbo || (ob_arm->pose == nullptr)) {
@@ -519,7 +659,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
     if (ob_target->type == OB_MESH) {
       target_data_id = me_target == nullptr ? (const ID *)ob_target->data : &me_target->id;
       if (em_target == nullptr) {
-        const Mesh *mesh = (const Mesh *)target_data_id;
+        mesh = (const Mesh *)target_data_id;
         dverts = mesh->deform_verts();
       }
     }
@@ -573,6 +713,11 @@ static void armature_deform_coords_impl(const Object *ob_arm,
             }
           }
         }
+
+        if (weights_cache && mesh && dverts.size() == vert_coords_len) {
+          weights = blender::bke::armature_deform_weights_ensure(
+              *weights_cache, *mesh, dverts, {pchan_from_defbase, defbase_len});
+        }
       }
     }
   }
@@ -592,6 +737,7 @@ static void armature_deform_coords_impl(const Object *ob_arm,
   data.dverts_len = dverts.size();
   data.pchan_from_defbase = pchan_from_defbase;
   data.defbase_len = defbase_len;
+  data.weights = weights;
   data.bmesh.cd_dvert_offset = cd_dvert_offset;
 
   float obinv[4][4];
@@ -650,7 +796,8 @@ void BKE_armature_deform_coords_with_gpencil_stroke(const Object *ob_arm,
                               {},
                               nullptr,
                               nullptr,
-                              gps_target);
+                              gps_target,
+                              nullptr);
 }
 
 void BKE_armature_deform_coords_with_curves(
@@ -675,6 +822,7 @@ void BKE_armature_deform_coords_with_curves(
       dverts,
       nullptr,
       nullptr,
+      nullptr,
       nullptr);
 }
 
@@ -686,7 +834,8 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                                           int deformflag,
                                           float (*vert_coords_prev)[3],
                                           const char *defgrp_name,
-                                          const Mesh *me_target)
+                                          const Mesh *me_target,
+                                          blender::bke::ArmatureDeformWeights **weights_cache)
 {
   armature_deform_coords_impl(ob_arm,
                               ob_target,
@@ -699,7 +848,8 @@ void BKE_armature_deform_coords_with_mesh(const Object *ob_arm,
                               {},
                               me_target,
                               nullptr,
-                              nullptr);
+                              nullptr,
+                              weights_cache);
 }
 
 void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
@@ -723,6 +873,7 @@ void BKE_armature_deform_coords_with_editmesh(const Object *ob_arm,
                               {},
                               nullptr,
                               em_target,
+                              nullptr,
                               nullptr);
 }
 
@@ -9,6 +9,7 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_pointcloud_types.h"
 
+#include "BLI_kdopbvh_wide.hh"
 #include "BLI_math_geom.h"
 #include "BLI_task.h"
 
@@ -32,6 +33,9 @@ using blender::VArray;
 struct BVHCacheItem {
   bool is_filled;
   BVHTree *tree;
+  /** Built from #tree on first use, see #BKE_bvhtree_from_mesh_wide_tree_get. */
+  bool wide_tree_is_filled;
+  blender::WideBVHTree *wide_tree;
 };
 
 struct BVHCache {
@@ -135,6 +139,8 @@ void bvhcache_free(BVHCache *bvh_cache)
     BVHCacheItem *item = &bvh_cache->items[index];
     BLI_bvhtree_free(item->tree);
     item->tree = nullptr;
+    delete item->wide_tree;
+    item->wide_tree = nullptr;
   }
   BLI_mutex_end(&bvh_cache->mutex);
   MEM_freeN(bvh_cache);
@@ -1030,6 +1036,28 @@ BVHTree *BKE_bvhtree_from_mesh_get(BVHTreeFromMesh *data,
   return data->tree;
 }
 
+const blender::WideBVHTree *BKE_bvhtree_from_mesh_wide_tree_get(const BVHTreeFromMesh *data,
+                                                                 const Mesh *mesh,
+                                                                 const BVHCacheType bvh_cache_type)
+{
+  BVHCache *bvh_cache = mesh->runtime->bvh_cache;
+  if (!data->cached || data->tree == nullptr || bvh_cache == nullptr) {
+    return nullptr;
+  }
+  BVHCacheItem &item = bvh_cache->items[bvh_cache_type];
+  BLI_assert(item.tree == data->tree);
+  if (item.wide_tree_is_filled) {
+    return item.wide_tree;
+  }
+  BLI_mutex_lock(&bvh_cache->mutex);
+  if (!item.wide_tree_is_filled) {
+    item.wide_tree = blender::WideBVHTree::from_tree(*item.tree).release();
+    item.wide_tree_is_filled = true;
+  }
+  BLI_mutex_unlock(&bvh_cache->mutex);
+  return item.wide_tree;
+}
+
 void BKE_bvhtree_from_mesh_tris_init(const Mesh &mesh,
                                      const blender::IndexMask &faces_mask,
                                      BVHTreeFromMesh &r_data)
@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
@@ -2089,27 +2090,69 @@ static float fcurve_eval_keyframes_extrapolate(const FCurve *fcu,
   return endpoint_bezt->vec[1][1] - (fac * dx);
 }
 
-static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
-                                               const BezTriple *bezts,
-                                               float evaltime)
-{
-  const float eps = 1.e-8f;
-  uint a;
+/**
+ * Threshold for finding the keyframes around the evaluation time.
+ *
+ * The threshold here has the following constraints:
+ * - 0.001 is too coarse:
+ *   We get artifacts with 2cm driver movements at 1BU = 1m (see #40332).
+ *
+ * - 0.00001 is too fine:
+ *   Weird errors, like selecting the wrong keyframe range (see #39207), occur.
+ *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
+ */
+static constexpr float FCURVE_EVAL_KEYFRAME_THRESHOLD = 0.0001f;
 
-  /* Evaluation-time occurs somewhere in the middle of the curve. */
-  bool exact = false;
+/**
+ * Control points of a Bézier segment, with the handles adjusted so that they don't form a loop.
+ * When evaluating many times at once, they are only computed once for every segment.
+ */
+struct FCurveBezierSegment {
+  /** Index of the keyframe at the end of the segment, -1 if not initialized yet. */
+  int end_index = -1;
+  /** All control points have the same value. */
+  bool is_flat;
+  float v1[2], v2[2], v3[2], v4[2];
+};
 
-  /* Use binary search to find appropriate keyframes...
-   *
-   * The threshold here has the following constraints:
-   * - 0.001 is too coarse:
-   *   We get artifacts with 2cm driver movements at 1BU = 1m (see #40332).
-   *
-   * - 0.00001 is too fine:
-   *   Weird errors, like selecting the wrong keyframe range (see #39207), occur.
-   *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
+static void fcurve_bezier_segment_init(const BezTriple *prevbezt,
+                                       const BezTriple *bezt,
+                                       FCurveBezierSegment &r_segment)
+{
+  /* (v1, v2) are the first keyframe and its 2nd handle. */
+  copy_v2_v2(r_segment.v1, prevbezt->vec[1]);
+  copy_v2_v2(r_segment.v2, prevbezt->vec[2]);
+  /* (v3, v4) are the last keyframe's 1st handle + the last keyframe. */
+  copy_v2_v2(r_segment.v3, bezt->vec[0]);
+  copy_v2_v2(r_segment.v4, bezt->vec[1]);
+
+  /* Optimization: If all the handles are flat/at the same values,
+   * the value is simply the shared value (see #40372 -> F91346).
    */
-  a = BKE_fcurve_bezt_binarysearch_index_ex(bezts, evaltime, fcu->totvert, 0.0001, &exact);
+  r_segment.is_flat = fabsf(r_segment.v1[1] - r_segment.v4[1]) < FLT_EPSILON &&
+                      fabsf(r_segment.v2[1] - r_segment.v3[1]) < FLT_EPSILON &&
+                      fabsf(r_segment.v3[1] - r_segment.v4[1]) < FLT_EPSILON;
+  if (!r_segment.is_flat) {
+    /* Adjust handles so that they don't overlap (forming a loop). */
+    BKE_fcurve_correct_bezpart(r_segment.v1, r_segment.v2, r_segment.v3, r_segment.v4);
+  }
+}
+
+/**
+ * Evaluate the segment that ends at the keyframe with index \a a, as found by
+ * #BKE_fcurve_bezt_binarysearch_index_ex.
+ *
+ * \param bezier_segment: Optional storage for the Bézier control points, which are reused when
+ * the same segment is evaluated again.
+ */
+static float fcurve_eval_keyframes_segment(const FCurve *fcu,
+                                           const BezTriple *bezts,
+                                           const int a,
+                                           const bool exact,
+                                           const float evaltime,
+                                           FCurveBezierSegment *bezier_segment)
+{
+  const float eps = 1.e-8f;
   const BezTriple *bezt = bezts + a;
 
   if (exact) {
@@ -2159,45 +2202,35 @@ static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
   switch (prevbezt->ipo) {
     /* Interpolation ...................................... */
     case BEZT_IPO_BEZ: {
-      float v1[2], v2[2], v3[2], v4[2], opl[32];
-
       /* Bezier interpolation. */
-      /* (v1, v2) are the first keyframe and its 2nd handle. */
-      v1[0] = prevbezt->vec[1][0];
-      v1[1] = prevbezt->vec[1][1];
-      v2[0] = prevbezt->vec[2][0];
-      v2[1] = prevbezt->vec[2][1];
-      /* (v3, v4) are the last keyframe's 1st handle + the last keyframe. */
-      v3[0] = bezt->vec[0][0];
-      v3[1] = bezt->vec[0][1];
-      v4[0] = bezt->vec[1][0];
-      v4[1] = bezt->vec[1][1];
-
-      if (fabsf(v1[1] - v4[1]) < FLT_EPSILON && fabsf(v2[1] - v3[1]) < FLT_EPSILON &&
-          fabsf(v3[1] - v4[1]) < FLT_EPSILON)
-      {
-        /* Optimization: If all the handles are flat/at the same values,
-         * the value is simply the shared value (see #40372 -> F91346).
-         */
-        return v1[1];
+      FCurveBezierSegment local_segment;
+      if (bezier_segment == nullptr) {
+        bezier_segment = &local_segment;
+      }
+      if (bezier_segment->end_index != a) {
+        fcurve_bezier_segment_init(prevbezt, bezt, *bezier_segment);
+        bezier_segment->end_index = a;
+      }
+      const FCurveBezierSegment &segment = *bezier_segment;
+      if (segment.is_flat) {
+        return segment.v1[1];
       }
-      /* Adjust handles so that they don't overlap (forming a loop). */
-      BKE_fcurve_correct_bezpart(v1, v2, v3, v4);
 
       /* Try to get a value for this position - if failure, try another set of points. */
-      if (!findzero(evaltime, v1[0], v2[0], v3[0], v4[0], opl)) {
+      float opl[32];
+      if (!findzero(evaltime, segment.v1[0], segment.v2[0], segment.v3[0], segment.v4[0], opl)) {
         if (G.debug & G_DEBUG) {
           printf("    ERROR: findzero() failed at %f with %f %f %f %f\n",
                  evaltime,
-                 v1[0],
-                 v2[0],
-                 v3[0],
-                 v4[0]);
+                 segment.v1[0],
+                 segment.v2[0],
+                 segment.v3[0],
+                 segment.v4[0]);
         }
         return 0.0;
       }
 
-      berekeny(v1[1], v2[1], v3[1], v4[1], opl, 1);
+      berekeny(segment.v1[1], segment.v2[1], segment.v3[1], segment.v4[1], opl, 1);
       return opl[0];
     }
     case BEZT_IPO_LIN:
@@ -2352,6 +2385,19 @@ static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
   return 0.0f;
 }
 
+static float fcurve_eval_keyframes_interpolate(const FCurve *fcu,
+                                               const BezTriple *bezts,
+                                               float evaltime)
+{
+  /* Evaluation-time occurs somewhere in the middle of the curve. */
+  bool exact = false;
+
+  /* Use binary search to find appropriate keyframes. */
+  const int a = BKE_fcurve_bezt_binarysearch_index_ex(
+      bezts, evaltime, fcu->totvert, FCURVE_EVAL_KEYFRAME_THRESHOLD, &exact);
+  return fcurve_eval_keyframes_segment(fcu, bezts, a, exact, evaltime, nullptr);
+}
+
 /* Calculate F-Curve value for 'evaltime' using #BezTriple keyframes. */
 static float fcurve_eval_keyframes(const FCurve *fcu, const BezTriple *bezts, float evaltime)
 {
@@ -2454,6 +2500,69 @@ float evaluate_fcurve(const FCurve *fcu, float evaltime)
   return evaluate_fcurve_ex(fcu, evaltime, 0.0);
 }
 
+void evaluate_fcurve(const FCurve *fcu,
+                     const blender::Span<float> evaltimes,
+                     blender::MutableSpan<float> r_values)
+{
+  BLI_assert(fcu->driver == nullptr);
+  BLI_assert(evaltimes.size() == r_values.size());
+  BLI_assert(std::is_sorted(evaltimes.begin(), evaltimes.end()));
+
+  if (fcu->bezt == nullptr || fcu->totvert == 0 || !BLI_listbase_is_empty(&fcu->modifiers)) {
+    /* Samples don't need a search, and modifiers can change the time the curve is evaluated at,
+     * so the times are not sorted anymore. */
+    for (const int64_t i : evaltimes.index_range()) {
+      r_values[i] = evaluate_fcurve_ex(fcu, evaltimes[i], 0.0f);
+    }
+    return;
+  }
+
+  const BezTriple *bezts = fcu->bezt;
+  const int last_index = fcu->totvert - 1;
+  FCurveBezierSegment bezier_segment;
+  /* Index of the first keyframe that is not before the evaluation time, it only moves forward
+   * because the times are sorted. */
+  int a = 0;
+  for (const int64_t i : evaltimes.index_range()) {
+    const float evaltime = evaltimes[i];
+    float value;
+    if (evaltime <= bezts[0].vec[1][0]) {
+      value = fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, 0, +1);
+    }
+    else if (bezts[last_index].vec[1][0] <= evaltime) {
+      value = fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, last_index, -1);
+    }
+    else {
+      /* Finds the same keyframe as the binary search in #fcurve_eval_keyframes_interpolate. */
+      while (a < last_index && evaltime - bezts[a].vec[1][0] > FCURVE_EVAL_KEYFRAME_THRESHOLD) {
+        a++;
+      }
+      const bool exact = IS_EQT(evaltime, bezts[a].vec[1][0], FCURVE_EVAL_KEYFRAME_THRESHOLD);
+      value = fcurve_eval_keyframes_segment(fcu, bezts, a, exact, evaltime, &bezier_segment);
+    }
+    if (fcu->flag & FCURVE_INT_VALUES) {
+      value = floorf(value + 0.5f);
+    }
+    r_values[i] = value;
+  }
+}
+
+void evaluate_fcurves(const blender::Span<const FCurve *> fcurves,
+                      const blender::Span<float> evaltimes,
+                      blender::MutableSpan<float> r_values)
+{
+  using namespace blender;
+  BLI_assert(r_values.size() == fcurves.size() * evaltimes.size());
+  const int64_t times_num = evaltimes.size();
+  /* Have a few thousand evaluations per task. */
+  const int64_t grain_size = std::max<int64_t>(1, 4096 / std::max<int64_t>(times_num, 1));
+  threading::parallel_for(fcurves.index_range(), grain_size, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      evaluate_fcurve(fcurves[i], evaltimes, r_values.slice(i * times_num, times_num));
+    }
+  });
+}
+
 float evaluate_fcurve_only_curve(const FCurve *fcu, float evaltime)
 {
   /* Can be used to evaluate the (key-framed) f-curve only.
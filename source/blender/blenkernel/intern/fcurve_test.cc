@@ -3,6 +3,8 @@
  * SPDX-License-Identifier: GPL-2.0-or-later */
 #include "testing/testing.h"
 
+#include <algorithm>
+
 #include "MEM_guardedalloc.h"
 
 #include "BKE_fcurve.hh"
@@ -13,7 +15,9 @@
 
 #include "DNA_anim_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_vector.hh"
 
 namespace blender::bke::tests {
 using namespace blender::animrig;
@@ -234,6 +238,70 @@ TEST(evaluate_fcurve, ExtrapolationBezierKeys)
   BKE_fcurve_free(fcu);
 }
 
+TEST(evaluate_fcurve, ManyTimes)
+{
+  FCurve *fcu = BKE_fcurve_create();
+
+  const KeyframeSettings settings = get_keyframe_settings(false);
+  insert_vert_fcurve(fcu, {1.0f, 7.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu, {2.0f, 13.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu, {3.5f, 2.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu, {4.0f, 2.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu, {6.0f, 9.0f}, settings, INSERTKEY_NOFLAGS);
+  fcu->bezt[2].ipo = BEZT_IPO_LIN;
+  fcu->bezt[3].ipo = BEZT_IPO_BOUNCE;
+  fcu->extend = FCURVE_EXTRAPOLATE_LINEAR;
+
+  /* Times before, between and after the keyframes, including times on and very close to them. */
+  Vector<float> times;
+  for (int i = 0; i <= 80; i++) {
+    times.append(i * 0.1f);
+  }
+  times.append(2.0f - 0.00008f);
+  times.append(2.0f + 0.00008f);
+  times.append(4.0f);
+  std::sort(times.begin(), times.end());
+
+  Array<float> values(times.size());
+  evaluate_fcurve(fcu, times, values);
+  for (const int i : times.index_range()) {
+    EXPECT_EQ(values[i], evaluate_fcurve(fcu, times[i])) << "at time " << times[i];
+  }
+
+  fcu->flag |= FCURVE_INT_VALUES;
+  evaluate_fcurve(fcu, times, values);
+  for (const int i : times.index_range()) {
+    EXPECT_EQ(values[i], evaluate_fcurve(fcu, times[i])) << "at time " << times[i];
+  }
+
+  BKE_fcurve_free(fcu);
+}
+
+TEST(evaluate_fcurve, ManyCurves)
+{
+  FCurve *fcu_a = BKE_fcurve_create();
+  FCurve *fcu_b = BKE_fcurve_create();
+
+  const KeyframeSettings settings = get_keyframe_settings(false);
+  insert_vert_fcurve(fcu_a, {1.0f, 7.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu_a, {2.0f, 13.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu_b, {0.0f, -1.0f}, settings, INSERTKEY_NOFLAGS);
+  insert_vert_fcurve(fcu_b, {3.0f, 1.0f}, settings, INSERTKEY_NOFLAGS);
+
+  const Array<float> times = {0.5f, 1.25f, 1.5f, 2.5f};
+  const Array<const FCurve *> fcurves = {fcu_a, fcu_b};
+  Array<float> values(fcurves.size() * times.size());
+  evaluate_fcurves(fcurves, times, values);
+  for (const int curve : fcurves.index_range()) {
+    for (const int i : times.index_range()) {
+      EXPECT_EQ(values[curve * times.size() + i], evaluate_fcurve(fcurves[curve], times[i]));
+    }
+  }
+
+  BKE_fcurve_free(fcu_a);
+  BKE_fcurve_free(fcu_b);
+}
+
 TEST(fcurve_subdivide, BKE_fcurve_bezt_subdivide_handles)
 {
   FCurve *fcu = BKE_fcurve_create();
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <optional>
 
 #include "MEM_guardedalloc.h"
 
@@ -19,9 +20,16 @@
 #include "BLI_array_utils.hh"
 #include "BLI_enumerable_thread_specific.hh"
 #include "BLI_index_range.hh"
+#include "BLI_kdopbvh.h"
+#include "BLI_map.hh"
+#include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_math_vector.hh"
+#include "BLI_offset_indices.hh"
+#include "BLI_ordered_edge.hh"
 #include "BLI_span.hh"
 #include "BLI_task.hh"
+#include "BLI_vector.hh"
 
 #include "BKE_attribute.hh"
 #include "BKE_attribute_math.hh"
@@ -250,6 +258,563 @@ static Mesh *remesh_voxel_volume_to_mesh(const openvdb::FloatGrid::Ptr level_set
 }
 #endif
 
+namespace blender::bke {
+
+/* -------------------------------------------------------------------- */
+/** \name Tiled Voxel Remesh
+ *
+ * The signed distance field of the mesh is evaluated on a regular lattice, but only one tile of
+ * the lattice is stored at a time and only lattice points in a narrow band around the surface are
+ * evaluated. The surface is extracted with surface nets: every cell with a sign change gets one
+ * vertex, and every lattice edge with a sign change creates a quad from the vertices of the four
+ * cells around it.
+ *
+ * Vertices are stored by their global cell index and quads are only created once all tiles are
+ * done, so faces across tile borders use the same vertices and the result is watertight. The
+ * distance at a lattice point only depends on its position, so the cells next to a tile border
+ * don't depend on the tile size either.
+ * \{ */
+
+/** The part of a triangle that is closest to a point. */
+enum class TriFeature : int8_t {
+  Vert0,
+  Vert1,
+  Vert2,
+  Edge01,
+  Edge12,
+  Edge20,
+  Face,
+};
+
+/**
+ * Same as #closest_on_tri_to_point_v3, but also returns the part of the triangle that the closest
+ * point is on. This is necessary to find the correct normal to get the sign of the distance.
+ */
+static float3 closest_point_on_tri(const float3 &p,
+                                   const float3 &a,
+                                   const float3 &b,
+                                   const float3 &c,
+                                   TriFeature &r_feature)
+{
+  const float3 ab = b - a;
+  const float3 ac = c - a;
+  const float3 ap = p - a;
+  const float d1 = math::dot(ab, ap);
+  const float d2 = math::dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f) {
+    r_feature = TriFeature::Vert0;
+    return a;
+  }
+  const float3 bp = p - b;
+  const float d3 = math::dot(ab, bp);
+  const float d4 = math::dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3) {
+    r_feature = TriFeature::Vert1;
+    return b;
+  }
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    r_feature = TriFeature::Edge01;
+    return a + ab * (d1 / (d1 - d3));
+  }
+  const float3 cp = p - c;
+  const float d5 = math::dot(ab, cp);
+  const float d6 = math::dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6) {
+    r_feature = TriFeature::Vert2;
+    return c;
+  }
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    r_feature = TriFeature::Edge20;
+    return a + ac * (d2 / (d2 - d6));
+  }
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+    r_feature = TriFeature::Edge12;
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  const float denom = 1.0f / (va + vb + vc);
+  r_feature = TriFeature::Face;
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/**
+ * The triangles of the input mesh with angle weighted pseudo-normals for their vertices and
+ * edges. The sign of the distance to the closest point on a triangle is given by the normal of
+ * the part of the triangle that the point is on, which is correct for closed meshes.
+ */
+struct RemeshSurface {
+  Span<float3> positions;
+  Span<int3> tris;
+  Array<float3> tri_normals;
+  Array<float3> vert_normals;
+  Map<OrderedEdge, float3> edge_normals;
+  BVHTree *tree = nullptr;
+
+  RemeshSurface(const Span<float3> positions, const Span<int3> tris)
+      : positions(positions), tris(tris), tri_normals(tris.size())
+  {
+    threading::parallel_for(tris.index_range(), 1024, [&](const IndexRange range) {
+      for (const int i : range) {
+        const int3 &tri = tris[i];
+        const float3 &a = positions[tri[0]];
+        const float3 &b = positions[tri[1]];
+        const float3 &c = positions[tri[2]];
+        tri_normals[i] = math::normalize(math::cross(b - a, c - a));
+      }
+    });
+
+    vert_normals.reinitialize(positions.size());
+    vert_normals.fill(float3(0.0f));
+    edge_normals.reserve(tris.size() * 3 / 2);
+    for (const int i : tris.index_range()) {
+      const int3 &tri = tris[i];
+      for (const int corner : IndexRange(3)) {
+        const int vert = tri[corner];
+        const int vert_prev = tri[(corner + 2) % 3];
+        const int vert_next = tri[(corner + 1) % 3];
+        const float angle = angle_v3v3v3(
+            positions[vert_prev], positions[vert], positions[vert_next]);
+        vert_normals[vert] += tri_normals[i] * angle;
+        edge_normals.lookup_or_add(OrderedEdge(vert, vert_next), float3(0.0f)) += tri_normals[i];
+      }
+    }
+
+    tree = BLI_bvhtree_new(tris.size(), 0.0f, 4, 6);
+    for (const int i : tris.index_range()) {
+      const int3 &tri = tris[i];
+      const float3 co[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+      BLI_bvhtree_insert(tree, i, &co[0].x, 3);
+    }
+    BLI_bvhtree_balance(tree);
+  }
+
+  ~RemeshSurface()
+  {
+    BLI_bvhtree_free(tree);
+  }
+
+  static void nearest_callback(void *userdata,
+                               const int index,
+                               const float co[3],
+                               BVHTreeNearest *nearest)
+  {
+    const RemeshSurface &surface = *static_cast<const RemeshSurface *>(userdata);
+    const int3 &tri = surface.tris[index];
+    TriFeature feature;
+    const float3 closest = closest_point_on_tri(co,
+                                                surface.positions[tri[0]],
+                                                surface.positions[tri[1]],
+                                                surface.positions[tri[2]],
+                                                feature);
+    const float dist_sq = math::distance_squared(closest, float3(co));
+    if (dist_sq < nearest->dist_sq) {
+      nearest->index = index;
+      nearest->dist_sq = dist_sq;
+      copy_v3_v3(nearest->co, closest);
+    }
+  }
+
+  /** Whether any triangle is closer to \a position than \a distance. */
+  bool any_tri_in_range(const float3 &position, const float distance) const
+  {
+    BVHTreeNearest nearest;
+    nearest.index = -1;
+    nearest.dist_sq = distance * distance;
+    BLI_bvhtree_find_nearest(
+        tree, position, &nearest, nearest_callback, const_cast<RemeshSurface *>(this));
+    return nearest.index != -1;
+  }
+
+  /**
+   * The signed distance to the surface, which is negative inside of the mesh, or nothing if there
+   * is no triangle closer than \a max_distance.
+   */
+  std::optional<float> signed_distance(const float3 &position, const float max_distance) const
+  {
+    BVHTreeNearest nearest;
+    nearest.index = -1;
+    nearest.dist_sq = max_distance * max_distance;
+    BLI_bvhtree_find_nearest(
+        tree, position, &nearest, nearest_callback, const_cast<RemeshSurface *>(this));
+    if (nearest.index == -1) {
+      return std::nullopt;
+    }
+    const int3 &tri = tris[nearest.index];
+    TriFeature feature;
+    const float3 closest = closest_point_on_tri(
+        position, positions[tri[0]], positions[tri[1]], positions[tri[2]], feature);
+    float3 normal;
+    switch (feature) {
+      case TriFeature::Vert0:
+      case TriFeature::Vert1:
+      case TriFeature::Vert2:
+        normal = vert_normals[tri[int(feature) - int(TriFeature::Vert0)]];
+        break;
+      case TriFeature::Edge01:
+        normal = edge_normals.lookup(OrderedEdge(tri[0], tri[1]));
+        break;
+      case TriFeature::Edge12:
+        normal = edge_normals.lookup(OrderedEdge(tri[1], tri[2]));
+        break;
+      case TriFeature::Edge20:
+        normal = edge_normals.lookup(OrderedEdge(tri[2], tri[0]));
+        break;
+      case TriFeature::Face:
+        normal = tri_normals[nearest.index];
+        break;
+    }
+    const float distance = std::sqrt(nearest.dist_sq);
+    return math::dot(position - closest, normal) < 0.0f ? -distance : distance;
+  }
+};
+
+/** A vertex of the result, with the sign changes on the lattice edges at the cell's minimum. */
+struct RemeshCellVert {
+  int64_t cell;
+  float3 position;
+  /** Bit \a i is set if the edge along axis \a i has a sign change. */
+  uint8_t crossings;
+  /** Bit \a i is set if the minimum corner is inside and the edge along axis \a i leaves it. */
+  uint8_t leaves_inside;
+};
+
+/** A regular lattice of points, cell \a i has the points \a i and \a i + 1 as corners. */
+struct RemeshLattice {
+  float3 origin;
+  float voxel_size;
+  int3 cells_num;
+
+  float3 point_position(const int3 &point) const
+  {
+    return origin + float3(point) * voxel_size;
+  }
+
+  int64_t cell_index(const int3 &cell) const
+  {
+    return cell.x + cells_num.x * (int64_t(cell.y) + int64_t(cells_num.y) * cell.z);
+  }
+
+  int3 cell_from_index(const int64_t index) const
+  {
+    const int64_t xy_num = int64_t(cells_num.x) * cells_num.y;
+    return int3(index % cells_num.x, (index % xy_num) / cells_num.x, index / xy_num);
+  }
+};
+
+/**
+ * Evaluate the distance field for the lattice points of a tile. Points further away from the
+ * surface than \a band are set to NaN. Blocks of points that are entirely outside of the band are
+ * skipped with a single distance query.
+ */
+static void evaluate_tile_distances(const RemeshSurface &surface,
+                                    const RemeshLattice &lattice,
+                                    const int3 &points_start,
+                                    const int3 &points_num,
+                                    const float band,
+                                    const float isovalue,
+                                    MutableSpan<float> r_values)
+{
+  const int block_size = 8;
+  const int3 blocks_num = (points_num + block_size - 1) / block_size;
+  const int64_t blocks_total = int64_t(blocks_num.x) * blocks_num.y * blocks_num.z;
+  threading::parallel_for(IndexRange(blocks_total), 1, [&](const IndexRange range) {
+    for (const int64_t block_index : range) {
+      const int3 block(block_index % blocks_num.x,
+                       (block_index / blocks_num.x) % blocks_num.y,
+                       block_index / (int64_t(blocks_num.x) * blocks_num.y));
+      const int3 begin = block * block_size;
+      const int3 end = math::min(begin + block_size, points_num);
+      const float3 min = lattice.point_position(points_start + begin);
+      const float3 max = lattice.point_position(points_start + end - 1);
+      const bool block_in_band = surface.any_tri_in_range(
+          math::midpoint(min, max), math::distance(min, max) * 0.5f + band);
+      for (int z = begin.z; z < end.z; z++) {
+        for (int y = begin.y; y < end.y; y++) {
+          for (int x = begin.x; x < end.x; x++) {
+            const int64_t i = x + points_num.x * (int64_t(y) + int64_t(points_num.y) * z);
+            if (!block_in_band) {
+              r_values[i] = std::numeric_limits<float>::quiet_NaN();
+              continue;
+            }
+            const float3 position = lattice.point_position(points_start + int3(x, y, z));
+            const std::optional<float> distance = surface.signed_distance(position, band);
+            r_values[i] = distance ? *distance - isovalue :
+                                     std::numeric_limits<float>::quiet_NaN();
+          }
+        }
+      }
+    }
+  });
+}
+
+static const int3 cell_corner_offsets[8] = {
+    {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}};
+static const int2 cell_edge_corners[12] = {{0, 1},
+                                           {2, 3},
+                                           {4, 5},
+                                           {6, 7},
+                                           {0, 2},
+                                           {1, 3},
+                                           {4, 6},
+                                           {5, 7},
+                                           {0, 4},
+                                           {1, 5},
+                                           {2, 6},
+                                           {3, 7}};
+/** The corners at the ends of the edges along each axis, starting at the first corner. */
+static const int cell_axis_corners[3] = {1, 2, 4};
+
+/** Create a vertex for every cell of the tile that has a sign change. */
+static void extract_tile_verts(const RemeshLattice &lattice,
+                               const int3 &cells_start,
+                               const int3 &cells_num,
+                               const Span<float> values,
+                               Vector<RemeshCellVert> &r_verts)
+{
+  /* The values of the tile's lattice points, there is one more point than cells on every axis. */
+  const int3 points_num = cells_num + 1;
+  Array<Vector<RemeshCellVert>> verts_by_slice(cells_num.z);
+  threading::parallel_for(IndexRange(cells_num.z), 1, [&](const IndexRange range) {
+    for (const int z : range) {
+      Vector<RemeshCellVert> &slice_verts = verts_by_slice[z];
+      for (int y = 0; y < cells_num.y; y++) {
+        for (int x = 0; x < cells_num.x; x++) {
+          float corner_values[8];
+          bool all_in_band = true;
+          uint8_t inside_mask = 0;
+          for (const int corner : IndexRange(8)) {
+            const int3 point = int3(x, y, z) + cell_corner_offsets[corner];
+            const int64_t point_index = point.x + points_num.x * (int64_t(point.y) +
+                                                                  int64_t(points_num.y) * point.z);
+            const float value = values[point_index];
+            if (std::isnan(value)) {
+              all_in_band = false;
+              break;
+            }
+            corner_values[corner] = value;
+            if (value < 0.0f) {
+              inside_mask |= uint8_t(1 << corner);
+            }
+          }
+          if (!all_in_band || ELEM(inside_mask, 0, 0xFF)) {
+            continue;
+          }
+
+          const float3 cell_min = lattice.point_position(cells_start + int3(x, y, z));
+          float3 position_sum(0.0f);
+          int crossings_num = 0;
+          for (const int2 &edge : cell_edge_corners) {
+            const float value_a = corner_values[edge[0]];
+            const float value_b = corner_values[edge[1]];
+            if ((value_a < 0.0f) == (value_b < 0.0f)) {
+              continue;
+            }
+            const float factor = value_a / (value_a - value_b);
+            position_sum += math::interpolate(float3(cell_corner_offsets[edge[0]]),
+                                              float3(cell_corner_offsets[edge[1]]),
+                                              factor);
+            crossings_num++;
+          }
+
+          RemeshCellVert vert;
+          vert.cell = lattice.cell_index(cells_start + int3(x, y, z));
+          vert.position = cell_min + position_sum / float(crossings_num) * lattice.voxel_size;
+          vert.crossings = 0;
+          vert.leaves_inside = 0;
+          const bool first_inside = corner_values[0] < 0.0f;
+          for (const int axis : IndexRange(3)) {
+            if (first_inside != (corner_values[cell_axis_corners[axis]] < 0.0f)) {
+              vert.crossings |= uint8_t(1 << axis);
+              if (first_inside) {
+                vert.leaves_inside |= uint8_t(1 << axis);
+              }
+            }
+          }
+          slice_verts.append(vert);
+        }
+      }
+    }
+  });
+  for (const Vector<RemeshCellVert> &slice_verts : verts_by_slice) {
+    r_verts.extend(slice_verts);
+  }
+}
+
+/**
+ * Create a quad for every lattice edge with a sign change. The vertices of the four cells around
+ * the edge are ordered so that the face normal points away from the inside.
+ */
+static void build_quads(const RemeshLattice &lattice,
+                        const Span<RemeshCellVert> verts,
+                        const Map<int64_t, int> &vert_by_cell,
+                        Vector<int> &r_quad_verts)
+{
+  const auto find_quad = [&](const RemeshCellVert &vert, const int axis, int4 &r_quad) {
+    const int3 cell = lattice.cell_from_index(vert.cell);
+    const int axis_b = (axis + 1) % 3;
+    const int axis_c = (axis + 2) % 3;
+    if (cell[axis_b] == 0 || cell[axis_c] == 0) {
+      return false;
+    }
+    int3 cell_b = cell;
+    cell_b[axis_b]--;
+    int3 cell_c = cell;
+    cell_c[axis_c]--;
+    int3 cell_bc = cell_b;
+    cell_bc[axis_c]--;
+    const int *vert_b = vert_by_cell.lookup_ptr(lattice.cell_index(cell_b));
+    const int *vert_bc = vert_by_cell.lookup_ptr(lattice.cell_index(cell_bc));
+    const int *vert_c = vert_by_cell.lookup_ptr(lattice.cell_index(cell_c));
+    if (!vert_b || !vert_bc || !vert_c) {
+      return false;
+    }
+    const int vert_a = vert_by_cell.lookup(vert.cell);
+    if (vert.leaves_inside & (1 << axis)) {
+      r_quad = int4(vert_a, *vert_b, *vert_bc, *vert_c);
+    }
+    else {
+      r_quad = int4(vert_a, *vert_c, *vert_bc, *vert_b);
+    }
+    return true;
+  };
+
+  Array<int> quad_offsets_data(verts.size() + 1);
+  threading::parallel_for(verts.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      int count = 0;
+      for (const int axis : IndexRange(3)) {
+        int4 quad;
+        if (verts[i].crossings & (1 << axis) && find_quad(verts[i], axis, quad)) {
+          count++;
+        }
+      }
+      quad_offsets_data[i] = count;
+    }
+  });
+  const OffsetIndices quad_offsets = offset_indices::accumulate_counts_to_offsets(
+      quad_offsets_data);
+
+  r_quad_verts.resize(quad_offsets.total_size() * 4);
+  threading::parallel_for(verts.index_range(), 1024, [&](const IndexRange range) {
+    for (const int i : range) {
+      int quad_index = quad_offsets[i].start();
+      for (const int axis : IndexRange(3)) {
+        int4 quad;
+        if (verts[i].crossings & (1 << axis) && find_quad(verts[i], axis, quad)) {
+          r_quad_verts.as_mutable_span().slice(quad_index * 4, 4).copy_from(
+              Span<int>(&quad.x, 4));
+          quad_index++;
+        }
+      }
+    }
+  });
+}
+
+static void remesh_voxel_tiled(const Span<float3> positions,
+                               const Span<int3> tris,
+                               const float voxel_size,
+                               const float isovalue,
+                               const int64_t memory_budget,
+                               Vector<RemeshCellVert> &r_verts,
+                               Vector<int> &r_quad_verts)
+{
+  if (tris.is_empty()) {
+    return;
+  }
+  const RemeshSurface surface(positions, tris);
+
+  /* A sign change along a lattice edge means that the surface crosses the edge. Then all corners
+   * of the cells around the edge are closer to the surface than the cell diagonal, so no other
+   * points have to be evaluated. */
+  const float band = std::abs(isovalue) + voxel_size * float(M_SQRT3) * 1.01f;
+
+  float3 min;
+  float3 max;
+  BLI_bvhtree_get_bounding_box(surface.tree, min, max);
+  RemeshLattice lattice;
+  lattice.voxel_size = voxel_size;
+  lattice.origin = math::floor((min - band) / voxel_size - 1.0f) * voxel_size;
+  lattice.cells_num = int3(math::ceil((max + band - lattice.origin) / voxel_size)) + 1;
+
+  /* Only the distances of one tile are stored at a time. */
+  const int tile_size = std::max(
+      int(std::cbrt(double(memory_budget) / double(sizeof(float)))) - 1, 8);
+  const int3 tiles_num = (lattice.cells_num + tile_size - 1) / tile_size;
+  Array<float> values;
+
+  Map<int64_t, int> vert_by_cell;
+  for (int tile_z = 0; tile_z < tiles_num.z; tile_z++) {
+    for (int tile_y = 0; tile_y < tiles_num.y; tile_y++) {
+      for (int tile_x = 0; tile_x < tiles_num.x; tile_x++) {
+        const int3 cells_start = int3(tile_x, tile_y, tile_z) * tile_size;
+        const int3 cells_num = math::min(cells_start + tile_size, lattice.cells_num) -
+                               cells_start;
+        const float3 tile_min = lattice.point_position(cells_start);
+        const float3 tile_max = lattice.point_position(cells_start + cells_num);
+        if (!surface.any_tri_in_range(math::midpoint(tile_min, tile_max),
+                                      math::distance(tile_min, tile_max) * 0.5f + band))
+        {
+          continue;
+        }
+
+        const int3 points_num = cells_num + 1;
+        values.reinitialize(int64_t(points_num.x) * points_num.y * points_num.z);
+        evaluate_tile_distances(
+            surface, lattice, cells_start, points_num, band, isovalue, values);
+
+        const int64_t tile_verts_start = r_verts.size();
+        extract_tile_verts(lattice, cells_start, cells_num, values, r_verts);
+        for (const int64_t i : r_verts.index_range().drop_front(tile_verts_start)) {
+          vert_by_cell.add_new(r_verts[i].cell, int(i));
+        }
+      }
+    }
+  }
+
+  build_quads(lattice, r_verts, vert_by_cell, r_quad_verts);
+}
+
+Mesh *mesh_remesh_voxel_tiled(const Mesh &mesh,
+                              const float voxel_size,
+                              const float isovalue,
+                              const int64_t memory_budget)
+{
+  const Span<int> corner_verts = mesh.corner_verts();
+  const Span<int3> corner_tris = mesh.corner_tris();
+  Array<int3> tris(corner_tris.size());
+  threading::parallel_for(tris.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      const int3 &tri = corner_tris[i];
+      tris[i] = int3(corner_verts[tri[0]], corner_verts[tri[1]], corner_verts[tri[2]]);
+    }
+  });
+
+  Vector<RemeshCellVert> verts;
+  Vector<int> quad_verts;
+  remesh_voxel_tiled(
+      mesh.vert_positions(), tris, voxel_size, isovalue, memory_budget, verts, quad_verts);
+
+  Mesh *result = BKE_mesh_new_nomain(verts.size(), 0, quad_verts.size() / 4, quad_verts.size());
+  MutableSpan<float3> dst_positions = result->vert_positions_for_write();
+  threading::parallel_for(verts.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      dst_positions[i] = verts[i].position;
+    }
+  });
+  if (!quad_verts.is_empty()) {
+    offset_indices::fill_constant_group_size(4, 0, result->face_offsets_for_write());
+  }
+  result->corner_verts_for_write().copy_from(quad_verts);
+  mesh_calc_edges(*result, false, false);
+  return result;
+}
+
+/** \} */
+
+}  // namespace blender::bke
+
 Mesh *BKE_mesh_remesh_voxel(const Mesh *mesh,
                             const float voxel_size,
                             const float adaptivity,
@@ -261,8 +826,12 @@ Mesh *BKE_mesh_remesh_voxel(const Mesh *mesh,
   BKE_mesh_copy_parameters(result, mesh);
   return result;
 #else
-  UNUSED_VARS(mesh, voxel_size, adaptivity, isovalue);
-  return nullptr;
+  /* Adaptivity requires OpenVDB's mesh simplification. */
+  UNUSED_VARS(adaptivity);
+  Mesh *result = blender::bke::mesh_remesh_voxel_tiled(
+      *mesh, voxel_size, isovalue, blender::bke::remesh_voxel_tiled_memory_budget);
+  BKE_mesh_copy_parameters(result, mesh);
+  return result;
 #endif
 }
 
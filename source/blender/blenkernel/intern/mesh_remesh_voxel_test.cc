@@ -0,0 +1,167 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_offset_indices.hh"
+
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_remesh_voxel.hh"
+
+#include "DNA_mesh_types.h"
+
+namespace blender::bke::tests {
+
+class MeshRemeshVoxelTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/** A torus of quads, it has concave and convex parts. */
+static Mesh *create_torus(const float major_radius,
+                          const float minor_radius,
+                          const int major_segments,
+                          const int minor_segments)
+{
+  const int faces_num = major_segments * minor_segments;
+  Mesh *mesh = BKE_mesh_new_nomain(faces_num, 0, faces_num, faces_num * 4);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  offset_indices::fill_constant_group_size(4, 0, mesh->face_offsets_for_write());
+  const auto vert_index = [&](const int i, const int j) {
+    return (i % major_segments) * minor_segments + (j % minor_segments);
+  };
+  for (const int i : IndexRange(major_segments)) {
+    const float u = 2.0f * float(M_PI) * i / major_segments;
+    for (const int j : IndexRange(minor_segments)) {
+      const float v = 2.0f * float(M_PI) * j / minor_segments;
+      const float radius = major_radius + minor_radius * std::cos(v);
+      positions[vert_index(i, j)] = float3(
+          radius * std::cos(u), radius * std::sin(u), minor_radius * std::sin(v));
+
+      const int face = vert_index(i, j);
+      corner_verts[face * 4 + 0] = vert_index(i, j);
+      corner_verts[face * 4 + 1] = vert_index(i + 1, j);
+      corner_verts[face * 4 + 2] = vert_index(i + 1, j + 1);
+      corner_verts[face * 4 + 3] = vert_index(i, j + 1);
+    }
+  }
+  mesh_calc_edges(*mesh, false, false);
+  return mesh;
+}
+
+static float signed_volume(const Mesh &mesh)
+{
+  const Span<float3> positions = mesh.vert_positions();
+  const OffsetIndices faces = mesh.faces();
+  const Span<int> corner_verts = mesh.corner_verts();
+  float volume = 0.0f;
+  for (const int face : faces.index_range()) {
+    const Span<int> verts = corner_verts.slice(faces[face]);
+    for (const int i : verts.index_range().drop_front(1).drop_back(1)) {
+      volume += math::dot(positions[verts[0]],
+                          math::cross(positions[verts[i]], positions[verts[i + 1]])) /
+                6.0f;
+    }
+  }
+  return volume;
+}
+
+/** Every edge has to be used by exactly two faces, in opposite directions. */
+static bool is_watertight(const Mesh &mesh)
+{
+  const Span<int2> edges = mesh.edges();
+  const OffsetIndices faces = mesh.faces();
+  const Span<int> corner_verts = mesh.corner_verts();
+  const Span<int> corner_edges = mesh.corner_edges();
+  Array<int> forward_uses(edges.size(), 0);
+  Array<int> backward_uses(edges.size(), 0);
+  for (const int face : faces.index_range()) {
+    for (const int corner : faces[face]) {
+      const int edge = corner_edges[corner];
+      if (edges[edge][0] == corner_verts[corner]) {
+        forward_uses[edge]++;
+      }
+      else {
+        backward_uses[edge]++;
+      }
+    }
+  }
+  for (const int edge : edges.index_range()) {
+    if (forward_uses[edge] != 1 || backward_uses[edge] != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static Array<float3> sorted_positions(const Mesh &mesh)
+{
+  Array<float3> positions(mesh.vert_positions());
+  std::sort(positions.begin(), positions.end(), [](const float3 &a, const float3 &b) {
+    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+  });
+  return positions;
+}
+
+TEST_F(MeshRemeshVoxelTest, TiledIsWatertight)
+{
+  Mesh *torus = create_torus(1.0f, 0.3f, 48, 24);
+  /* Tiles of 8 cells. */
+  Mesh *result = mesh_remesh_voxel_tiled(*torus, 0.05f, 0.0f, 9 * 9 * 9 * sizeof(float));
+  EXPECT_GT(result->faces_num, 0);
+  EXPECT_TRUE(is_watertight(*result));
+  /* The Euler characteristic of a torus. */
+  EXPECT_EQ(result->verts_num - result->edges_num + result->faces_num, 0);
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, torus);
+}
+
+TEST_F(MeshRemeshVoxelTest, TiledSameForAnyTileSize)
+{
+  Mesh *torus = create_torus(1.0f, 0.3f, 48, 24);
+  Mesh *single_tile = mesh_remesh_voxel_tiled(*torus, 0.05f, 0.0f, int64_t(1) << 40);
+  Mesh *tiled = mesh_remesh_voxel_tiled(*torus, 0.05f, 0.0f, 9 * 9 * 9 * sizeof(float));
+  EXPECT_EQ(single_tile->verts_num, tiled->verts_num);
+  EXPECT_EQ(single_tile->edges_num, tiled->edges_num);
+  EXPECT_EQ(single_tile->faces_num, tiled->faces_num);
+  EXPECT_EQ(sorted_positions(*single_tile).as_span(), sorted_positions(*tiled).as_span());
+  BKE_id_free(nullptr, single_tile);
+  BKE_id_free(nullptr, tiled);
+  BKE_id_free(nullptr, torus);
+}
+
+TEST_F(MeshRemeshVoxelTest, TiledVolume)
+{
+  Mesh *torus = create_torus(1.0f, 0.3f, 48, 24);
+  const float volume = signed_volume(*torus);
+  Mesh *result = mesh_remesh_voxel_tiled(*torus, 0.02f, 0.0f, 64 * 1024);
+  EXPECT_NEAR(signed_volume(*result), volume, volume * 0.02f);
+
+  /* A positive isovalue grows the surface. */
+  Mesh *grown = mesh_remesh_voxel_tiled(*torus, 0.02f, 0.05f, 64 * 1024);
+  EXPECT_GT(signed_volume(*grown), volume * 1.2f);
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, grown);
+  BKE_id_free(nullptr, torus);
+}
+
+TEST_F(MeshRemeshVoxelTest, TiledEmpty)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(3, 0, 0, 0);
+  Mesh *result = mesh_remesh_voxel_tiled(*mesh, 0.1f, 0.0f, 1024 * 1024);
+  EXPECT_EQ(result->verts_num, 0);
+  EXPECT_EQ(result->faces_num, 0);
+  BKE_id_free(nullptr, result);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -74,6 +74,9 @@ struct ShrinkwrapCalcData {
   Object *aux_target;
 
   float keepDist; /* Distance to keep above target surface (units are in local space) */
+
+  /* Nearest target triangle of every vertex from the previous evaluation, or empty. */
+  blender::MutableSpan<int> cached_tri_indices;
 };
 
 struct ShrinkwrapCalcCBData {
@@ -1075,6 +1078,27 @@ void BKE_shrinkwrap_find_nearest_surface(ShrinkwrapTreeData *tree,
   }
 }
 
+/**
+ * Tighten the initial distance of the nearest search with the triangle that was nearest to the
+ * vertex in the previous evaluation. That distance is small if the vertex and the target didn't
+ * move much, so the search can skip most of the tree.
+ */
+static void shrinkwrap_nearest_from_cache(const ShrinkwrapCalcData *calc,
+                                          ShrinkwrapTreeData *tree,
+                                          const int i,
+                                          const float co[3],
+                                          BVHTreeNearest *nearest)
+{
+  if (calc->cached_tri_indices.is_empty()) {
+    return;
+  }
+  BVHTreeFromMesh *treeData = &tree->treeData;
+  const int tri_index = calc->cached_tri_indices[i];
+  if (tri_index >= 0 && tri_index < treeData->corner_tris.size()) {
+    treeData->nearest_callback(treeData, tri_index, co, nearest);
+  }
+}
+
 /**
  * Shrink-wrap moving vertices to the nearest surface point on the target.
  *
@@ -1130,8 +1154,14 @@ static void shrinkwrap_calc_nearest_surface_point_cb_ex(void *__restrict userdat
     nearest->dist_sq = FLT_MAX;
   }
 
+  shrinkwrap_nearest_from_cache(calc, data->tree, i, tmp_co, nearest);
+
   BKE_shrinkwrap_find_nearest_surface(data->tree, nearest, tmp_co, calc->smd->shrinkType);
 
+  if (!calc->cached_tri_indices.is_empty()) {
+    calc->cached_tri_indices[i] = nearest->index;
+  }
+
   /* Found the nearest vertex */
   if (nearest->index != -1) {
     BKE_shrinkwrap_snap_point_to_surface(data->tree,
@@ -1358,7 +1388,8 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
                                const MDeformVert *dvert,
                                const int defgrp_index,
                                float (*vertexCos)[3],
-                               int numVerts)
+                               int numVerts,
+                               blender::bke::shrinkwrap::NearestHitCache **hit_cache)
 {
 
   DerivedMesh *ss_mesh = nullptr;
@@ -1440,6 +1471,18 @@ void shrinkwrapModifier_deform(ShrinkwrapModifierData *smd,
   if (BKE_shrinkwrap_init_tree(&tree, calc.target, smd->shrinkType, smd->shrinkMode, false)) {
     calc.tree = &tree;
 
+    if (hit_cache && smd->shrinkType == MOD_SHRINKWRAP_NEAREST_SURFACE) {
+      if (*hit_cache == nullptr) {
+        *hit_cache = MEM_new<blender::bke::shrinkwrap::NearestHitCache>(__func__);
+      }
+      blender::Array<int> &tri_indices = (*hit_cache)->tri_indices;
+      if (tri_indices.size() != numVerts) {
+        tri_indices.reinitialize(numVerts);
+        tri_indices.fill(-1);
+      }
+      calc.cached_tri_indices = tri_indices;
+    }
+
     switch (smd->shrinkType) {
       case MOD_SHRINKWRAP_NEAREST_SURFACE:
       case MOD_SHRINKWRAP_TARGET_PROJECT:
@@ -59,6 +59,12 @@ FileReader *BLI_filereader_new_memory(const void *data, size_t len) ATTR_WARN_UN
     ATTR_NONNULL();
 /** Create #FileReader from applying `Zstd` decompression on an underlying file. */
 FileReader *BLI_filereader_new_zstd(FileReader *base) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+/**
+ * \param force_read_ahead: Decompress frames of seekable files in advance even when there is only
+ * a single thread, which is skipped otherwise. Used by tests to cover both code paths.
+ */
+FileReader *BLI_filereader_new_zstd_ex(FileReader *base, bool force_read_ahead)
+    ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 /** Create #FileReader from applying `Gzip` decompression on an underlying file. */
 FileReader *BLI_filereader_new_gzip(FileReader *base) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 
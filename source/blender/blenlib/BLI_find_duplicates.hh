@@ -0,0 +1,39 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ */
+
+#include "BLI_index_mask_fwd.hh"
+#include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
+
+namespace blender {
+
+/**
+ * Find positions that are within \a distance of another position with a lower index, e.g. to
+ * merge them. The result is the same as the one of #BLI_kdtree_3d_calc_duplicates_fast with
+ * `use_index_order` enabled: Positions are visited in index order, and every position that has
+ * not been merged yet claims all later positions within the distance that are not merged yet.
+ *
+ * Instead of a kd-tree, the positions are sorted into a uniform grid with cells at least as large
+ * as the distance, so that the search can be done in parallel for the most part.
+ *
+ * Nothing is merged when the distance is not positive, not even positions at the same location.
+ *
+ * \param mask: Only these positions are considered, other elements of \a r_duplicates are not
+ * changed.
+ * \param r_duplicates: Receives the index of the position that each position is merged into,
+ * its own index for positions that other positions are merged into, and -1 otherwise.
+ * \return The number of positions that are merged into another position.
+ */
+int find_duplicates_by_distance(Span<float3> positions,
+                                const IndexMask &mask,
+                                float distance,
+                                MutableSpan<int> r_duplicates);
+
+}  // namespace blender
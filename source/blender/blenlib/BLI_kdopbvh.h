@@ -309,9 +309,41 @@ extern const float bvhtree_kdop_axes[13][3];
 
 #  include "BLI_function_ref.hh"
 #  include "BLI_math_vector.hh"
+#  include "BLI_span.hh"
 
 namespace blender {
 
+class WideBVHTree;
+
+/**
+ * Cast many rays at once. The result of each ray is written to the matching element of
+ * \a r_hits, which has to be initialized like for #BLI_bvhtree_ray_cast (index and maximum
+ * distance). Rays are sorted spatially and processed in parallel, so \a callback has to be
+ * thread-safe.
+ *
+ * \param wide_tree: Optional #WideBVHTree built from \a tree, used for the queries instead.
+ * Building it is linear in the size of the tree, so it should be cached with the tree.
+ */
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                Span<float3> origins,
+                                Span<float3> directions,
+                                float radius,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                MutableSpan<BVHTreeRayHit> r_hits,
+                                const WideBVHTree *wide_tree = nullptr);
+
+/**
+ * Find the nearest element for many positions at once, see #BLI_bvhtree_ray_cast_batch.
+ * \a r_nearest has to be initialized like for #BLI_bvhtree_find_nearest.
+ */
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    Span<float3> positions,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    MutableSpan<BVHTreeNearest> r_nearest,
+                                    const WideBVHTree *wide_tree = nullptr);
+
 using BVHTree_RayCastCallback_CPP =
     FunctionRef<void(int index, const BVHTreeRay &ray, BVHTreeRayHit &hit)>;
 
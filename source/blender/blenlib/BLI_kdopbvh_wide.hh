@@ -0,0 +1,80 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A BVH with 4 children per node, built from an existing #BVHTree.
+ *
+ * The axis aligned bounds of all children of a node are stored next to each other
+ * (structure of arrays), so that ray casts and nearest point searches can test all children
+ * of a node at once with SIMD instructions. Results match the ones of the regular #BVHTree
+ * queries, callbacks are the same too.
+ */
+
+#include <memory>
+
+#include "BLI_kdopbvh.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_utility_mixins.hh"
+#include "BLI_vector.hh"
+
+struct BVHNode;
+
+namespace blender {
+
+class WideBVHTree : NonCopyable, NonMovable {
+ public:
+  static constexpr int width = 4;
+
+  struct Node {
+    /** Bounds of the children, #bounds_min[axis][child]. Unused children have empty bounds. */
+    float bounds_min[3][width];
+    float bounds_max[3][width];
+    /**
+     * Index of the child node, or the leaf index passed to #BLI_bvhtree_insert encoded as
+     * `-(index + 1)` for leaves.
+     */
+    int children[width];
+    int children_num;
+  };
+
+ private:
+  /** The first node is the root. */
+  Vector<Node> nodes_;
+
+ public:
+  /**
+   * Build a wide tree from a balanced #BVHTree. The tree has to use axis aligned bounds
+   * (see the `axis` argument of #BLI_bvhtree_new), otherwise null is returned.
+   */
+  static std::unique_ptr<WideBVHTree> from_tree(const BVHTree &tree);
+
+  Span<Node> nodes() const
+  {
+    return nodes_;
+  }
+
+  /** Same as #BLI_bvhtree_ray_cast_ex. */
+  int ray_cast(const float3 &co,
+               const float3 &dir,
+               float radius,
+               BVHTreeRayHit *hit,
+               BVHTree_RayCastCallback callback,
+               void *userdata,
+               int flag = BVH_RAYCAST_DEFAULT) const;
+
+  /** Same as #BLI_bvhtree_find_nearest. */
+  int find_nearest(const float3 &co,
+                   BVHTreeNearest *nearest,
+                   BVHTree_NearestPointCallback callback,
+                   void *userdata) const;
+
+ private:
+  int build_node(Span<const BVHNode *> items);
+};
+
+}  // namespace blender
@@ -44,6 +44,20 @@ int BLI_kdtree_nd_(find_nearest_n)(const KDTree *tree,
                                    KDTreeNearest *r_nearest,
                                    uint nearest_len_capacity) ATTR_NONNULL(1, 2, 3);
 
+/**
+ * Run #BLI_kdtree_3d_find_nearest_n for many coordinates in parallel.
+ *
+ * \param r_nearest: Results of each search, sized \a co_len * \a nearest_len_capacity.
+ * The results for `co[i]` start at `r_nearest[i * nearest_len_capacity]`.
+ * \param r_nearest_len: The number of points found for each search, sized \a co_len.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          uint nearest_len_capacity,
+                                          int *r_nearest_len) ATTR_NONNULL(1);
+
 int BLI_kdtree_nd_(range_search)(const KDTree *tree,
                                  const float co[KD_DIMS],
                                  KDTreeNearest **r_nearest,
@@ -31,6 +31,8 @@ template<typename Allocator = GuardedAllocator> class LinearAllocator : NonCopya
 
   uintptr_t current_begin_;
   uintptr_t current_end_;
+  /** Summed size of the buffers in #owned_buffers_. */
+  int64_t owned_allocation_size_ = 0;
 
   /* Buffers larger than that are not packed together with smaller allocations to avoid wasting
    * memory. */
@@ -39,7 +41,6 @@ template<typename Allocator = GuardedAllocator> class LinearAllocator : NonCopya
  public:
 #ifdef BLI_DEBUG_LINEAR_ALLOCATOR_SIZE
   int64_t user_requested_size_ = 0;
-  int64_t owned_allocation_size_ = 0;
 #endif
 
   LinearAllocator()
@@ -196,6 +197,15 @@ template<typename Allocator = GuardedAllocator> class LinearAllocator : NonCopya
     return pointers;
   }
 
+  /**
+   * Number of bytes allocated from the system, which may be more than what was requested through
+   * this allocator. Buffers passed into #provide_buffer are not included.
+   */
+  int64_t owned_allocation_size() const
+  {
+    return owned_allocation_size_;
+  }
+
   /**
    * Tell the allocator to use up the given memory buffer, before allocating new memory from the
    * system.
@@ -252,16 +262,16 @@ template<typename Allocator = GuardedAllocator> class LinearAllocator : NonCopya
    * Note that the caller is responsible for making sure that buffers passed into #provide_buffer
    * of `other` live at least as long as this allocator.
    */
-  void transfer_ownership_from(LinearAllocator<> &other)
+  void transfer_ownership_from(LinearAllocator &other)
   {
     owned_buffers_.extend(other.owned_buffers_);
+    owned_allocation_size_ += other.owned_allocation_size_;
 #ifdef BLI_DEBUG_LINEAR_ALLOCATOR_SIZE
     user_requested_size_ += other.user_requested_size_;
-    owned_allocation_size_ += other.owned_allocation_size_;
 #endif
     other.owned_buffers_.clear();
     std::destroy_at(&other);
-    new (&other) LinearAllocator<>();
+    new (&other) LinearAllocator();
   }
 
  private:
@@ -292,9 +302,7 @@ template<typename Allocator = GuardedAllocator> class LinearAllocator : NonCopya
   {
     void *buffer = allocator_.allocate(size, alignment, __func__);
     owned_buffers_.append(buffer);
-#ifdef BLI_DEBUG_LINEAR_ALLOCATOR_SIZE
     owned_allocation_size_ += size;
-#endif
     return buffer;
   }
 };
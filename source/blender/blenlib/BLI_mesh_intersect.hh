@@ -64,6 +64,13 @@ struct Vert {
 
 std::ostream &operator<<(std::ostream &os, const Vert *v);
 
+/**
+ * Same as #orient3d on the exact coordinates of the vertices. The sign is calculated with double
+ * arithmetic first, the exact coordinates are only used when the result is too close to zero to
+ * be sure about it.
+ */
+int orient3d(const Vert *a, const Vert *b, const Vert *c, const Vert *d);
+
 /**
  * A Plane whose equation is `dot(norm, p) + d = 0`.
  * The norm and d fields are always present, but the norm_exact
@@ -32,6 +32,9 @@
 #  endif
 #endif
 
+#include <atomic>
+#include <optional>
+
 #include "BLI_function_ref.hh"
 #include "BLI_index_range.hh"
 #include "BLI_lazy_threading.hh"
@@ -54,8 +57,56 @@ struct GrainSize {
 
 namespace blender::threading {
 
+/**
+ * Location of the code calling #parallel_for, which is used to attribute profiling results to
+ * call sites (see `BLI_task_profile.hh`).
+ */
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#  define BLI_TASK_CALLER_FILE __builtin_FILE()
+#  define BLI_TASK_CALLER_LINE __builtin_LINE()
+#else
+#  define BLI_TASK_CALLER_FILE ""
+#  define BLI_TASK_CALLER_LINE 0
+#endif
+
+namespace detail {
+void parallel_for_impl(IndexRange range,
+                       int64_t grain_size,
+                       FunctionRef<void(IndexRange)> function,
+                       const TaskSizeHints &size_hints);
+void memory_bandwidth_bound_task_impl(FunctionRef<void()> function);
+
+/** True while profiling, see `BLI_task_profile.hh`. */
+extern std::atomic<bool> profiling_enabled;
+void parallel_for_profiled_impl(IndexRange range,
+                                int64_t grain_size,
+                                FunctionRef<void(IndexRange)> function,
+                                const TaskSizeHints &size_hints,
+                                const char *call_site_file,
+                                int call_site_line);
+
+/**
+ * Records one parallel call and the tasks it runs while profiling. The call is recorded when the
+ * object is destructed.
+ */
+class ProfiledCall {
+ private:
+  const char *file_;
+  int line_;
+  int64_t grain_size_;
+  double start_;
+  std::atomic<int64_t> tasks_num_ = 0;
+  std::atomic<int64_t> elements_num_ = 0;
+
+ public:
+  ProfiledCall(const char *file, int line, int64_t grain_size);
+  ~ProfiledCall();
+
+  void run_task(int64_t elements_num, FunctionRef<void()> function);
+};
+
 template<typename Range, typename Function>
-inline void parallel_for_each(Range &&range, const Function &function)
+inline void parallel_for_each_impl(Range &&range, const Function &function)
 {
 #ifdef WITH_TBB
   tbb::parallel_for_each(range, function);
@@ -65,15 +116,24 @@ inline void parallel_for_each(Range &&range, const Function &function)
   }
 #endif
 }
-
-namespace detail {
-void parallel_for_impl(IndexRange range,
-                       int64_t grain_size,
-                       FunctionRef<void(IndexRange)> function,
-                       const TaskSizeHints &size_hints);
-void memory_bandwidth_bound_task_impl(FunctionRef<void()> function);
 }  // namespace detail
 
+template<typename Range, typename Function>
+inline void parallel_for_each(Range &&range,
+                              const Function &function,
+                              const char *call_site_file = BLI_TASK_CALLER_FILE,
+                              const int call_site_line = BLI_TASK_CALLER_LINE)
+{
+  if (UNLIKELY(detail::profiling_enabled.load(std::memory_order_relaxed))) {
+    detail::ProfiledCall call(call_site_file, call_site_line, 1);
+    detail::parallel_for_each_impl(range, [&](auto &&value) {
+      call.run_task(1, [&]() { function(value); });
+    });
+    return;
+  }
+  detail::parallel_for_each_impl(range, function);
+}
+
 /**
  * Executes the given function for sub-ranges of the given range, potentially in parallel.
  * This is the main primitive for parallelizing code.
@@ -90,16 +150,24 @@ void memory_bandwidth_bound_task_impl(FunctionRef<void()> function);
  *   can use `threading::individual_task_sizes(...)` or `threading::accumulated_task_sizes(...)`.
  *   If the grain size is e.g. 200 and each task has the size 100, then only two tasks will be
  *   scheduled at once.
+ * \param call_site_file, call_site_line: Filled in automatically with the location of the caller.
  */
 template<typename Function>
 inline void parallel_for(const IndexRange range,
                          const int64_t grain_size,
                          const Function &function,
-                         const TaskSizeHints &size_hints = detail::TaskSizeHints_Static(1))
+                         const TaskSizeHints &size_hints = detail::TaskSizeHints_Static(1),
+                         const char *call_site_file = BLI_TASK_CALLER_FILE,
+                         const int call_site_line = BLI_TASK_CALLER_LINE)
 {
   if (range.is_empty()) {
     return;
   }
+  if (UNLIKELY(detail::profiling_enabled.load(std::memory_order_relaxed))) {
+    detail::parallel_for_profiled_impl(
+        range, grain_size, function, size_hints, call_site_file, call_site_line);
+    return;
+  }
   /* Invoking tbb for small workloads has a large overhead. */
   if (use_single_thread(size_hints, range, grain_size)) {
     function(range);
@@ -141,20 +209,29 @@ template<typename Function>
 inline void parallel_for_aligned(const IndexRange range,
                                  const int64_t grain_size,
                                  const int64_t alignment,
-                                 const Function &function)
+                                 const Function &function,
+                                 const char *call_site_file = BLI_TASK_CALLER_FILE,
+                                 const int call_site_line = BLI_TASK_CALLER_LINE)
 {
-  parallel_for(range, grain_size, [&](const IndexRange unaligned_range) {
-    const IndexRange aligned_range = align_sub_range(unaligned_range, alignment, range);
-    function(aligned_range);
-  });
+  parallel_for(
+      range,
+      grain_size,
+      [&](const IndexRange unaligned_range) {
+        const IndexRange aligned_range = align_sub_range(unaligned_range, alignment, range);
+        function(aligned_range);
+      },
+      detail::TaskSizeHints_Static(1),
+      call_site_file,
+      call_site_line);
 }
 
+namespace detail {
 template<typename Value, typename Function, typename Reduction>
-inline Value parallel_reduce(IndexRange range,
-                             int64_t grain_size,
-                             const Value &identity,
-                             const Function &function,
-                             const Reduction &reduction)
+inline Value parallel_reduce_impl(const IndexRange range,
+                                  const int64_t grain_size,
+                                  const Value &identity,
+                                  const Function &function,
+                                  const Reduction &reduction)
 {
 #ifdef WITH_TBB
   if (range.size() >= grain_size) {
@@ -172,6 +249,32 @@ inline Value parallel_reduce(IndexRange range,
 #endif
   return function(range, identity);
 }
+}  // namespace detail
+
+template<typename Value, typename Function, typename Reduction>
+inline Value parallel_reduce(IndexRange range,
+                             int64_t grain_size,
+                             const Value &identity,
+                             const Function &function,
+                             const Reduction &reduction,
+                             const char *call_site_file = BLI_TASK_CALLER_FILE,
+                             const int call_site_line = BLI_TASK_CALLER_LINE)
+{
+  if (UNLIKELY(detail::profiling_enabled.load(std::memory_order_relaxed))) {
+    detail::ProfiledCall call(call_site_file, call_site_line, grain_size);
+    return detail::parallel_reduce_impl(
+        range,
+        grain_size,
+        identity,
+        [&](const IndexRange sub_range, const Value &ident) {
+          std::optional<Value> result;
+          call.run_task(sub_range.size(), [&]() { result.emplace(function(sub_range, ident)); });
+          return std::move(*result);
+        },
+        reduction);
+  }
+  return detail::parallel_reduce_impl(range, grain_size, identity, function, reduction);
+}
 
 template<typename Value, typename Function, typename Reduction>
 inline Value parallel_reduce_aligned(const IndexRange range,
@@ -179,7 +282,9 @@ inline Value parallel_reduce_aligned(const IndexRange range,
                                      const int64_t alignment,
                                      const Value &identity,
                                      const Function &function,
-                                     const Reduction &reduction)
+                                     const Reduction &reduction,
+                                     const char *call_site_file = BLI_TASK_CALLER_FILE,
+                                     const int call_site_line = BLI_TASK_CALLER_LINE)
 {
   parallel_reduce(
       range,
@@ -189,7 +294,9 @@ inline Value parallel_reduce_aligned(const IndexRange range,
         const IndexRange aligned_range = align_sub_range(unaligned_range, alignment, range);
         function(aligned_range, ident);
       },
-      reduction);
+      reduction,
+      call_site_file,
+      call_site_line);
 }
 
 /**
@@ -0,0 +1,80 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Opt-in profiling of the tasks executed by the parallel loops in `BLI_task.hh`,
+ * #BLI_task_parallel_range and task pools.
+ *
+ * While profiling is running, every #threading::parallel_for, #threading::parallel_reduce and
+ * #threading::parallel_for_each call and every task it runs is recorded together with the
+ * location of the call. This makes it possible to find call sites with badly chosen grain sizes,
+ * which either create many tiny tasks or leave threads idle because a few large tasks dominate.
+ * When profiling is not running, the only overhead is a relaxed atomic load per call.
+ *
+ * #profile::start and #profile::stop should be called while no tasks are running. The results
+ * can be gathered at any time, also while profiling. Use `--debug-tasks-trace <filepath>` to
+ * profile a whole Blender session.
+ */
+
+#include <iosfwd>
+#include <string>
+
+#include "BLI_function_ref.hh"
+#include "BLI_vector.hh"
+
+namespace blender::threading::profile {
+
+/** Clear previous results and start recording. */
+void start();
+/** Stop recording. The results stay available until profiling is started again. */
+void stop();
+bool is_running();
+
+struct CallSiteStats {
+  /** `file:line` of the #threading::parallel_for call, or the kind of task. */
+  std::string name;
+  int64_t calls_num = 0;
+  int64_t tasks_num = 0;
+  /** Number of elements processed by all calls together. */
+  int64_t elements_num = 0;
+  int64_t grain_size_min = 0;
+  int64_t grain_size_max = 0;
+  /** Summed wall-clock time of the calls in seconds. */
+  double call_time = 0.0;
+  /** Summed and longest duration of the individual tasks. */
+  double task_time = 0.0;
+  double task_time_max = 0.0;
+};
+
+struct ThreadStats {
+  /** Index of the thread in the order in which it first ran a task. */
+  int thread_index = 0;
+  int64_t tasks_num = 0;
+  /** Time spent running tasks, nested tasks are not counted twice. */
+  double busy_time = 0.0;
+  /** Remaining time of the profiling session. */
+  double idle_time = 0.0;
+};
+
+/** Statistics per call site, the most time consuming call sites come first. */
+Vector<CallSiteStats> call_site_stats();
+Vector<ThreadStats> thread_stats();
+
+/**
+ * Write all recorded calls and tasks in the Chrome trace event format, which can be opened in
+ * `chrome://tracing` or Perfetto.
+ */
+void write_chrome_trace(std::ostream &stream);
+bool write_chrome_trace(const char *filepath);
+
+namespace detail {
+/** Record a task that is not part of a #threading::parallel_for call, e.g. from a task pool. */
+void profile_task(const char *name, FunctionRef<void()> function);
+}  // namespace detail
+
+}  // namespace blender::threading::profile
@@ -0,0 +1,139 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A #ThreadLocalArena hands out memory for temporary data that is created by many threads at the
+ * same time, e.g. buffers used while evaluating a modifier in parallel. Every thread allocates
+ * from its own #LinearAllocator, so allocations do not contend on a shared lock and usually don't
+ * reach the system allocator at all. All memory is freed at once when the arena is destructed.
+ *
+ * The buffers of the allocators are allocated with guardedalloc, so they are included in the
+ * global memory statistics and leak detection like any other allocation. They all have the name
+ * "ThreadLocalArena", so with `--debug-memory` the memory used by arenas is listed separately by
+ * #MEM_printmemlist_stats.
+ *
+ * Memory is never reused before the arena is destructed. That fits temporary data that is needed
+ * until the end of an evaluation, but not data that is freed and allocated again repeatedly.
+ *
+ * Example:
+ * \code{.cc}
+ * threading::ThreadLocalArena arena;
+ * threading::parallel_for(range, 256, [&](const IndexRange sub_range) {
+ *   LinearAllocator<> &allocator = arena.local();
+ *   MutableSpan<float3> buffer = allocator.allocate_array<float3>(sub_range.size());
+ *   ...
+ * });
+ * \endcode
+ *
+ * Containers can also allocate from the arena, which is useful when the final size is unknown:
+ * \code{.cc}
+ * Vector<int, 16, threading::ThreadLocalArena::Allocator> indices(arena.allocator());
+ * \endcode
+ * Note that the buffers a container frees when it grows are not reused either, so a #Vector that
+ * grows by appending can use about twice its final size. Reserve the size when it is known.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_linear_allocator.hh"
+
+namespace blender::threading {
+
+class ThreadLocalArena : NonCopyable, NonMovable {
+ public:
+  /** Allocates the buffers of the arena with guardedalloc, using a name specific to arenas. */
+  class BufferAllocator {
+   public:
+    void *allocate(const size_t size, const size_t alignment, const char * /*name*/)
+    {
+      return MEM_mallocN_aligned(size, alignment, "ThreadLocalArena");
+    }
+
+    void deallocate(void *ptr)
+    {
+      MEM_freeN(ptr);
+    }
+  };
+
+  using LocalAllocator = LinearAllocator<BufferAllocator>;
+
+ private:
+  EnumerableThreadSpecific<LocalAllocator> allocators_;
+
+ public:
+  /**
+   * Allocator for containers like #Vector and #Array, which allocates from the allocator of the
+   * thread that does the allocation. Deallocation does nothing, the memory is only freed together
+   * with the arena.
+   */
+  class Allocator {
+   private:
+    ThreadLocalArena *arena_;
+
+   public:
+    Allocator(ThreadLocalArena &arena) : arena_(&arena) {}
+
+    void *allocate(const size_t size, const size_t alignment, const char * /*name*/)
+    {
+      return arena_->allocate(int64_t(size), int64_t(alignment));
+    }
+
+    void deallocate(void * /*ptr*/) {}
+  };
+
+  Allocator allocator()
+  {
+    return Allocator(*this);
+  }
+
+  /**
+   * The allocator of the calling thread. Memory allocated with it stays valid until the arena is
+   * destructed, so it can be passed on to other threads.
+   */
+  LocalAllocator &local()
+  {
+    return allocators_.local();
+  }
+
+  void *allocate(const int64_t size, const int64_t alignment)
+  {
+    return this->local().allocate(size, alignment);
+  }
+
+  template<typename T> MutableSpan<T> allocate_array(const int64_t size)
+  {
+    return this->local().allocate_array<T>(size);
+  }
+
+  /**
+   * Number of bytes allocated by all threads. This must not be called while other threads are
+   * allocating from the arena.
+   */
+  int64_t memory_size()
+  {
+    int64_t size = 0;
+    for (const LocalAllocator &allocator : allocators_) {
+      size += allocator.owned_allocation_size();
+    }
+    return size;
+  }
+
+  /**
+   * Move all memory into the given allocator, so that it stays alive after the arena is
+   * destructed. This must not be called while other threads are allocating from the arena.
+   */
+  void transfer_ownership_to(LocalAllocator &allocator)
+  {
+    for (LocalAllocator &local_allocator : allocators_) {
+      allocator.transfer_ownership_from(local_allocator);
+    }
+  }
+};
+
+}  // namespace blender::threading
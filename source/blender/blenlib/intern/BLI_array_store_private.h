@@ -0,0 +1,49 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Access to internals of #BArrayStore for tests, without exposing them publicly.
+ */
+
+#include "BLI_array_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Whether large arrays are hashed on multiple threads (the default), which must give the same
+ * results as hashing them on a single thread.
+ */
+void BLI_array_store_use_parallel_hash_set(BArrayStore *bs, bool use_parallel_hash);
+
+/**
+ * Calculate the hashes used to find chunks of the reference state in new data, one for each
+ * element of \a data.
+ *
+ * \return False when the store doesn't hash elements individually.
+ */
+bool BLI_array_store_data_hash_get(const BArrayStore *bs,
+                                   const void *data,
+                                   size_t data_len,
+                                   unsigned int *r_hash);
+
+/**
+ * Get the hash key (zero when the chunk is too close to the end of the array to be hashed)
+ * and the number of users of each chunk in \a state.
+ *
+ * \return The number of chunks, the arrays must be freed with #MEM_freeN.
+ */
+size_t BLI_array_store_state_chunks_get_alloc(BArrayStore *bs,
+                                              const BArrayState *state,
+                                              unsigned int **r_keys,
+                                              int **r_users);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/* SPDX-FileCopyrightText: 2006 NaN Holding BV. All rights reserved.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Internal #BVHTree data, shared with other tree layouts built from it
+ * (see #blender::WideBVHTree), without exposing it publicly.
+ */
+
+#include "BLI_kdopbvh.h"
+#include "BLI_utildefines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* used for iterative_raycast */
+// #define USE_SKIP_LINKS
+
+typedef uchar axis_t;
+
+typedef struct BVHNode {
+  struct BVHNode **children;
+  struct BVHNode *parent; /* some user defined traversed need that */
+#ifdef USE_SKIP_LINKS
+  struct BVHNode *skip[2];
+#endif
+  float *bv;      /* Bounding volume of all nodes, max 13 axis */
+  int index;      /* face, edge, vertex index */
+  char node_num;  /* how many nodes are used, used for speedup */
+  char main_axis; /* Axis used to split this node */
+} BVHNode;
+
+/* keep under 26 bytes for speed purposes */
+struct BVHTree {
+  BVHNode **nodes;
+  BVHNode *nodearray;  /* pre-alloc branch nodes */
+  BVHNode **nodechild; /* pre-alloc children for nodes */
+  float *nodebv;       /* pre-alloc bounding-volumes for nodes */
+  float epsilon;       /* Epsilon is used for inflation of the K-DOP. */
+  int leaf_num;        /* leafs */
+  int branch_num;
+  axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
+  axis_t axis;                  /* KDOP type (6 => OBB, 7 => AABB, ...) */
+  char tree_type;               /* type of tree (4 => quad-tree). */
+};
+
+/* optimization, ensure we stay small */
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+                  "over sized")
+
+#ifdef __cplusplus
+}
+#endif
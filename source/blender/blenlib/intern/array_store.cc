@@ -95,10 +95,13 @@
 
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 
 #include "BLI_array_store.h" /* Own include. */
 #include "BLI_ghash.h"       /* Only for #BLI_array_store_is_valid. */
 
+#include "BLI_array_store_private.h"
+
 #include "BLI_strict_flags.h" /* Keep last. */
 
 struct BChunkList;
@@ -165,6 +168,14 @@ struct BChunkList;
  * representing 4,194,303 different combinations.
  */
 #  define BCHUNK_HASH_TABLE_ACCUMULATE_STEPS_8BITS 6
+/**
+ * Hash arrays with at least this many elements on multiple threads.
+ * Each element is hashed independently and every accumulation step only reads values
+ * from the previous step, so splitting the work gives the same result as a single thread.
+ */
+#  define BCHUNK_HASH_PARALLEL_MIN_LEN (1 << 16)
+/** Number of elements each thread hashes at once. */
+#  define BCHUNK_HASH_PARALLEL_SEGMENT_LEN (1 << 14)
 #else
 /**
  * How many items to hash (multiplied by stride).
@@ -257,6 +268,8 @@ struct BArrayInfo {
   size_t accum_steps;
   size_t accum_read_ahead_len;
 #endif
+  /** Hash large arrays on multiple threads, only disabled by tests. */
+  bool use_parallel_hash;
 };
 
 struct BArrayMemory {
@@ -813,10 +826,10 @@ static hash_key hash_data(const uchar *key, size_t n)
 #undef HASH_INIT
 
 #ifdef USE_HASH_TABLE_ACCUMULATE
-static void hash_array_from_data(const BArrayInfo *info,
-                                 const uchar *data_slice,
-                                 const size_t data_slice_len,
-                                 hash_key *hash_array)
+static void hash_array_from_data_serial(const BArrayInfo *info,
+                                        const uchar *data_slice,
+                                        const size_t data_slice_len,
+                                        hash_key *hash_array)
 {
   if (info->chunk_stride != 1) {
     for (size_t i = 0, i_step = 0; i_step < data_slice_len; i++, i_step += info->chunk_stride) {
@@ -831,6 +844,28 @@ static void hash_array_from_data(const BArrayInfo *info,
   }
 }
 
+static void hash_array_from_data(const BArrayInfo *info,
+                                 const uchar *data_slice,
+                                 const size_t data_slice_len,
+                                 hash_key *hash_array)
+{
+  const size_t hash_array_len = data_slice_len / info->chunk_stride;
+  if (!info->use_parallel_hash || hash_array_len < BCHUNK_HASH_PARALLEL_MIN_LEN) {
+    hash_array_from_data_serial(info, data_slice, data_slice_len, hash_array);
+    return;
+  }
+  blender::threading::parallel_for(
+      blender::IndexRange(int64_t(hash_array_len)),
+      BCHUNK_HASH_PARALLEL_SEGMENT_LEN,
+      [&](const blender::IndexRange range) {
+        const size_t i_start = size_t(range.start());
+        hash_array_from_data_serial(info,
+                                    &data_slice[i_start * info->chunk_stride],
+                                    size_t(range.size()) * info->chunk_stride,
+                                    &hash_array[i_start]);
+      });
+}
+
 /**
  * Similar to hash_array_from_data,
  * but able to step into the next chunk if we run-out of data.
@@ -860,15 +895,70 @@ static void hash_array_from_cref(const BArrayInfo *info,
   BLI_assert(i == hash_array_len);
 }
 
-BLI_INLINE void hash_accum_impl(hash_key *hash_array, const size_t i_dst, const size_t i_ahead)
+BLI_INLINE hash_key hash_accum_value(const hash_key dst, const hash_key ahead)
 {
   /* Tested to give good results when accumulating unique values from an array of booleans.
    * (least unused cells in the `BTableRef **table`). */
+  return dst + ((ahead << 3) ^ (dst >> 1));
+}
+
+BLI_INLINE void hash_accum_impl(hash_key *hash_array, const size_t i_dst, const size_t i_ahead)
+{
   BLI_assert(i_dst < i_ahead);
-  hash_array[i_dst] += ((hash_array[i_ahead] << 3) ^ (hash_array[i_dst] >> 1));
+  hash_array[i_dst] = hash_accum_value(hash_array[i_dst], hash_array[i_ahead]);
 }
 
-static void hash_accum(hash_key *hash_array, const size_t hash_array_len, size_t iter_steps)
+/**
+ * Multi-threaded version of #hash_accum, giving identical results.
+ *
+ * Elements are accumulated from the ones that follow them, so each segment first stores a copy
+ * of the values directly after its end, before a neighboring segment modifies them.
+ */
+static void hash_accum_parallel(hash_key *hash_array,
+                                const size_t hash_array_search_len,
+                                size_t iter_steps)
+{
+  const size_t segment_len = BCHUNK_HASH_PARALLEL_SEGMENT_LEN;
+  const size_t segments_num = (hash_array_search_len + segment_len - 1) / segment_len;
+  /* Values following each segment, for the largest offset. */
+  hash_key *segment_tails = static_cast<hash_key *>(
+      MEM_mallocN(sizeof(hash_key) * segments_num * iter_steps, __func__));
+
+  while (iter_steps != 0) {
+    const size_t hash_offset = iter_steps;
+    for (size_t segment = 0; segment < segments_num; segment++) {
+      const size_t i_end = std::min((segment + 1) * segment_len, hash_array_search_len);
+      memcpy(&segment_tails[segment * hash_offset],
+             &hash_array[i_end],
+             sizeof(hash_key) * hash_offset);
+    }
+    blender::threading::parallel_for(
+        blender::IndexRange(int64_t(segments_num)), 1, [&](const blender::IndexRange range) {
+          for (const int64_t segment_index : range) {
+            const size_t segment = size_t(segment_index);
+            const size_t i_start = segment * segment_len;
+            const size_t i_end = std::min(i_start + segment_len, hash_array_search_len);
+            const hash_key *tail = &segment_tails[segment * hash_offset];
+            /* Elements reading values inside this segment, which are not modified yet. */
+            const size_t i_split = std::max(i_start, i_end - std::min(i_end, hash_offset));
+            for (size_t i = i_start; i < i_split; i++) {
+              hash_accum_impl(hash_array, i, i + hash_offset);
+            }
+            for (size_t i = i_split; i < i_end; i++) {
+              hash_array[i] = hash_accum_value(hash_array[i], tail[i + hash_offset - i_end]);
+            }
+          }
+        });
+    iter_steps -= 1;
+  }
+
+  MEM_freeN(segment_tails);
+}
+
+static void hash_accum(const BArrayInfo *info,
+                       hash_key *hash_array,
+                       const size_t hash_array_len,
+                       size_t iter_steps)
 {
   /* _very_ unlikely, can happen if you select a chunk-size of 1 for example. */
   if (UNLIKELY(iter_steps > hash_array_len)) {
@@ -876,6 +966,10 @@ static void hash_accum(hash_key *hash_array, const size_t hash_array_len, size_t
   }
 
   const size_t hash_array_search_len = hash_array_len - iter_steps;
+  if (info->use_parallel_hash && hash_array_search_len >= BCHUNK_HASH_PARALLEL_MIN_LEN) {
+    hash_accum_parallel(hash_array, hash_array_search_len, iter_steps);
+    return;
+  }
   while (iter_steps != 0) {
     const size_t hash_offset = iter_steps;
     for (size_t i = 0; i < hash_array_search_len; i++) {
@@ -1266,7 +1360,7 @@ static BChunkList *bchunk_list_from_data_merge(const BArrayInfo *info,
         MEM_mallocN(sizeof(*table_hash_array) * table_hash_array_len, __func__));
     hash_array_from_data(info, &data[i_prev], data_len - i_prev, table_hash_array);
 
-    hash_accum(table_hash_array, table_hash_array_len, info->accum_steps);
+    hash_accum(info, table_hash_array, table_hash_array_len, info->accum_steps);
 #else
     /* Dummy vars. */
     uint i_table_start = 0;
@@ -1499,6 +1593,7 @@ BArrayStore *BLI_array_store_create(uint stride, uint chunk_count)
   // bs->info.chunk_count = chunk_count;
 
   bs->info.chunk_byte_size = chunk_count * stride;
+  bs->info.use_parallel_hash = true;
 #ifdef USE_MERGE_CHUNKS
   bs->info.chunk_byte_size_min = std::max(1u, chunk_count / BCHUNK_SIZE_MIN_DIV) * stride;
   bs->info.chunk_byte_size_max = (chunk_count * BCHUNK_SIZE_MAX_MUL) * stride;
@@ -1846,4 +1941,68 @@ bool BLI_array_store_is_valid(BArrayStore *bs)
   /* TODO: dangling pointer checks. */
 }
 
+void BLI_array_store_use_parallel_hash_set(BArrayStore *bs, const bool use_parallel_hash)
+{
+  bs->info.use_parallel_hash = use_parallel_hash;
+}
+
+bool BLI_array_store_data_hash_get(const BArrayStore *bs,
+                                   const void *data,
+                                   const size_t data_len,
+                                   uint *r_hash)
+{
+#ifdef USE_HASH_TABLE_ACCUMULATE
+  const BArrayInfo *info = &bs->info;
+  static_assert(sizeof(hash_key) == sizeof(uint));
+  hash_array_from_data(info, static_cast<const uchar *>(data), data_len, r_hash);
+  hash_accum(info, r_hash, data_len / info->chunk_stride, info->accum_steps);
+  return true;
+#else
+  UNUSED_VARS(bs, data, data_len, r_hash);
+  return false;
+#endif
+}
+
+size_t BLI_array_store_state_chunks_get_alloc(BArrayStore *bs,
+                                              const BArrayState *state,
+                                              uint **r_keys,
+                                              int **r_users)
+{
+  const BArrayInfo *info = &bs->info;
+  const BChunkList *chunk_list = state->chunk_list;
+  const size_t chunks_len = chunk_list->chunk_refs_len;
+  uint *keys = static_cast<uint *>(MEM_callocN(sizeof(uint) * chunks_len, __func__));
+  int *users = static_cast<int *>(MEM_mallocN(sizeof(int) * chunks_len, __func__));
+
+#ifdef USE_HASH_TABLE_ACCUMULATE
+  const size_t hash_store_len = info->accum_read_ahead_len;
+  hash_key *hash_store = static_cast<hash_key *>(
+      MEM_mallocN(sizeof(hash_key) * hash_store_len, __func__));
+#endif
+
+  /* Like when building the table, only chunks followed by enough data to read ahead have keys. */
+  size_t bytes_remaining = chunk_list->total_expanded_size;
+  size_t i = 0;
+  LISTBASE_FOREACH (const BChunkRef *, cref, &chunk_list->chunk_refs) {
+    if (bytes_remaining >= info->accum_read_ahead_bytes) {
+#ifdef USE_HASH_TABLE_ACCUMULATE
+      keys[i] = key_from_chunk_ref(info, cref, hash_store, hash_store_len);
+#else
+      keys[i] = key_from_chunk_ref(info, cref);
+#endif
+    }
+    users[i] = cref->link->users;
+    bytes_remaining -= cref->link->data_len;
+    i++;
+  }
+
+#ifdef USE_HASH_TABLE_ACCUMULATE
+  MEM_freeN(hash_store);
+#endif
+
+  *r_keys = keys;
+  *r_users = users;
+  return chunks_len;
+}
+
 /** \} */
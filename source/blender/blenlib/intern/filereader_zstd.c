@@ -11,6 +11,8 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #ifdef __BIG_ENDIAN__
 #  include "BLI_endian_switch.h"
@@ -18,6 +20,34 @@
 
 #include "MEM_guardedalloc.h"
 
+/* Number of frames that are kept decompressed when reading ahead. With the 1 MB frames written by
+ * Blender, this is the uncompressed memory overhead in MB. */
+#define ZSTD_READ_AHEAD_FRAMES 8
+
+typedef enum {
+  ZSTD_SLOT_EMPTY = 0,
+  /* Queued for decompression, but not started yet. */
+  ZSTD_SLOT_PENDING,
+  ZSTD_SLOT_RUNNING,
+  ZSTD_SLOT_DONE,
+} ZstdSlotState;
+
+/* A frame that is decompressed ahead of time on a worker thread. */
+typedef struct {
+  ZstdSlotState state;
+  /* Only accessed from the reading thread, -1 for unused slots. */
+  int frame;
+  /* False when decompression failed, only valid when the state is #ZSTD_SLOT_DONE. */
+  bool ok;
+
+  /* Each slot has its own context, so that slots can be decompressed in parallel. */
+  ZSTD_DCtx *ctx;
+  char *compressed_data;
+  size_t compressed_size, compressed_alloc;
+  char *uncompressed_data;
+  size_t uncompressed_size, uncompressed_alloc;
+} ZstdFrameSlot;
+
 typedef struct {
   FileReader reader;
 
@@ -35,6 +65,16 @@ typedef struct {
     char *cached_content;
     int cached_frame;
   } seek;
+
+  /* Only used for seekable files with multiple frames, when there are worker threads available.
+   * Frame `i` is stored in `slots[i % ZSTD_READ_AHEAD_FRAMES]`. */
+  struct {
+    TaskPool *pool;
+    /* Protects the slot states. */
+    ThreadMutex mutex;
+    ThreadCondition cond;
+    ZstdFrameSlot slots[ZSTD_READ_AHEAD_FRAMES];
+  } read_ahead;
 } ZstdReader;
 
 static bool zstd_read_u32(FileReader *base, uint32_t *val)
@@ -157,9 +197,178 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
+static void zstd_slot_decompress(ZstdFrameSlot *slot)
+{
+  size_t res = ZSTD_decompressDCtx(slot->ctx,
+                                   slot->uncompressed_data,
+                                   slot->uncompressed_size,
+                                   slot->compressed_data,
+                                   slot->compressed_size);
+  slot->ok = !ZSTD_isError(res) && res == slot->uncompressed_size;
+}
+
+static void zstd_read_ahead_task(TaskPool *__restrict pool, void *taskdata)
+{
+  ZstdReader *zstd = BLI_task_pool_user_data(pool);
+  ZstdFrameSlot *slot = taskdata;
+
+  BLI_mutex_lock(&zstd->read_ahead.mutex);
+  if (slot->state != ZSTD_SLOT_PENDING) {
+    /* The reader needed this frame before a worker got to it and decompressed it itself. */
+    BLI_mutex_unlock(&zstd->read_ahead.mutex);
+    return;
+  }
+  slot->state = ZSTD_SLOT_RUNNING;
+  BLI_mutex_unlock(&zstd->read_ahead.mutex);
+
+  zstd_slot_decompress(slot);
+
+  BLI_mutex_lock(&zstd->read_ahead.mutex);
+  slot->state = ZSTD_SLOT_DONE;
+  BLI_condition_notify_all(&zstd->read_ahead.cond);
+  BLI_mutex_unlock(&zstd->read_ahead.mutex);
+}
+
+/* Wait until the slot is not used by a worker thread anymore. A frame that no worker started on
+ * yet is decompressed on the calling thread, so this never depends on worker availability. */
+static void zstd_slot_wait(ZstdReader *zstd, ZstdFrameSlot *slot)
+{
+  BLI_mutex_lock(&zstd->read_ahead.mutex);
+  if (slot->state == ZSTD_SLOT_PENDING) {
+    slot->state = ZSTD_SLOT_RUNNING;
+    BLI_mutex_unlock(&zstd->read_ahead.mutex);
+
+    zstd_slot_decompress(slot);
+
+    BLI_mutex_lock(&zstd->read_ahead.mutex);
+    slot->state = ZSTD_SLOT_DONE;
+  }
+  while (slot->state == ZSTD_SLOT_RUNNING) {
+    BLI_condition_wait(&zstd->read_ahead.cond, &zstd->read_ahead.mutex);
+  }
+  BLI_mutex_unlock(&zstd->read_ahead.mutex);
+}
+
+/* Make the slot available for another frame. A frame that no worker started on yet is not
+ * needed anymore, so it is dropped instead of decompressed. Only a frame that a worker is
+ * decompressing already has to be waited for. */
+static void zstd_slot_release(ZstdReader *zstd, ZstdFrameSlot *slot)
+{
+  BLI_mutex_lock(&zstd->read_ahead.mutex);
+  if (slot->state == ZSTD_SLOT_PENDING) {
+    /* The queued task sees that the slot is not pending anymore and does nothing. */
+    slot->state = ZSTD_SLOT_EMPTY;
+  }
+  while (slot->state == ZSTD_SLOT_RUNNING) {
+    BLI_condition_wait(&zstd->read_ahead.cond, &zstd->read_ahead.mutex);
+  }
+  BLI_mutex_unlock(&zstd->read_ahead.mutex);
+}
+
+/* Read the compressed data of the frame into its slot and queue it for decompression.
+ * The underlying reader is not thread-safe, so this runs on the reading thread. */
+static void zstd_slot_submit(ZstdReader *zstd, int frame)
+{
+  ZstdFrameSlot *slot = &zstd->read_ahead.slots[frame % ZSTD_READ_AHEAD_FRAMES];
+  zstd_slot_release(zstd, slot);
+
+  slot->frame = frame;
+  slot->compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
+  slot->uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                            zstd->seek.uncompressed_ofs[frame];
+  if (slot->compressed_alloc < slot->compressed_size) {
+    MEM_SAFE_FREE(slot->compressed_data);
+    slot->compressed_data = MEM_mallocN(slot->compressed_size, __func__);
+    slot->compressed_alloc = slot->compressed_size;
+  }
+  if (slot->uncompressed_alloc < slot->uncompressed_size) {
+    MEM_SAFE_FREE(slot->uncompressed_data);
+    slot->uncompressed_data = MEM_mallocN(slot->uncompressed_size, __func__);
+    slot->uncompressed_alloc = slot->uncompressed_size;
+  }
+
+  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+      zstd->base->read(zstd->base, slot->compressed_data, slot->compressed_size) <
+          slot->compressed_size)
+  {
+    slot->ok = false;
+    BLI_mutex_lock(&zstd->read_ahead.mutex);
+    slot->state = ZSTD_SLOT_DONE;
+    BLI_mutex_unlock(&zstd->read_ahead.mutex);
+    return;
+  }
+
+  /* Tasks of earlier frames in this slot may still be queued, whichever thread gets to the slot
+   * first decompresses the new frame. */
+  BLI_mutex_lock(&zstd->read_ahead.mutex);
+  slot->state = ZSTD_SLOT_PENDING;
+  BLI_mutex_unlock(&zstd->read_ahead.mutex);
+  BLI_task_pool_push(zstd->read_ahead.pool, zstd_read_ahead_task, slot, false, NULL);
+}
+
+/* Read-ahead version of #zstd_ensure_cache: returns the requested frame and queues the following
+ * frames for decompression on worker threads. The returned data stays valid until the next call,
+ * since the queued frames never share a slot with the requested one. */
+static const char *zstd_ensure_cache_read_ahead(ZstdReader *zstd, int frame)
+{
+  ZstdFrameSlot *slot = &zstd->read_ahead.slots[frame % ZSTD_READ_AHEAD_FRAMES];
+  if (slot->frame != frame) {
+    zstd_slot_submit(zstd, frame);
+  }
+
+  const int last_frame = min_ii(frame + ZSTD_READ_AHEAD_FRAMES - 1, zstd->seek.frames_num - 1);
+  for (int next = frame + 1; next <= last_frame; next++) {
+    ZstdFrameSlot *next_slot = &zstd->read_ahead.slots[next % ZSTD_READ_AHEAD_FRAMES];
+    if (next_slot->frame != next) {
+      zstd_slot_submit(zstd, next);
+    }
+  }
+
+  zstd_slot_wait(zstd, slot);
+  return slot->ok ? slot->uncompressed_data : NULL;
+}
+
+static void zstd_read_ahead_init(ZstdReader *zstd, const bool force_read_ahead)
+{
+  if (zstd->seek.frames_num < 2) {
+    return;
+  }
+  if (BLI_task_scheduler_num_threads() < 2 && !force_read_ahead) {
+    return;
+  }
+  zstd->read_ahead.pool = BLI_task_pool_create(zstd, TASK_PRIORITY_HIGH);
+  BLI_mutex_init(&zstd->read_ahead.mutex);
+  BLI_condition_init(&zstd->read_ahead.cond);
+  for (int i = 0; i < ZSTD_READ_AHEAD_FRAMES; i++) {
+    zstd->read_ahead.slots[i].frame = -1;
+    zstd->read_ahead.slots[i].ctx = ZSTD_createDCtx();
+  }
+}
+
+static void zstd_read_ahead_free(ZstdReader *zstd)
+{
+  if (zstd->read_ahead.pool == NULL) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(zstd->read_ahead.pool);
+  BLI_task_pool_free(zstd->read_ahead.pool);
+  for (int i = 0; i < ZSTD_READ_AHEAD_FRAMES; i++) {
+    ZstdFrameSlot *slot = &zstd->read_ahead.slots[i];
+    ZSTD_freeDCtx(slot->ctx);
+    MEM_SAFE_FREE(slot->compressed_data);
+    MEM_SAFE_FREE(slot->uncompressed_data);
+  }
+  BLI_condition_end(&zstd->read_ahead.cond);
+  BLI_mutex_end(&zstd->read_ahead.mutex);
+}
+
 /* Ensure that the currently loaded frame is the correct one. */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
+  if (zstd->read_ahead.pool) {
+    return zstd_ensure_cache_read_ahead(zstd, frame);
+  }
+
   if (zstd->seek.cached_frame == frame) {
     /* Cached frame matches, so just return it. */
     return zstd->seek.cached_content;
@@ -283,6 +492,7 @@ static void zstd_close(FileReader *reader)
 
   ZSTD_freeDCtx(zstd->ctx);
   if (zstd->reader.seek) {
+    zstd_read_ahead_free(zstd);
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
     /* When an error has occurred this may be NULL, see: #99744. */
@@ -298,7 +508,7 @@ static void zstd_close(FileReader *reader)
   MEM_freeN(zstd);
 }
 
-FileReader *BLI_filereader_new_zstd(FileReader *base)
+FileReader *BLI_filereader_new_zstd_ex(FileReader *base, const bool force_read_ahead)
 {
   ZstdReader *zstd = MEM_callocN(sizeof(ZstdReader), __func__);
 
@@ -308,6 +518,7 @@ FileReader *BLI_filereader_new_zstd(FileReader *base)
   if (zstd_read_seek_table(zstd)) {
     zstd->reader.read = zstd_read_seekable;
     zstd->reader.seek = zstd_seek;
+    zstd_read_ahead_init(zstd, force_read_ahead);
   }
   else {
     zstd->reader.read = zstd_read;
@@ -327,3 +538,8 @@ FileReader *BLI_filereader_new_zstd(FileReader *base)
 
   return (FileReader *)zstd;
 }
+
+FileReader *BLI_filereader_new_zstd(FileReader *base)
+{
+  return BLI_filereader_new_zstd_ex(base, false);
+}
@@ -0,0 +1,238 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "BLI_array.hh"
+#include "BLI_bounds_types.hh"
+#include "BLI_find_duplicates.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_offset_indices.hh"
+#include "BLI_sort.hh"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+namespace blender {
+
+/** Number of bits per axis in the cell codes, so that the code of a cell fits into 64 bits. */
+static constexpr int cell_bits = 20;
+static constexpr int64_t cells_per_axis_max = int64_t(1) << cell_bits;
+
+namespace {
+
+/**
+ * The positions sorted by the code of the cell they are in. Within a cell, positions are sorted
+ * by their index.
+ */
+struct DuplicatesGrid {
+  float3 min;
+  float cell_size_inv;
+  /** The code of every non-empty cell, in ascending order. */
+  Array<uint64_t> cell_codes;
+  /** The range in #sorted_indices of every cell. */
+  Array<int> cell_offsets;
+  Array<int> sorted_indices;
+
+  int3 cell_of(const float3 &position) const
+  {
+    const float3 cell = (position - this->min) * this->cell_size_inv;
+    int3 result;
+    for (int axis = 0; axis < 3; axis++) {
+      /* Non-finite coordinates end up in an arbitrary cell, they are never within the distance
+       * of another position anyway. */
+      const float value = std::isfinite(cell[axis]) ? cell[axis] : 0.0f;
+      result[axis] = int(std::clamp(value, 0.0f, float(cells_per_axis_max - 1)));
+    }
+    return result;
+  }
+
+  static uint64_t cell_code(const int3 &cell)
+  {
+    return (uint64_t(cell.x) << (2 * cell_bits)) | (uint64_t(cell.y) << cell_bits) |
+           uint64_t(cell.z);
+  }
+
+  /** Indices of the positions in the cell, in ascending order. */
+  Span<int> cell_indices(const int3 &cell) const
+  {
+    const uint64_t code = cell_code(cell);
+    const uint64_t *found = std::lower_bound(this->cell_codes.begin(),
+                                             this->cell_codes.end(),
+                                             code);
+    if (found == this->cell_codes.end() || *found != code) {
+      return {};
+    }
+    const OffsetIndices<int> offsets = this->cell_offsets.as_span();
+    return this->sorted_indices.as_span().slice(offsets[found - this->cell_codes.begin()]);
+  }
+
+  /** Call the function for the indices in the cell and all cells adjacent to it. */
+  template<typename Fn> void foreach_neighbor_cell(const int3 &cell, const Fn &fn) const
+  {
+    const int3 begin = math::max(cell - 1, int3(0));
+    const int3 end = math::min(cell + 1, int3(cells_per_axis_max - 1));
+    for (int x = begin.x; x <= end.x; x++) {
+      for (int y = begin.y; y <= end.y; y++) {
+        for (int z = begin.z; z <= end.z; z++) {
+          const Span<int> indices = this->cell_indices(int3(x, y, z));
+          if (!indices.is_empty()) {
+            fn(indices);
+          }
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+static Bounds<float3> finite_bounds(const Span<float3> positions, const IndexMask &mask)
+{
+  const Bounds<float3> init{float3(FLT_MAX), float3(-FLT_MAX)};
+  return threading::parallel_reduce(
+      mask.index_range(),
+      4096,
+      init,
+      [&](const IndexRange range, const Bounds<float3> &init) {
+        Bounds<float3> result = init;
+        mask.slice(range).foreach_index_optimized<int>([&](const int i) {
+          const float3 &position = positions[i];
+          if (std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z))
+          {
+            math::min_max(position, result.min, result.max);
+          }
+        });
+        return result;
+      },
+      [](const Bounds<float3> &a, const Bounds<float3> &b) {
+        return Bounds<float3>{math::min(a.min, b.min), math::max(a.max, b.max)};
+      });
+}
+
+static DuplicatesGrid build_grid(const Span<float3> positions,
+                                 const IndexMask &mask,
+                                 const float distance)
+{
+  DuplicatesGrid grid;
+  const Bounds<float3> bounds = finite_bounds(positions, mask);
+  grid.min = bounds.min;
+  const float extent = std::max(math::reduce_max(bounds.max - bounds.min), 0.0f);
+  /* Cells have to be at least as large as the distance, so that only adjacent cells have to be
+   * searched. The small margin avoids problems with rounding. Larger cells are used when the
+   * distance is too small to fit the bounds into the grid. */
+  float cell_size = std::max(distance * 1.001f, extent / float(cells_per_axis_max - 2));
+  if (!(cell_size > 0.0f) || !std::isfinite(cell_size)) {
+    cell_size = 1.0f;
+  }
+  grid.cell_size_inv = 1.0f / cell_size;
+
+  struct CodeWithIndex {
+    uint64_t code;
+    int index;
+  };
+  Array<CodeWithIndex> sorted(mask.size());
+  mask.foreach_index_optimized<int>(GrainSize(4096), [&](const int i, const int pos) {
+    sorted[pos] = {DuplicatesGrid::cell_code(grid.cell_of(positions[i])), i};
+  });
+  parallel_sort(sorted.begin(), sorted.end(), [](const CodeWithIndex &a, const CodeWithIndex &b) {
+    return a.code < b.code || (a.code == b.code && a.index < b.index);
+  });
+
+  grid.sorted_indices.reinitialize(sorted.size());
+  threading::parallel_for(sorted.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      grid.sorted_indices[i] = sorted[i].index;
+    }
+  });
+
+  Vector<uint64_t> cell_codes;
+  Vector<int> cell_offsets;
+  for (const int64_t i : sorted.index_range()) {
+    if (i == 0 || sorted[i].code != sorted[i - 1].code) {
+      cell_codes.append(sorted[i].code);
+      cell_offsets.append(int(i));
+    }
+  }
+  cell_offsets.append(int(sorted.size()));
+  grid.cell_codes = cell_codes.as_span();
+  grid.cell_offsets = cell_offsets.as_span();
+  return grid;
+}
+
+int find_duplicates_by_distance(const Span<float3> positions,
+                                const IndexMask &mask,
+                                const float distance,
+                                MutableSpan<int> r_duplicates)
+{
+  BLI_assert(positions.size() == r_duplicates.size());
+  if (mask.is_empty() || !(distance > 0.0f)) {
+    /* Like the kd-tree search, nothing is merged without a positive distance. */
+    return 0;
+  }
+  const float distance_sq = distance * distance;
+  const DuplicatesGrid grid = build_grid(positions, mask, distance);
+
+  /* The lowest index of a position within the distance of each position. If that position is not
+   * merged itself, it's the one the position is merged into. */
+  Array<int> first_neighbors(mask.size());
+  mask.foreach_index(GrainSize(1024), [&](const int i, const int pos) {
+    const float3 &position = positions[i];
+    int first_neighbor = -1;
+    grid.foreach_neighbor_cell(grid.cell_of(position), [&](const Span<int> indices) {
+      for (const int other : indices) {
+        if (other >= i || (first_neighbor != -1 && other >= first_neighbor)) {
+          break;
+        }
+        if (math::distance_squared(position, positions[other]) <= distance_sq) {
+          first_neighbor = other;
+          break;
+        }
+      }
+    });
+    first_neighbors[pos] = first_neighbor;
+  });
+
+  /* Whether a position is merged depends on whether the earlier positions are merged, so this is
+   * done in index order. Most positions can be resolved with the result from above, only when the
+   * first neighbor was merged itself, the remaining neighbors have to be searched again. */
+  const auto is_merged = [&](const int i) { return !ELEM(r_duplicates[i], -1, i); };
+  int duplicates_num = 0;
+  mask.foreach_index([&](const int i, const int pos) {
+    int target = first_neighbors[pos];
+    if (target != -1 && is_merged(target)) {
+      target = -1;
+      const float3 &position = positions[i];
+      grid.foreach_neighbor_cell(grid.cell_of(position), [&](const Span<int> indices) {
+        for (const int other : indices) {
+          if (other >= i || (target != -1 && other >= target)) {
+            break;
+          }
+          if (!is_merged(other) &&
+              math::distance_squared(position, positions[other]) <= distance_sq)
+          {
+            target = other;
+            break;
+          }
+        }
+      });
+    }
+    if (target == -1) {
+      r_duplicates[i] = -1;
+      return;
+    }
+    r_duplicates[i] = target;
+    r_duplicates[target] = target;
+    duplicates_num++;
+  });
+  return duplicates_num;
+}
+
+}  // namespace blender
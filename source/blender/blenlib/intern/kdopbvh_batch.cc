@@ -0,0 +1,152 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * Batched BVH queries. Queries are sorted along a Morton curve, so that queries processed by
+ * the same thread after each other visit similar parts of the tree, which keeps the nodes in
+ * the cache. When the caller passes a #WideBVHTree, it is used to test multiple nodes at once.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "BLI_array.hh"
+#include "BLI_bounds.hh"
+#include "BLI_kdopbvh.h"
+#include "BLI_kdopbvh_wide.hh"
+#include "BLI_sort.hh"
+#include "BLI_task.hh"
+
+namespace blender {
+
+/** Batches smaller than this are processed in the given order. */
+static constexpr int64_t batch_sort_min_size = 4096;
+static constexpr int64_t batch_grain_size = 256;
+
+/** Spread the lower 10 bits of the value, so that there are two zero bits between each. */
+static uint32_t morton_expand_bits(uint32_t value)
+{
+  value = (value * 0x00010001u) & 0xFF0000FFu;
+  value = (value * 0x00000101u) & 0x0F00F00Fu;
+  value = (value * 0x00000011u) & 0xC30C30C3u;
+  value = (value * 0x00000005u) & 0x49249249u;
+  return value;
+}
+
+/**
+ * Order of the positions along a 30 bit Morton curve in their bounding box. Returns an empty
+ * array when the batch is too small for sorting to pay off.
+ */
+static Array<int> morton_order(const Span<float3> positions)
+{
+  if (positions.size() < batch_sort_min_size) {
+    return {};
+  }
+  const Bounds<float3> bounds = *bounds::min_max(positions);
+  const float3 size = bounds.max - bounds.min;
+  const float3 scale(size.x > 0.0f ? 1023.0f / size.x : 0.0f,
+                     size.y > 0.0f ? 1023.0f / size.y : 0.0f,
+                     size.z > 0.0f ? 1023.0f / size.z : 0.0f);
+
+  /* Sort the code and the index together, the index in the lower bits keeps the order stable. */
+  Array<uint64_t> keys(positions.size());
+  threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const float3 cell = (positions[i] - bounds.min) * scale;
+      uint32_t code = 0;
+      for (int axis = 0; axis < 3; axis++) {
+        /* Converting NaN to an integer is undefined. Non-finite coordinates end up in the first
+         * cell, which only affects performance. */
+        const float cell_clamped = std::isfinite(cell[axis]) ?
+                                       std::clamp(cell[axis], 0.0f, 1023.0f) :
+                                       0.0f;
+        const uint32_t value = uint32_t(cell_clamped);
+        code |= morton_expand_bits(value) << (2 - axis);
+      }
+      keys[i] = (uint64_t(code) << 32) | uint64_t(i);
+    }
+  });
+  parallel_sort(keys.begin(), keys.end());
+
+  Array<int> order(positions.size());
+  threading::parallel_for(order.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      order[i] = int(keys[i] & 0xFFFFFFFFu);
+    }
+  });
+  return order;
+}
+
+/**
+ * Call the query function for every index in parallel, in Morton order when the batch is large
+ * enough.
+ */
+template<typename Fn>
+static void foreach_query(const Span<float3> positions, const Array<int> &order, const Fn &fn)
+{
+  if (order.is_empty()) {
+    threading::parallel_for(
+        positions.index_range(), batch_grain_size, [&](const IndexRange range) {
+          for (const int64_t i : range) {
+            fn(int(i));
+          }
+        });
+    return;
+  }
+  threading::parallel_for(order.index_range(), batch_grain_size, [&](const IndexRange range) {
+    for (const int i : order.as_span().slice(range)) {
+      fn(i);
+    }
+  });
+}
+
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                const Span<float3> origins,
+                                const Span<float3> directions,
+                                const float radius,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                MutableSpan<BVHTreeRayHit> r_hits,
+                                const WideBVHTree *wide_tree)
+{
+  BLI_assert(origins.size() == directions.size());
+  BLI_assert(origins.size() == r_hits.size());
+
+  const Array<int> order = morton_order(origins);
+
+  foreach_query(origins, order, [&](const int i) {
+    if (wide_tree) {
+      wide_tree->ray_cast(origins[i], directions[i], radius, &r_hits[i], callback, userdata);
+    }
+    else {
+      BLI_bvhtree_ray_cast(
+          &tree, origins[i], directions[i], radius, &r_hits[i], callback, userdata);
+    }
+  });
+}
+
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    const Span<float3> positions,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    MutableSpan<BVHTreeNearest> r_nearest,
+                                    const WideBVHTree *wide_tree)
+{
+  BLI_assert(positions.size() == r_nearest.size());
+
+  const Array<int> order = morton_order(positions);
+
+  foreach_query(positions, order, [&](const int i) {
+    if (wide_tree) {
+      wide_tree->find_nearest(positions[i], &r_nearest[i], callback, userdata);
+    }
+    else {
+      BLI_bvhtree_find_nearest(&tree, positions[i], &r_nearest[i], callback, userdata);
+    }
+  });
+}
+
+}  // namespace blender
@@ -0,0 +1,438 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "BLI_kdopbvh_wide.hh"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_simd.hh"
+
+#include "BLI_kdopbvh_private.h"
+
+namespace blender {
+
+/* -------------------------------------------------------------------- */
+/** \name Construction
+ * \{ */
+
+static float bv_surface_area(const float *bv)
+{
+  const float size[3] = {bv[1] - bv[0], bv[3] - bv[2], bv[5] - bv[4]};
+  return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+std::unique_ptr<WideBVHTree> WideBVHTree::from_tree(const BVHTree &tree)
+{
+  /* The first three k-DOP axes are the X, Y and Z axes. */
+  if (tree.start_axis != 0 || tree.stop_axis < 3) {
+    return nullptr;
+  }
+  for (int i = 0; i < tree.leaf_num; i++) {
+    if (tree.nodes[i]->index < 0) {
+      /* Negative indices can't be stored in the encoded child indices. */
+      return nullptr;
+    }
+  }
+
+  std::unique_ptr<WideBVHTree> wide_tree = std::make_unique<WideBVHTree>();
+  if (tree.leaf_num == 0) {
+    return wide_tree;
+  }
+  BLI_assert_msg(tree.branch_num > 0, "Tree has to be balanced");
+  const BVHNode *root = tree.nodes[tree.leaf_num];
+  wide_tree->nodes_.reserve(tree.branch_num);
+  wide_tree->build_node(Span<const BVHNode *>(root->children, root->node_num));
+  return wide_tree;
+}
+
+int WideBVHTree::build_node(const Span<const BVHNode *> items)
+{
+  BLI_assert(!items.is_empty());
+
+  /* Every child is either a node of the source tree or a group of them. */
+  struct Child {
+    const BVHNode *node = nullptr;
+    Span<const BVHNode *> group;
+  };
+  Vector<Child, width> children;
+
+  if (items.size() > width) {
+    /* Source trees with more children per node are split into groups. */
+    for (const int i : IndexRange(width)) {
+      const int64_t start = items.size() * i / width;
+      const int64_t end = items.size() * (i + 1) / width;
+      const Span<const BVHNode *> group = items.slice(start, end - start);
+      if (group.size() == 1) {
+        children.append({group[0], {}});
+      }
+      else {
+        children.append({nullptr, group});
+      }
+    }
+  }
+  else {
+    for (const BVHNode *item : items) {
+      children.append({item, {}});
+    }
+    /* Collapse the largest child nodes while their children still fit, to reduce the depth. */
+    while (children.size() < width) {
+      int best = -1;
+      float best_area = -1.0f;
+      for (const int i : children.index_range()) {
+        const BVHNode *node = children[i].node;
+        if (node && node->node_num > 0 && children.size() - 1 + node->node_num <= width) {
+          const float area = bv_surface_area(node->bv);
+          if (area > best_area) {
+            best = i;
+            best_area = area;
+          }
+        }
+      }
+      if (best == -1) {
+        break;
+      }
+      const BVHNode *node = children[best].node;
+      Vector<Child, width> children_new;
+      for (const int i : children.index_range()) {
+        if (i == best) {
+          for (const int j : IndexRange(node->node_num)) {
+            children_new.append({node->children[j], {}});
+          }
+        }
+        else {
+          children_new.append(children[i]);
+        }
+      }
+      children = std::move(children_new);
+    }
+  }
+
+  const int node_index = int(nodes_.size());
+  nodes_.append({});
+
+  Node node;
+  for (const int axis : IndexRange(3)) {
+    for (const int i : IndexRange(width)) {
+      node.bounds_min[axis][i] = FLT_MAX;
+      node.bounds_max[axis][i] = -FLT_MAX;
+    }
+  }
+  for (const int i : IndexRange(width)) {
+    node.children[i] = 0;
+  }
+  node.children_num = int(children.size());
+
+  for (const int i : children.index_range()) {
+    const Child &child = children[i];
+    if (child.node) {
+      for (const int axis : IndexRange(3)) {
+        node.bounds_min[axis][i] = child.node->bv[axis * 2];
+        node.bounds_max[axis][i] = child.node->bv[axis * 2 + 1];
+      }
+      if (child.node->node_num == 0) {
+        node.children[i] = -(child.node->index + 1);
+      }
+      else {
+        node.children[i] = this->build_node(
+            Span<const BVHNode *>(child.node->children, child.node->node_num));
+      }
+    }
+    else {
+      for (const BVHNode *item : child.group) {
+        for (const int axis : IndexRange(3)) {
+          node.bounds_min[axis][i] = std::min(node.bounds_min[axis][i], item->bv[axis * 2]);
+          node.bounds_max[axis][i] = std::max(node.bounds_max[axis][i], item->bv[axis * 2 + 1]);
+        }
+      }
+      node.children[i] = this->build_node(child.group);
+    }
+  }
+
+  nodes_[node_index] = node;
+  return node_index;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Traversal
+ * \{ */
+
+namespace {
+
+struct StackItem {
+  /** Index of the node containing the child. */
+  int node;
+  /** Index of the child in the node. */
+  int child;
+  /** Distance to the bounds of the child. */
+  float dist;
+};
+
+using Stack = Vector<StackItem, 64>;
+
+struct RayPrecalc {
+  float origin[3];
+  float idir[3];
+  float radius;
+};
+
+}  // namespace
+
+static int leaf_index_decode(const int child)
+{
+  BLI_assert(child < 0);
+  return -child - 1;
+}
+
+/**
+ * Push the children in \a mask with the closest one last, so it's processed first.
+ */
+static void stack_push_sorted(Stack &stack,
+                              const int node_index,
+                              const int mask,
+                              const float dist[WideBVHTree::width])
+{
+  const int64_t start = stack.size();
+  for (const int i : IndexRange(WideBVHTree::width)) {
+    if ((mask & (1 << i)) == 0) {
+      continue;
+    }
+    stack.append({node_index, i, dist[i]});
+    for (int64_t j = stack.size() - 1; j > start && stack[j - 1].dist < stack[j].dist; j--) {
+      std::swap(stack[j - 1], stack[j]);
+    }
+  }
+}
+
+/**
+ * Intersect the ray with the bounds of all children.
+ * \return A bit mask of the children that are hit before \a hit_dist.
+ */
+static int node_ray_test(const WideBVHTree::Node &node,
+                         const RayPrecalc &ray,
+                         const float hit_dist,
+                         float r_dist[WideBVHTree::width])
+{
+#if BLI_HAVE_SSE2
+  const __m128 radius = _mm_set1_ps(ray.radius);
+  __m128 t_near = _mm_setzero_ps();
+  __m128 t_far = _mm_set1_ps(hit_dist);
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 origin = _mm_set1_ps(ray.origin[axis]);
+    const __m128 idir = _mm_set1_ps(ray.idir[axis]);
+    const __m128 bounds_min = _mm_sub_ps(_mm_loadu_ps(node.bounds_min[axis]), radius);
+    const __m128 bounds_max = _mm_add_ps(_mm_loadu_ps(node.bounds_max[axis]), radius);
+    const __m128 t0 = _mm_mul_ps(_mm_sub_ps(bounds_min, origin), idir);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(bounds_max, origin), idir);
+    t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+    t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+  }
+  _mm_storeu_ps(r_dist, t_near);
+  const int mask = _mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+#else
+  int mask = 0;
+  for (int i = 0; i < WideBVHTree::width; i++) {
+    float t_near = 0.0f;
+    float t_far = hit_dist;
+    for (int axis = 0; axis < 3; axis++) {
+      const float t0 = (node.bounds_min[axis][i] - ray.radius - ray.origin[axis]) *
+                       ray.idir[axis];
+      const float t1 = (node.bounds_max[axis][i] + ray.radius - ray.origin[axis]) *
+                       ray.idir[axis];
+      t_near = std::max(t_near, std::min(t0, t1));
+      t_far = std::min(t_far, std::max(t0, t1));
+    }
+    r_dist[i] = t_near;
+    if (t_near <= t_far) {
+      mask |= 1 << i;
+    }
+  }
+#endif
+  return mask & ((1 << node.children_num) - 1);
+}
+
+/**
+ * Squared distance from \a co to the bounds of all children.
+ * \return A bit mask of the children closer than \a dist_sq_max.
+ */
+static int node_nearest_test(const WideBVHTree::Node &node,
+                             const float co[3],
+                             const float dist_sq_max,
+                             float r_dist_sq[WideBVHTree::width])
+{
+#if BLI_HAVE_SSE2
+  __m128 dist_sq = _mm_setzero_ps();
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 value = _mm_set1_ps(co[axis]);
+    const __m128 below = _mm_sub_ps(_mm_loadu_ps(node.bounds_min[axis]), value);
+    const __m128 above = _mm_sub_ps(value, _mm_loadu_ps(node.bounds_max[axis]));
+    const __m128 dist = _mm_max_ps(_mm_max_ps(below, above), _mm_setzero_ps());
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(dist, dist));
+  }
+  _mm_storeu_ps(r_dist_sq, dist_sq);
+  const int mask = _mm_movemask_ps(_mm_cmplt_ps(dist_sq, _mm_set1_ps(dist_sq_max)));
+#else
+  int mask = 0;
+  for (int i = 0; i < WideBVHTree::width; i++) {
+    float dist_sq = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+      const float dist = std::max(
+          {node.bounds_min[axis][i] - co[axis], co[axis] - node.bounds_max[axis][i], 0.0f});
+      dist_sq += dist * dist;
+    }
+    r_dist_sq[i] = dist_sq;
+    if (dist_sq < dist_sq_max) {
+      mask |= 1 << i;
+    }
+  }
+#endif
+  return mask & ((1 << node.children_num) - 1);
+}
+
+int WideBVHTree::ray_cast(const float3 &co,
+                          const float3 &dir,
+                          const float radius,
+                          BVHTreeRayHit *hit,
+                          BVHTree_RayCastCallback callback,
+                          void *userdata,
+                          const int flag) const
+{
+  BLI_ASSERT_UNIT_V3(dir);
+
+  BVHTreeRay ray;
+  copy_v3_v3(ray.origin, co);
+  copy_v3_v3(ray.direction, dir);
+  ray.radius = radius;
+
+  IsectRayPrecalc isect_precalc;
+  if (flag & BVH_RAYCAST_WATERTIGHT) {
+    isect_ray_tri_watertight_v3_precalc(&isect_precalc, ray.direction);
+    ray.isect_precalc = &isect_precalc;
+  }
+  else {
+    ray.isect_precalc = nullptr;
+  }
+
+  RayPrecalc precalc;
+  copy_v3_v3(precalc.origin, co);
+  precalc.radius = radius;
+  for (int axis = 0; axis < 3; axis++) {
+    /* Match #bvhtree_ray_cast_data_precalc. */
+    precalc.idir[axis] = (std::abs(dir[axis]) < FLT_EPSILON) ? FLT_MAX : 1.0f / dir[axis];
+  }
+
+  BVHTreeRayHit hit_data;
+  if (hit) {
+    hit_data = *hit;
+  }
+  else {
+    hit_data.index = -1;
+    hit_data.dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  if (!nodes_.is_empty()) {
+    Stack stack;
+    int node_index = 0;
+    while (node_index != -1) {
+      float dist[width];
+      const int mask = node_ray_test(nodes_[node_index], precalc, hit_data.dist, dist);
+      stack_push_sorted(stack, node_index, mask, dist);
+
+      node_index = -1;
+      while (!stack.is_empty()) {
+        const StackItem item = stack.pop_last();
+        if (item.dist >= hit_data.dist) {
+          continue;
+        }
+        const int child = nodes_[item.node].children[item.child];
+        if (child >= 0) {
+          node_index = child;
+          break;
+        }
+        if (callback) {
+          callback(userdata, leaf_index_decode(child), &ray, &hit_data);
+        }
+        else {
+          hit_data.index = leaf_index_decode(child);
+          hit_data.dist = item.dist;
+          madd_v3_v3v3fl(hit_data.co, ray.origin, ray.direction, item.dist);
+        }
+      }
+    }
+  }
+
+  if (hit) {
+    *hit = hit_data;
+  }
+  return hit_data.index;
+}
+
+int WideBVHTree::find_nearest(const float3 &co,
+                              BVHTreeNearest *nearest,
+                              BVHTree_NearestPointCallback callback,
+                              void *userdata) const
+{
+  BVHTreeNearest nearest_data;
+  if (nearest) {
+    nearest_data = *nearest;
+  }
+  else {
+    nearest_data.index = -1;
+    nearest_data.dist_sq = FLT_MAX;
+  }
+
+  if (!nodes_.is_empty()) {
+    Stack stack;
+    int node_index = 0;
+    while (node_index != -1) {
+      float dist_sq[width];
+      const int mask = node_nearest_test(nodes_[node_index], co, nearest_data.dist_sq, dist_sq);
+      stack_push_sorted(stack, node_index, mask, dist_sq);
+
+      node_index = -1;
+      while (!stack.is_empty()) {
+        const StackItem item = stack.pop_last();
+        if (item.dist >= nearest_data.dist_sq) {
+          continue;
+        }
+        const Node &node = nodes_[item.node];
+        const int child = node.children[item.child];
+        if (child >= 0) {
+          node_index = child;
+          break;
+        }
+        if (callback) {
+          callback(userdata, leaf_index_decode(child), co, &nearest_data);
+        }
+        else {
+          /* Nearest point on the bounds, like #calc_nearest_point_squared. */
+          nearest_data.index = leaf_index_decode(child);
+          nearest_data.dist_sq = item.dist;
+          for (int axis = 0; axis < 3; axis++) {
+            nearest_data.co[axis] = std::clamp(co[axis],
+                                               node.bounds_min[axis][item.child],
+                                               node.bounds_max[axis][item.child]);
+          }
+        }
+      }
+    }
+  }
+
+  if (nearest) {
+    *nearest = nearest_data;
+  }
+  return nearest_data.index;
+}
+
+/** \} */
+
+}  // namespace blender
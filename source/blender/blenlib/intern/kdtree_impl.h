@@ -10,6 +10,7 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include <string.h>
@@ -48,6 +49,11 @@ struct KDTree {
 #define KD_NEAR_ALLOC_INC 100 /* alloc increment for collecting nearest */
 #define KD_FOUND_ALLOC_INC 50 /* alloc increment for collecting nearest */
 
+/** Balance sub-trees with at least this many nodes in a separate task. */
+#define KD_BALANCE_PARALLEL_MIN_LEN 8192
+/** Minimum number of queries handled by each thread in batch searches. */
+#define KD_BATCH_QUERIES_PER_THREAD 256
+
 #define KD_NODE_UNSET ((uint)-1)
 
 /**
@@ -139,7 +145,23 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+typedef struct KDTreeBalanceTask {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint axis;
+  uint ofs;
+  /** Set to the root of the balanced sub-tree. */
+  uint *r_root;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata);
+
+/**
+ * \param pool: When not null, large sub-trees are balanced in tasks pushed to this pool,
+ * the result is the same as when balancing on a single thread.
+ */
+static uint kdtree_balance(
+    TaskPool *pool, KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
 {
   KDTreeNode *node;
   float co;
@@ -188,13 +210,31 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
+  if (pool && median >= KD_BALANCE_PARALLEL_MIN_LEN) {
+    /* Both halves are independent, balance the left one in another task. */
+    KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+    task->nodes = nodes;
+    task->nodes_len = median;
+    task->axis = axis;
+    task->ofs = ofs;
+    task->r_root = &node->left;
+    BLI_task_pool_push(pool, kdtree_balance_task, task, true, NULL);
+  }
+  else {
+    node->left = kdtree_balance(pool, nodes, median, axis, ofs);
+  }
   node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+      pool, nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
 
   return median + ofs;
 }
 
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const KDTreeBalanceTask *task = taskdata;
+  *task->r_root = kdtree_balance(pool, task->nodes, task->nodes_len, task->axis, task->ofs);
+}
+
 void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
   if (tree->root != KD_NODE_ROOT_IS_INIT) {
@@ -204,7 +244,15 @@ void BLI_kdtree_nd_(balance)(KDTree *tree)
     }
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+  if (tree->nodes_len >= KD_BALANCE_PARALLEL_MIN_LEN * 2) {
+    TaskPool *pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+    tree->root = kdtree_balance(pool, tree->nodes, tree->nodes_len, 0, 0);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    tree->root = kdtree_balance(NULL, tree->nodes, tree->nodes_len, 0, 0);
+  }
 
 #ifndef NDEBUG
   tree->is_balanced = true;
@@ -466,24 +514,26 @@ static void nearest_ordered_insert(KDTreeNearest *nearest,
   copy_vn_vn(nearest[i].co, co);
 }
 
-/**
- * Find \a nearest_len_capacity nearest returns number of points found, with results in nearest.
- *
- * \param r_nearest: An array of nearest, sized at least \a nearest_len_capacity.
- */
-int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
-    const KDTree *tree,
-    const float co[KD_DIMS],
-    KDTreeNearest r_nearest[],
-    const uint nearest_len_capacity,
-    float (*len_sq_fn)(const float co_search[KD_DIMS],
-                       const float co_test[KD_DIMS],
-                       const void *user_data),
-    const void *user_data)
+/** Traversal stack, which can be kept between searches to avoid reallocating it. */
+typedef struct KDTreeStack {
+  uint *data;
+  uint len_capacity;
+  bool is_alloc;
+} KDTreeStack;
+
+static int kdtree_find_nearest_n_impl(const KDTree *tree,
+                                      const float co[KD_DIMS],
+                                      KDTreeNearest r_nearest[],
+                                      const uint nearest_len_capacity,
+                                      float (*len_sq_fn)(const float co_search[KD_DIMS],
+                                                         const float co_test[KD_DIMS],
+                                                         const void *user_data),
+                                      const void *user_data,
+                                      KDTreeStack *r_stack)
 {
   const KDTreeNode *nodes = tree->nodes;
   const KDTreeNode *root;
-  uint *stack, stack_default[KD_STACK_INIT];
+  uint *stack;
   float cur_dist;
   uint stack_len_capacity, cur = 0;
   uint i, nearest_len = 0;
@@ -501,8 +551,9 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     BLI_assert(user_data == NULL);
   }
 
-  stack = stack_default;
-  stack_len_capacity = ARRAY_SIZE(stack_default);
+  stack = r_stack->data;
+  stack_len_capacity = r_stack->len_capacity;
+  BLI_assert(stack_len_capacity >= KD_DIMS);
 
   root = &nodes[tree->root];
 
@@ -570,7 +621,10 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
       }
     }
     if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      stack = realloc_nodes(stack, &stack_len_capacity, r_stack->is_alloc);
+      r_stack->data = stack;
+      r_stack->len_capacity = stack_len_capacity;
+      r_stack->is_alloc = true;
     }
   }
 
@@ -578,13 +632,34 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     r_nearest[i].dist = sqrtf(r_nearest[i].dist);
   }
 
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   return (int)nearest_len;
 }
 
+/**
+ * Find \a nearest_len_capacity nearest returns number of points found, with results in nearest.
+ *
+ * \param r_nearest: An array of nearest, sized at least \a nearest_len_capacity.
+ */
+int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
+    const KDTree *tree,
+    const float co[KD_DIMS],
+    KDTreeNearest r_nearest[],
+    const uint nearest_len_capacity,
+    float (*len_sq_fn)(const float co_search[KD_DIMS],
+                       const float co_test[KD_DIMS],
+                       const void *user_data),
+    const void *user_data)
+{
+  uint stack_default[KD_STACK_INIT];
+  KDTreeStack stack = {stack_default, KD_STACK_INIT, false};
+  const int nearest_len = kdtree_find_nearest_n_impl(
+      tree, co, r_nearest, nearest_len_capacity, len_sq_fn, user_data, &stack);
+  if (stack.is_alloc) {
+    MEM_freeN(stack.data);
+  }
+  return nearest_len;
+}
+
 int BLI_kdtree_nd_(find_nearest_n)(const KDTree *tree,
                                    const float co[KD_DIMS],
                                    KDTreeNearest r_nearest[],
@@ -594,6 +669,71 @@ int BLI_kdtree_nd_(find_nearest_n)(const KDTree *tree,
       tree, co, r_nearest, nearest_len_capacity, NULL, NULL);
 }
 
+typedef struct KDTreeFindNearestNBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  KDTreeNearest *r_nearest;
+  uint nearest_len_capacity;
+  int *r_nearest_len;
+} KDTreeFindNearestNBatchData;
+
+static void kdtree_find_nearest_n_batch_fn(void *__restrict userdata,
+                                           const int iter,
+                                           const TaskParallelTLS *__restrict tls)
+{
+  const KDTreeFindNearestNBatchData *data = userdata;
+  KDTreeStack *stack = tls->userdata_chunk;
+  if (stack->data == NULL) {
+    stack->data = MEM_mallocN(sizeof(uint) * KD_STACK_INIT, "KDTree.treestack");
+    stack->len_capacity = KD_STACK_INIT;
+    stack->is_alloc = true;
+  }
+  const size_t offset = (size_t)iter * data->nearest_len_capacity;
+  const int nearest_len = kdtree_find_nearest_n_impl(data->tree,
+                                                     data->co[iter],
+                                                     &data->r_nearest[offset],
+                                                     data->nearest_len_capacity,
+                                                     len_squared_vnvn_cb,
+                                                     NULL,
+                                                     stack);
+  data->r_nearest_len[iter] = nearest_len;
+}
+
+static void kdtree_find_nearest_n_batch_free(const void *__restrict UNUSED(userdata),
+                                             void *__restrict chunk)
+{
+  KDTreeStack *stack = chunk;
+  if (stack->is_alloc) {
+    MEM_freeN(stack->data);
+  }
+}
+
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          const uint nearest_len_capacity,
+                                          int *r_nearest_len)
+{
+  KDTreeFindNearestNBatchData data = {
+      tree,
+      co,
+      r_nearest,
+      nearest_len_capacity,
+      r_nearest_len,
+  };
+  /* Each thread gets its own traversal stack, allocated on first use. */
+  KDTreeStack stack = {NULL, 0, false};
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = KD_BATCH_QUERIES_PER_THREAD;
+  settings.userdata_chunk = &stack;
+  settings.userdata_chunk_size = sizeof(stack);
+  settings.func_free = kdtree_find_nearest_n_batch_free;
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_n_batch_fn, &settings);
+}
+
 static int nearest_cmp_dist(const void *a, const void *b)
 {
   const KDTreeNearest *kda = a;
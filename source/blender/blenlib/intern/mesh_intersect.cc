@@ -22,6 +22,7 @@
 #  include "BLI_hash.hh"
 #  include "BLI_kdopbvh.h"
 #  include "BLI_map.hh"
+#  include "BLI_math_boolean.hh"
 #  include "BLI_math_geom.h"
 #  include "BLI_math_matrix.h"
 #  include "BLI_math_mpq.hh"
@@ -1123,6 +1124,37 @@ static int filter_plane_side(const double3 &p,
   return 0;
 }
 
+/**
+ * The index of #orient3d on inputs with index 1: the differences of the inputs have index 2, the
+ * 2x2 determinants index 6 and the final sum of products index 11.
+ */
+constexpr int index_orient3d = 11;
+
+int orient3d(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
+{
+  const double3 ad = a->co - d->co;
+  const double3 bd = b->co - d->co;
+  const double3 cd = c->co - d->co;
+  const double det = ad.z * (bd.x * cd.y - cd.x * bd.y) + bd.z * (cd.x * ad.y - ad.x * cd.y) +
+                     cd.z * (ad.x * bd.y - bd.x * ad.y);
+
+  const double3 abs_d = math::abs(d->co);
+  const double3 sup_ad = math::abs(a->co) + abs_d;
+  const double3 sup_bd = math::abs(b->co) + abs_d;
+  const double3 sup_cd = math::abs(c->co) + abs_d;
+  const double supremum = sup_ad.z * (sup_bd.x * sup_cd.y + sup_cd.x * sup_bd.y) +
+                          sup_bd.z * (sup_cd.x * sup_ad.y + sup_ad.x * sup_cd.y) +
+                          sup_cd.z * (sup_ad.x * sup_bd.y + sup_bd.x * sup_ad.y);
+  const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+  if (det > err_bound) {
+    return 1;
+  }
+  if (det < -err_bound) {
+    return -1;
+  }
+  return blender::orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+}
+
 /*
  * #intersect_tri_tri and helper functions.
  * This code uses the algorithm of Guigue and Devillers, as described
@@ -2773,15 +2805,23 @@ static CoplanarClusterInfo find_clusters(const IMesh &tm,
   /* There can be more than one #CoplanarCluster per plane. Accumulate them in
    * a Vector. We will have to merge some elements of the Vector as we discover
    * triangles that form intersection bridges between two or more clusters. */
+  /* Use a canonical version of the plane for map index.
+   * We can't just store the canonical version in the face
+   * since canonicalizing loses the orientation of the normal.
+   * This needs exact arithmetic, so it is done in parallel before building the clusters. */
+  Array<Plane> canonical_planes(maybe_coplanar_tris.size());
+  threading::parallel_for(maybe_coplanar_tris.index_range(), 1024, [&](IndexRange range) {
+    for (int i : range) {
+      canonical_planes[i] = *tm.face(maybe_coplanar_tris[i])->plane;
+      BLI_assert(canonical_planes[i].exact_populated());
+      canonical_planes[i].make_canonical();
+    }
+  });
   Map<Plane, Vector<CoplanarCluster>> plane_cls;
   plane_cls.reserve(maybe_coplanar_tris.size());
-  for (int t : maybe_coplanar_tris) {
-    /* Use a canonical version of the plane for map index.
-     * We can't just store the canonical version in the face
-     * since canonicalizing loses the orientation of the normal. */
-    Plane tplane = *tm.face(t)->plane;
-    BLI_assert(tplane.exact_populated());
-    tplane.make_canonical();
+  for (int i : maybe_coplanar_tris.index_range()) {
+    const int t = maybe_coplanar_tris[i];
+    const Plane &tplane = canonical_planes[i];
     if (dbg_level > 0) {
       std::cout << "plane for tri " << t << " = " << &tplane << "\n";
     }
@@ -3025,10 +3065,20 @@ IMesh trimesh_nary_intersect(const IMesh &tm_in,
   std::cout << "subdivided non-cluster tris found, time = " << subdivided_tris_time - itt_time
             << "\n";
 #  endif
+  /* Clusters are independent of each other, but their sizes vary a lot, so the work is
+   * distributed based on the number of triangles in each. */
   Array<CDT_data> cluster_subdivided(clinfo.tot_cluster());
-  for (int c : clinfo.index_range()) {
-    cluster_subdivided[c] = calc_cluster_subdivided(clinfo, c, *tm_clean, tri_ov, itt_map, arena);
-  }
+  threading::parallel_for(
+      clinfo.index_range(),
+      256,
+      [&](IndexRange range) {
+        for (int c : range) {
+          cluster_subdivided[c] = calc_cluster_subdivided(
+              clinfo, c, *tm_clean, tri_ov, itt_map, arena);
+        }
+      },
+      threading::individual_task_sizes(
+          [&](const int64_t c) { return int64_t(clinfo.cluster(c).tot_tri()); }));
 #  ifdef PERFDEBUG
   double cluster_subdivide_time = BLI_time_now_seconds();
   std::cout << "subdivided clusters found, time = "
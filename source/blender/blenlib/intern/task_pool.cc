@@ -18,6 +18,8 @@
 
 #include "BLI_mempool.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
+#include "BLI_task_profile.hh"
 #include "BLI_threads.h"
 
 #ifdef WITH_TBB
@@ -168,6 +170,11 @@ struct TaskPool {
 /* Execute task. */
 void Task::operator()() const
 {
+  if (UNLIKELY(blender::threading::detail::profiling_enabled.load(std::memory_order_relaxed))) {
+    blender::threading::profile::detail::profile_task("task_pool",
+                                                      [&]() { run(pool, taskdata); });
+    return;
+  }
   run(pool, taskdata);
 }
 
@@ -0,0 +1,345 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * Recording of #threading::parallel_for calls and their tasks, see `BLI_task_profile.hh`.
+ *
+ * Every thread appends events to its own buffer. The buffer is protected by a mutex that is
+ * only contended while the statistics are gathered, so that results can be read while tasks are
+ * still running.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+#include "BLI_fileops.hh"
+#include "BLI_map.hh"
+#include "BLI_path_util.h"
+#include "BLI_task.hh"
+#include "BLI_task_profile.hh"
+#include "BLI_time.h"
+
+namespace blender::threading {
+
+namespace detail {
+std::atomic<bool> profiling_enabled = false;
+}
+
+namespace profile {
+
+enum class EventType : int8_t {
+  Call,
+  Task,
+};
+
+struct Event {
+  EventType type;
+  /** The task does not run nested in another task on the same thread. */
+  bool is_outer;
+  int line;
+  const char *file;
+  double start;
+  double end;
+  int64_t size;
+  int64_t grain_size;
+  int64_t tasks_num;
+};
+
+struct ThreadData {
+  int index = 0;
+  /** Number of tasks currently running on this thread, larger than one for nested tasks. */
+  int depth = 0;
+  /** Protects #events, which are read by other threads when gathering the results. */
+  std::mutex mutex;
+  Vector<Event, 0> events;
+
+  void append(const Event &event)
+  {
+    std::lock_guard lock{this->mutex};
+    this->events.append(event);
+  }
+
+  Vector<Event, 0> events_copy()
+  {
+    std::lock_guard lock{this->mutex};
+    return this->events;
+  }
+};
+
+struct Profile {
+  std::mutex mutex;
+  Vector<std::unique_ptr<ThreadData>> threads;
+  double start_time = 0.0;
+  double end_time = 0.0;
+};
+
+static Profile &get_profile()
+{
+  static Profile profile;
+  return profile;
+}
+
+static ThreadData &get_thread_data()
+{
+  thread_local ThreadData *data = nullptr;
+  if (data == nullptr) {
+    Profile &profile = get_profile();
+    std::lock_guard lock{profile.mutex};
+    profile.threads.append(std::make_unique<ThreadData>());
+    data = profile.threads.last().get();
+    data->index = int(profile.threads.size()) - 1;
+  }
+  return *data;
+}
+
+template<typename Fn>
+static void run_task(const char *file, const int line, const int64_t size, const Fn &fn)
+{
+  ThreadData &data = get_thread_data();
+  const bool is_outer = data.depth == 0;
+  data.depth++;
+  const double start = BLI_time_now_seconds();
+  fn();
+  const double end = BLI_time_now_seconds();
+  data.depth--;
+  data.append({EventType::Task, is_outer, line, file, start, end, size, 0, 0});
+}
+
+void start()
+{
+  Profile &profile = get_profile();
+  std::lock_guard lock{profile.mutex};
+  for (std::unique_ptr<ThreadData> &data : profile.threads) {
+    std::lock_guard data_lock{data->mutex};
+    data->events.clear();
+  }
+  profile.start_time = BLI_time_now_seconds();
+  profile.end_time = 0.0;
+  threading::detail::profiling_enabled.store(true);
+}
+
+void stop()
+{
+  threading::detail::profiling_enabled.store(false);
+  get_profile().end_time = BLI_time_now_seconds();
+}
+
+bool is_running()
+{
+  return threading::detail::profiling_enabled.load(std::memory_order_relaxed);
+}
+
+static double session_duration()
+{
+  const Profile &profile = get_profile();
+  const double end_time = is_running() ? BLI_time_now_seconds() : profile.end_time;
+  return end_time - profile.start_time;
+}
+
+static std::string call_site_name(const Event &event)
+{
+  if (event.line == 0) {
+    /* Compilers without support for the caller location, or tasks from other sources. */
+    return event.file[0] == '\0' ? "parallel_for" : event.file;
+  }
+  return std::string(BLI_path_basename(event.file)) + ":" + std::to_string(event.line);
+}
+
+Vector<CallSiteStats> call_site_stats()
+{
+  Profile &profile = get_profile();
+  std::lock_guard lock{profile.mutex};
+
+  Map<std::string, CallSiteStats> stats_by_name;
+  for (const std::unique_ptr<ThreadData> &data : profile.threads) {
+    for (const Event &event : data->events_copy()) {
+      const std::string name = call_site_name(event);
+      CallSiteStats &stats = stats_by_name.lookup_or_add_cb(name, [&]() {
+        CallSiteStats stats;
+        stats.name = name;
+        stats.grain_size_min = INT64_MAX;
+        return stats;
+      });
+      const double duration = event.end - event.start;
+      if (event.type == EventType::Call) {
+        stats.calls_num++;
+        stats.elements_num += event.size;
+        stats.grain_size_min = std::min(stats.grain_size_min, event.grain_size);
+        stats.grain_size_max = std::max(stats.grain_size_max, event.grain_size);
+        stats.call_time += duration;
+      }
+      else {
+        stats.tasks_num++;
+        stats.task_time += duration;
+        stats.task_time_max = std::max(stats.task_time_max, duration);
+      }
+    }
+  }
+
+  Vector<CallSiteStats> result;
+  for (CallSiteStats &stats : stats_by_name.values()) {
+    if (stats.calls_num == 0) {
+      /* Tasks that are not part of a call, e.g. from task pools. */
+      stats.grain_size_min = 0;
+      stats.call_time = stats.task_time;
+    }
+    result.append(std::move(stats));
+  }
+  std::sort(result.begin(), result.end(), [](const CallSiteStats &a, const CallSiteStats &b) {
+    return a.call_time > b.call_time;
+  });
+  return result;
+}
+
+Vector<ThreadStats> thread_stats()
+{
+  Profile &profile = get_profile();
+  std::lock_guard lock{profile.mutex};
+  const double duration = session_duration();
+
+  Vector<ThreadStats> result;
+  for (const std::unique_ptr<ThreadData> &data : profile.threads) {
+    ThreadStats stats;
+    stats.thread_index = data->index;
+    for (const Event &event : data->events_copy()) {
+      if (event.type != EventType::Task) {
+        continue;
+      }
+      stats.tasks_num++;
+      if (event.is_outer) {
+        stats.busy_time += event.end - event.start;
+      }
+    }
+    stats.idle_time = std::max(0.0, duration - stats.busy_time);
+    result.append(stats);
+  }
+  return result;
+}
+
+static void write_json_string(std::ostream &stream, const StringRef str)
+{
+  stream << '"';
+  for (const char c : str) {
+    if (ELEM(c, '"', '\\')) {
+      stream << '\\';
+    }
+    stream << c;
+  }
+  stream << '"';
+}
+
+void write_chrome_trace(std::ostream &stream)
+{
+  Profile &profile = get_profile();
+  std::lock_guard lock{profile.mutex};
+
+  stream << "{\"traceEvents\":[\n";
+  bool is_first = true;
+  const auto begin_event = [&]() {
+    if (!is_first) {
+      stream << ",\n";
+    }
+    is_first = false;
+  };
+
+  stream << std::fixed << std::setprecision(3);
+  for (const std::unique_ptr<ThreadData> &data : profile.threads) {
+    begin_event();
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << data->index
+           << ",\"args\":{\"name\":\"Thread " << data->index << "\"}}";
+
+    for (const Event &event : data->events_copy()) {
+      begin_event();
+      stream << "{\"name\":";
+      write_json_string(stream, call_site_name(event));
+      stream << ",\"cat\":\"" << (event.type == EventType::Call ? "parallel_for" : "task")
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << data->index
+             << ",\"ts\":" << (event.start - profile.start_time) * 1e6
+             << ",\"dur\":" << (event.end - event.start) * 1e6 << ",\"args\":{\"size\":"
+             << event.size;
+      if (event.type == EventType::Call) {
+        stream << ",\"grain_size\":" << event.grain_size << ",\"tasks\":" << event.tasks_num;
+      }
+      stream << "}}";
+    }
+  }
+  stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool write_chrome_trace(const char *filepath)
+{
+  blender::fstream stream(filepath, std::ios::out | std::ios::trunc);
+  if (!stream.is_open()) {
+    return false;
+  }
+  write_chrome_trace(stream);
+  return bool(stream);
+}
+
+namespace detail {
+
+void profile_task(const char *name, const FunctionRef<void()> function)
+{
+  run_task(name, 0, 1, function);
+}
+
+}  // namespace detail
+
+}  // namespace profile
+
+namespace detail {
+
+ProfiledCall::ProfiledCall(const char *file, const int line, const int64_t grain_size)
+    : file_(file), line_(line), grain_size_(grain_size), start_(BLI_time_now_seconds())
+{
+}
+
+ProfiledCall::~ProfiledCall()
+{
+  const double end = BLI_time_now_seconds();
+  profile::get_thread_data().append({profile::EventType::Call,
+                                     false,
+                                     line_,
+                                     file_,
+                                     start_,
+                                     end,
+                                     elements_num_.load(),
+                                     grain_size_,
+                                     tasks_num_.load()});
+}
+
+void ProfiledCall::run_task(const int64_t elements_num, const FunctionRef<void()> function)
+{
+  tasks_num_.fetch_add(1, std::memory_order_relaxed);
+  elements_num_.fetch_add(elements_num, std::memory_order_relaxed);
+  profile::run_task(file_, line_, elements_num, function);
+}
+
+void parallel_for_profiled_impl(const IndexRange range,
+                                const int64_t grain_size,
+                                const FunctionRef<void(IndexRange)> function,
+                                const TaskSizeHints &size_hints,
+                                const char *call_site_file,
+                                const int call_site_line)
+{
+  ProfiledCall call(call_site_file, call_site_line, grain_size);
+  const auto task_fn = [&](const IndexRange sub_range) {
+    call.run_task(sub_range.size(), [&]() { function(sub_range); });
+  };
+  if (use_single_thread(size_hints, range, grain_size)) {
+    task_fn(range);
+  }
+  else {
+    parallel_for_impl(range, grain_size, task_fn, size_hints);
+  }
+}
+
+}  // namespace detail
+
+}  // namespace blender::threading
@@ -9,6 +9,7 @@
  */
 
 #include <cstdlib>
+#include <optional>
 
 #include "MEM_guardedalloc.h"
 
@@ -36,26 +37,37 @@ struct RangeTask {
   TaskParallelRangeFunc func;
   void *userdata;
   const TaskParallelSettings *settings;
+  /* Only set while profiling. */
+  blender::threading::detail::ProfiledCall *profiled_call;
 
   void *userdata_chunk;
 
   /* Root constructor. */
-  RangeTask(TaskParallelRangeFunc func, void *userdata, const TaskParallelSettings *settings)
-      : func(func), userdata(userdata), settings(settings)
+  RangeTask(TaskParallelRangeFunc func,
+            void *userdata,
+            const TaskParallelSettings *settings,
+            blender::threading::detail::ProfiledCall *profiled_call)
+      : func(func), userdata(userdata), settings(settings), profiled_call(profiled_call)
   {
     init_chunk(settings->userdata_chunk);
   }
 
   /* Copy constructor. */
   RangeTask(const RangeTask &other)
-      : func(other.func), userdata(other.userdata), settings(other.settings)
+      : func(other.func),
+        userdata(other.userdata),
+        settings(other.settings),
+        profiled_call(other.profiled_call)
   {
     init_chunk(settings->userdata_chunk);
   }
 
   /* Splitting constructor for parallel reduce. */
   RangeTask(RangeTask &other, tbb::split /*unused*/)
-      : func(other.func), userdata(other.userdata), settings(other.settings)
+      : func(other.func),
+        userdata(other.userdata),
+        settings(other.settings),
+        profiled_call(other.profiled_call)
   {
     init_chunk(settings->userdata_chunk);
   }
@@ -80,6 +92,16 @@ struct RangeTask {
   }
 
   void operator()(const tbb::blocked_range<int> &r) const
+  {
+    if (profiled_call) {
+      profiled_call->run_task(r.size(), [&]() { run(r); });
+    }
+    else {
+      run(r);
+    }
+  }
+
+  void run(const tbb::blocked_range<int> &r) const
   {
     TaskParallelTLS tls;
     tls.userdata_chunk = userdata_chunk;
@@ -102,10 +124,16 @@ void BLI_task_parallel_range(const int start,
                              TaskParallelRangeFunc func,
                              const TaskParallelSettings *settings)
 {
+  /* The C API has no call site information, all calls are recorded under the same name. */
+  std::optional<blender::threading::detail::ProfiledCall> profiled_call;
+  if (UNLIKELY(blender::threading::detail::profiling_enabled.load(std::memory_order_relaxed))) {
+    profiled_call.emplace("BLI_task_parallel_range", 0, settings->min_iter_per_thread);
+  }
+
 #ifdef WITH_TBB
   /* Multithreading. */
   if (settings->use_threading && BLI_task_scheduler_num_threads() > 1) {
-    RangeTask task(func, userdata, settings);
+    RangeTask task(func, userdata, settings, profiled_call ? &*profiled_call : nullptr);
     const size_t grainsize = std::max(settings->min_iter_per_thread, 1);
     const tbb::blocked_range<int> range(start, stop, grainsize);
 
@@ -128,8 +156,16 @@ void BLI_task_parallel_range(const int start,
    * main userdata chunk directly. */
   TaskParallelTLS tls;
   tls.userdata_chunk = settings->userdata_chunk;
-  for (int i = start; i < stop; i++) {
-    func(userdata, i, &tls);
+  const auto run = [&]() {
+    for (int i = start; i < stop; i++) {
+      func(userdata, i, &tls);
+    }
+  };
+  if (profiled_call) {
+    profiled_call->run_task(stop - start, run);
+  }
+  else {
+    run();
   }
   if (settings->func_free != nullptr) {
     settings->func_free(userdata, settings->userdata_chunk);
@@ -59,6 +59,7 @@ void BLI_task_scheduler_exit()
 {
 #ifdef WITH_TBB_GLOBAL_CONTROL
   MEM_delete(task_scheduler_global_control);
+  task_scheduler_global_control = nullptr;
 #endif
 }
 
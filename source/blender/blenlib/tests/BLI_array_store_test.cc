@@ -6,6 +6,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_array_store.h"
 #include "BLI_array_utils.h"
 #include "BLI_listbase.h"
@@ -14,6 +15,9 @@
 #include "BLI_string.h"
 #include "BLI_sys_types.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "intern/BLI_array_store_private.h"
 
 /* print memory savings */
 // #define DEBUG_PRINT
@@ -292,6 +296,69 @@ static void testbuffer_run_tests_simple(ListBase *lb, const int stride, const in
   BLI_array_store_destroy(bs);
 }
 
+/**
+ * Check that hashing on multiple threads de-duplicates the data exactly like a single thread.
+ */
+static void testbuffer_run_tests_parallel_hash(ListBase *lb,
+                                               const int stride,
+                                               const int chunk_count)
+{
+  BArrayStore *bs_parallel = BLI_array_store_create(stride, chunk_count);
+  BArrayStore *bs_serial = BLI_array_store_create(stride, chunk_count);
+  BLI_array_store_use_parallel_hash_set(bs_serial, false);
+
+  blender::Vector<BArrayState *> states_parallel;
+  blender::Vector<BArrayState *> states_serial;
+  LISTBASE_FOREACH (TestBuffer *, tb, lb) {
+    const bool is_first = states_parallel.is_empty();
+    states_parallel.append(BLI_array_store_state_add(
+        bs_parallel, tb->data, tb->data_len, is_first ? nullptr : states_parallel.last()));
+    states_serial.append(BLI_array_store_state_add(
+        bs_serial, tb->data, tb->data_len, is_first ? nullptr : states_serial.last()));
+  }
+
+  EXPECT_EQ(BLI_array_store_calc_size_compacted_get(bs_parallel),
+            BLI_array_store_calc_size_compacted_get(bs_serial));
+  EXPECT_EQ(BLI_array_store_calc_size_expanded_get(bs_parallel),
+            BLI_array_store_calc_size_expanded_get(bs_serial));
+
+  LISTBASE_FOREACH (TestBuffer *, tb, lb) {
+    const size_t hash_len = tb->data_len / size_t(stride);
+    blender::Array<uint> hash_parallel(hash_len);
+    blender::Array<uint> hash_serial(hash_len);
+    if (BLI_array_store_data_hash_get(bs_parallel, tb->data, tb->data_len, hash_parallel.data())) {
+      ASSERT_TRUE(
+          BLI_array_store_data_hash_get(bs_serial, tb->data, tb->data_len, hash_serial.data()));
+      EXPECT_EQ_ARRAY(hash_serial.data(), hash_parallel.data(), hash_len);
+    }
+  }
+
+  int shared_chunks_num = 0;
+  for (const int i : states_parallel.index_range()) {
+    uint *keys_parallel, *keys_serial;
+    int *users_parallel, *users_serial;
+    const size_t chunks_num = BLI_array_store_state_chunks_get_alloc(
+        bs_parallel, states_parallel[i], &keys_parallel, &users_parallel);
+    ASSERT_EQ(chunks_num,
+              BLI_array_store_state_chunks_get_alloc(
+                  bs_serial, states_serial[i], &keys_serial, &users_serial));
+    EXPECT_EQ_ARRAY(keys_serial, keys_parallel, chunks_num);
+    EXPECT_EQ_ARRAY(users_serial, users_parallel, chunks_num);
+    for (const int j : blender::IndexRange(chunks_num)) {
+      shared_chunks_num += users_parallel[j] > 1;
+    }
+    MEM_freeN(keys_parallel);
+    MEM_freeN(keys_serial);
+    MEM_freeN(users_parallel);
+    MEM_freeN(users_serial);
+  }
+  /* Otherwise the de-duplication is not tested. */
+  EXPECT_GT(shared_chunks_num, 0);
+
+  BLI_array_store_destroy(bs_parallel);
+  BLI_array_store_destroy(bs_serial);
+}
+
 /* -------------------------------------------------------------------- */
 /* Basic Tests */
 
@@ -658,7 +725,8 @@ static void random_data_mutate_helper(const int items_size_min,
                                       const int stride,
                                       const int chunk_count,
                                       const int random_seed,
-                                      const int mutate)
+                                      const int mutate,
+                                      const bool test_parallel_hash = false)
 {
 
   ListBase lb;
@@ -676,6 +744,9 @@ static void random_data_mutate_helper(const int items_size_min,
   }
 
   testbuffer_run_tests_simple(&lb, stride, chunk_count);
+  if (test_parallel_hash) {
+    testbuffer_run_tests_parallel_hash(&lb, stride, chunk_count);
+  }
 
   testbuffer_list_free(&lb);
 }
@@ -700,6 +771,15 @@ TEST(array_store, TestData_Stride32_Chunk64_Mutate8)
 {
   random_data_mutate_helper(0, 256, 200, 32, 64, 7117, 8);
 }
+/* Large enough to hash on multiple threads. */
+TEST(array_store, TestData_Stride1_Chunk32_Mutate2_Large)
+{
+  random_data_mutate_helper(100000, 200000, 6, 1, 32, 4447, 2, true);
+}
+TEST(array_store, TestData_Stride4_Chunk64_Mutate4_Large)
+{
+  random_data_mutate_helper(70000, 140000, 6, 4, 64, 5531, 4, true);
+}
 
 /* -------------------------------------------------------------------- */
 /* Randomized Chunks Test */
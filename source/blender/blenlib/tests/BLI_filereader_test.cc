@@ -0,0 +1,136 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <zstd.h>
+
+#include "BLI_filereader.h"
+#include "BLI_task.h"
+#include "BLI_vector.hh"
+
+namespace blender::tests {
+
+static void append_u32(Vector<char> &data, const uint32_t value)
+{
+  /* The seek table is little endian. */
+  for (int i = 0; i < 4; i++) {
+    data.append(char((value >> (i * 8)) & 0xff));
+  }
+}
+
+/**
+ * Compress the content as independent frames followed by a seek table, like #ZstdWriteWrap
+ * does when writing compressed .blend files.
+ */
+static Vector<char> zstd_compress_seekable(const Span<char> content, const int64_t frame_size)
+{
+  Vector<char> result;
+  Vector<std::pair<uint32_t, uint32_t>> frame_sizes;
+  for (int64_t start = 0; start < content.size(); start += frame_size) {
+    const Span<char> frame = content.slice(start, std::min(frame_size, content.size() - start));
+    const int64_t offset = result.size();
+    result.resize(offset + ZSTD_compressBound(frame.size()));
+    const size_t compressed_size = ZSTD_compress(
+        result.data() + offset, result.size() - offset, frame.data(), frame.size(), 1);
+    result.resize(offset + compressed_size);
+    frame_sizes.append({uint32_t(compressed_size), uint32_t(frame.size())});
+  }
+
+  append_u32(result, 0x184D2A5E);
+  append_u32(result, uint32_t(frame_sizes.size() * 8 + 9));
+  for (const std::pair<uint32_t, uint32_t> &sizes : frame_sizes) {
+    append_u32(result, sizes.first);
+    append_u32(result, sizes.second);
+  }
+  append_u32(result, uint32_t(frame_sizes.size()));
+  result.append(0);
+  append_u32(result, 0x8F92EAB1);
+  return result;
+}
+
+static Vector<char> test_content(const int64_t size)
+{
+  Vector<char> content(size);
+  uint32_t state = 12345;
+  for (char &c : content) {
+    /* Only use a few values so that the data is compressible. */
+    state = state * 1664525u + 1013904223u;
+    c = char('a' + (state >> 28));
+  }
+  return content;
+}
+
+/**
+ * The parameter forces read-ahead, which is skipped when the task scheduler only has a single
+ * thread, so that both code paths are tested on any machine.
+ */
+class FileReaderZstdTest : public testing::TestWithParam<bool> {
+ public:
+  static void SetUpTestSuite()
+  {
+    BLI_task_scheduler_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    BLI_task_scheduler_exit();
+  }
+
+  FileReader *new_zstd_reader(FileReader *base)
+  {
+    return BLI_filereader_new_zstd_ex(base, GetParam());
+  }
+};
+
+TEST_P(FileReaderZstdTest, seekable_sequential)
+{
+  const Vector<char> content = test_content(1000 * 1000);
+  const Vector<char> compressed = zstd_compress_seekable(content, 64 * 1024);
+
+  FileReader *reader = new_zstd_reader(
+      BLI_filereader_new_memory(compressed.data(), compressed.size()));
+  ASSERT_NE(reader, nullptr);
+  ASSERT_NE(reader->seek, nullptr);
+
+  /* Read in chunks that do not line up with the frames. */
+  Vector<char> result(content.size());
+  int64_t offset = 0;
+  while (offset < result.size()) {
+    const int64_t size = std::min<int64_t>(10007, result.size() - offset);
+    ASSERT_EQ(reader->read(reader, result.data() + offset, size), size);
+    offset += size;
+  }
+  EXPECT_EQ(reader->read(reader, result.data(), 1), 0);
+  EXPECT_EQ(memcmp(result.data(), content.data(), content.size()), 0);
+
+  reader->close(reader);
+}
+
+TEST_P(FileReaderZstdTest, seekable_random_access)
+{
+  const Vector<char> content = test_content(1000 * 1000);
+  const Vector<char> compressed = zstd_compress_seekable(content, 16 * 1024);
+
+  FileReader *reader = new_zstd_reader(
+      BLI_filereader_new_memory(compressed.data(), compressed.size()));
+  ASSERT_NE(reader, nullptr);
+
+  /* Jump back and forth, including backwards into frames that were read ahead and evicted. */
+  const int64_t offsets[] = {500000, 0, 999990, 16384 * 3 - 5, 700000, 16384 * 3, 100, 950000};
+  char buffer[20000];
+  for (const int64_t offset : offsets) {
+    const int64_t size = std::min<int64_t>(sizeof(buffer), content.size() - offset);
+    ASSERT_EQ(reader->seek(reader, offset, SEEK_SET), offset);
+    ASSERT_EQ(reader->read(reader, buffer, size), size);
+    EXPECT_EQ(memcmp(buffer, content.data() + offset, size), 0);
+  }
+
+  reader->close(reader);
+}
+
+INSTANTIATE_TEST_SUITE_P(filereader, FileReaderZstdTest, testing::Bool());
+
+}  // namespace blender::tests
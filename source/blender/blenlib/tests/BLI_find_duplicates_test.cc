@@ -0,0 +1,130 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_find_duplicates.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_kdtree.h"
+#include "BLI_rand.hh"
+
+namespace blender::tests {
+
+/** The result of the kd-tree based search, which #find_duplicates_by_distance should match. */
+static Array<int> duplicates_from_kdtree(const Span<float3> positions,
+                                         const IndexMask &mask,
+                                         const float distance,
+                                         int *r_duplicates_num)
+{
+  Array<int> duplicates(positions.size(), -1);
+  KDTree_3d *tree = BLI_kdtree_3d_new(mask.size());
+  mask.foreach_index([&](const int i) { BLI_kdtree_3d_insert(tree, i, positions[i]); });
+  BLI_kdtree_3d_balance(tree);
+  *r_duplicates_num = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, distance, true, duplicates.data());
+  BLI_kdtree_3d_free(tree);
+  return duplicates;
+}
+
+static void test_positions(const Span<float3> positions,
+                           const IndexMask &mask,
+                           const float distance)
+{
+  int expected_num;
+  const Array<int> expected = duplicates_from_kdtree(positions, mask, distance, &expected_num);
+
+  Array<int> duplicates(positions.size(), -1);
+  const int duplicates_num = find_duplicates_by_distance(positions, mask, distance, duplicates);
+  EXPECT_EQ(duplicates_num, expected_num);
+  EXPECT_EQ(duplicates.as_span(), expected.as_span());
+}
+
+static Array<float3> random_positions(const int size, const int resolution, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    /* Round the coordinates so that there are exact duplicates. */
+    for (int axis = 0; axis < 3; axis++) {
+      position[axis] = float(rng.get_int32(resolution)) / float(resolution);
+    }
+  }
+  return positions;
+}
+
+TEST(find_duplicates, Empty)
+{
+  Array<int> duplicates;
+  EXPECT_EQ(find_duplicates_by_distance({}, IndexMask(), 0.1f, duplicates), 0);
+}
+
+TEST(find_duplicates, ExactDuplicates)
+{
+  const Array<float3> positions = random_positions(10000, 20, 1);
+  test_positions(positions, positions.index_range(), 0.0001f);
+
+}
+
+TEST(find_duplicates, ZeroDistance)
+{
+  /* Like the kd-tree, nothing is merged without a positive distance, even exact duplicates. */
+  const Array<float3> positions = random_positions(10000, 20, 1);
+  test_positions(positions, positions.index_range(), 0.0f);
+
+  Array<int> duplicates(positions.size(), -1);
+  EXPECT_EQ(find_duplicates_by_distance(positions, positions.index_range(), 0.0f, duplicates), 0);
+  EXPECT_EQ(find_duplicates_by_distance(positions, positions.index_range(), -1.0f, duplicates), 0);
+  EXPECT_EQ(
+      find_duplicates_by_distance(
+          positions, positions.index_range(), std::numeric_limits<float>::quiet_NaN(), duplicates),
+      0);
+  EXPECT_EQ(duplicates.as_span(), Array<int>(positions.size(), -1).as_span());
+}
+
+TEST(find_duplicates, Distance)
+{
+  const Array<float3> positions = random_positions(10000, 1000, 2);
+  test_positions(positions, positions.index_range(), 0.02f);
+  test_positions(positions, positions.index_range(), 0.1f);
+}
+
+TEST(find_duplicates, Mask)
+{
+  const Array<float3> positions = random_positions(10000, 100, 3);
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      positions.index_range(), GrainSize(512), memory, [](const int i) { return i % 3 != 1; });
+  test_positions(positions, mask, 0.015f);
+}
+
+TEST(find_duplicates, Chain)
+{
+  /* Every position is within the distance of the previous one, so whether a position is merged
+   * depends on all earlier positions. */
+  Array<float3> positions(1000);
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(float(i) * 0.6f, 0.0f, 0.0f);
+  }
+  test_positions(positions, positions.index_range(), 1.0f);
+  Array<int> duplicates(positions.size(), -1);
+  EXPECT_EQ(find_duplicates_by_distance(positions, positions.index_range(), 1.0f, duplicates),
+            500);
+  EXPECT_EQ(duplicates[0], 0);
+  EXPECT_EQ(duplicates[1], 0);
+  EXPECT_EQ(duplicates[2], 2);
+  EXPECT_EQ(duplicates[3], 2);
+}
+
+TEST(find_duplicates, NonFinite)
+{
+  Array<float3> positions = random_positions(100, 10, 4);
+  positions[5] = float3(std::numeric_limits<float>::infinity(), 0.0f, 0.0f);
+  positions[50] = float3(std::numeric_limits<float>::quiet_NaN());
+  Array<int> duplicates(positions.size(), -1);
+  find_duplicates_by_distance(positions, positions.index_range(), 0.1f, duplicates);
+  EXPECT_EQ(duplicates[50], -1);
+}
+
+}  // namespace blender::tests
@@ -8,10 +8,14 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_kdopbvh_wide.hh"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 /* -------------------------------------------------------------------- */
 /* Helper Functions */
@@ -134,3 +138,225 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Wide BVH */
+
+struct WideTestData {
+  float (*points)[3];
+  float radius;
+};
+
+static void wide_nearest_callback(void *userdata,
+                                  int index,
+                                  const float co[3],
+                                  BVHTreeNearest *nearest)
+{
+  const WideTestData *data = static_cast<const WideTestData *>(userdata);
+  const float dist_sq = len_squared_v3v3(co, data->points[index]);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, data->points[index]);
+  }
+}
+
+static void wide_raycast_callback(void *userdata,
+                                  int index,
+                                  const BVHTreeRay *ray,
+                                  BVHTreeRayHit *hit)
+{
+  const WideTestData *data = static_cast<const WideTestData *>(userdata);
+  float offset[3];
+  sub_v3_v3v3(offset, data->points[index], ray->origin);
+  const float t = dot_v3v3(offset, ray->direction);
+  const float perp_sq = len_squared_v3(offset) - t * t;
+  const float radius_sq = data->radius * data->radius;
+  if (t < 0.0f || perp_sq > radius_sq) {
+    return;
+  }
+  const float dist = t - sqrtf(radius_sq - perp_sq);
+  if (dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void wide_tree_test(int points_len, char tree_type, int random_seed)
+{
+  RNG *rng = BLI_rng_new(random_seed);
+  WideTestData data;
+  data.radius = 0.01f;
+  data.points = static_cast<float(*)[3]>(MEM_mallocN(sizeof(float[3]) * points_len, __func__));
+
+  BVHTree *tree = BLI_bvhtree_new(points_len, data.radius, tree_type, 6);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(data.points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, data.points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  std::unique_ptr<blender::WideBVHTree> wide_tree = blender::WideBVHTree::from_tree(*tree);
+  ASSERT_NE(wide_tree, nullptr);
+
+  int hits_num = 0;
+  for (int i = 0; i < 200; i++) {
+    float co[3], dir[3];
+    rng_v3_round(co, 3, rng, 1000, 1.5f);
+    BLI_rng_get_float_unit_v3(rng, dir);
+
+    BVHTreeNearest nearest = {-1};
+    nearest.dist_sq = FLT_MAX;
+    BVHTreeNearest wide_nearest = nearest;
+    BLI_bvhtree_find_nearest(tree, co, &nearest, wide_nearest_callback, &data);
+    wide_tree->find_nearest(co, &wide_nearest, wide_nearest_callback, &data);
+    EXPECT_EQ(nearest.index, wide_nearest.index);
+    EXPECT_EQ(nearest.dist_sq, wide_nearest.dist_sq);
+
+    BVHTreeRayHit hit = {-1};
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BVHTreeRayHit wide_hit = hit;
+    BLI_bvhtree_ray_cast(tree, co, dir, 0.0f, &hit, wide_raycast_callback, &data);
+    wide_tree->ray_cast(co, dir, 0.0f, &wide_hit, wide_raycast_callback, &data);
+    EXPECT_EQ(hit.index, wide_hit.index);
+    EXPECT_EQ(hit.dist, wide_hit.dist);
+    hits_num += hit.index != -1;
+  }
+  if (points_len > 100) {
+    EXPECT_GT(hits_num, 0);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(data.points);
+}
+
+TEST(kdopbvh, WideTree_Binary)
+{
+  wide_tree_test(1000, 2, 42);
+}
+TEST(kdopbvh, WideTree_Quad)
+{
+  wide_tree_test(1000, 4, 43);
+}
+TEST(kdopbvh, WideTree_Oct)
+{
+  wide_tree_test(1000, 8, 44);
+}
+TEST(kdopbvh, WideTree_Small)
+{
+  wide_tree_test(3, 2, 45);
+}
+
+/* -------------------------------------------------------------------- */
+/* Batched queries */
+
+/** Run the batched queries on multiple threads, even on machines with a single core. */
+class KdopbvhBatchTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BLI_system_num_threads_override_set(4);
+    BLI_task_scheduler_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    BLI_task_scheduler_exit();
+    BLI_system_num_threads_override_set(0);
+  }
+};
+
+static void batch_test(int points_len,
+                       int queries_len,
+                       int random_seed,
+                       const bool use_wide_tree,
+                       const bool use_non_finite = false)
+{
+  using namespace blender;
+  RNG *rng = BLI_rng_new(random_seed);
+  WideTestData data;
+  data.radius = 0.01f;
+  data.points = static_cast<float(*)[3]>(MEM_mallocN(sizeof(float[3]) * points_len, __func__));
+
+  BVHTree *tree = BLI_bvhtree_new(points_len, data.radius, 4, 6);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(data.points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, data.points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  Array<float3> origins(queries_len);
+  Array<float3> directions(queries_len);
+  Array<BVHTreeRayHit> hits(queries_len);
+  Array<BVHTreeNearest> nearest(queries_len);
+  for (int i = 0; i < queries_len; i++) {
+    rng_v3_round(origins[i], 3, rng, 1000, 1.5f);
+    BLI_rng_get_float_unit_v3(rng, directions[i]);
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    nearest[i].index = -1;
+    nearest[i].dist_sq = FLT_MAX;
+  }
+  if (use_non_finite) {
+    for (int i = 0; i < queries_len; i += 7) {
+      origins[i][i % 3] = (i % 2) ? NAN : INFINITY;
+    }
+  }
+
+  const std::unique_ptr<WideBVHTree> wide_tree = use_wide_tree ? WideBVHTree::from_tree(*tree) :
+                                                                  nullptr;
+  EXPECT_EQ(use_wide_tree, wide_tree != nullptr);
+  BLI_bvhtree_ray_cast_batch(
+      *tree, origins, directions, 0.0f, wide_raycast_callback, &data, hits, wide_tree.get());
+  BLI_bvhtree_find_nearest_batch(
+      *tree, origins, wide_nearest_callback, &data, nearest, wide_tree.get());
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeRayHit hit = {-1};
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+    BLI_bvhtree_ray_cast(
+        tree, origins[i], directions[i], 0.0f, &hit, wide_raycast_callback, &data);
+    EXPECT_EQ(hit.index, hits[i].index);
+    EXPECT_EQ(hit.dist, hits[i].dist);
+
+    BVHTreeNearest expected_nearest = {-1};
+    expected_nearest.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, origins[i], &expected_nearest, wide_nearest_callback, &data);
+    EXPECT_EQ(expected_nearest.index, nearest[i].index);
+    EXPECT_EQ(expected_nearest.dist_sq, nearest[i].dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(data.points);
+}
+
+TEST_F(KdopbvhBatchTest, Small)
+{
+  batch_test(500, 100, 46, false);
+}
+TEST_F(KdopbvhBatchTest, SmallWide)
+{
+  batch_test(500, 100, 46, true);
+}
+TEST_F(KdopbvhBatchTest, Large)
+{
+  batch_test(1000, 10000, 47, false);
+}
+TEST_F(KdopbvhBatchTest, LargeWide)
+{
+  batch_test(1000, 10000, 47, true);
+}
+TEST_F(KdopbvhBatchTest, LargeTree)
+{
+  batch_test(50000, 5000, 48, true);
+}
+TEST_F(KdopbvhBatchTest, NonFinite)
+{
+  batch_test(1000, 10000, 49, false, true);
+}
+TEST_F(KdopbvhBatchTest, NonFiniteWide)
+{
+  batch_test(1000, 10000, 49, true, true);
+}
@@ -4,8 +4,13 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_kdtree.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_task.h"
 
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 
 /* -------------------------------------------------------------------- */
@@ -63,3 +68,78 @@ TEST(kdtree, Deduplicate)
 {
   deduplicate_test();
 }
+
+static float random_float(uint32_t &state)
+{
+  state = state * 1664525u + 1013904223u;
+  return float(state >> 8) / float(1 << 24);
+}
+
+using blender::Array;
+using blender::float3;
+
+static void batch_test()
+{
+  /* Large enough to balance the tree on multiple threads. */
+  const int tree_size = 50000;
+  const int query_size = 1000;
+  const uint nearest_len_capacity = 4;
+
+  uint32_t state = 1;
+  Array<float3> tree_co(tree_size);
+  KDTree_3d *tree = BLI_kdtree_3d_new(tree_size);
+  for (int i = 0; i < tree_size; i++) {
+    tree_co[i][0] = random_float(state);
+    tree_co[i][1] = random_float(state);
+    tree_co[i][2] = random_float(state);
+    BLI_kdtree_3d_insert(tree, i, tree_co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  Array<float3> query_co(query_size);
+  for (int i = 0; i < query_size; i++) {
+    query_co[i][0] = random_float(state);
+    query_co[i][1] = random_float(state);
+    query_co[i][2] = random_float(state);
+  }
+
+  Array<KDTreeNearest_3d> nearest(query_size * nearest_len_capacity);
+  Array<int> nearest_len(query_size);
+  BLI_kdtree_3d_find_nearest_n_batch(tree,
+                                     reinterpret_cast<const float(*)[3]>(query_co.data()),
+                                     query_size,
+                                     nearest.data(),
+                                     nearest_len_capacity,
+                                     nearest_len.data());
+
+  for (int i = 0; i < query_size; i++) {
+    KDTreeNearest_3d expected[nearest_len_capacity];
+    const int expected_len = BLI_kdtree_3d_find_nearest_n(
+        tree, query_co[i], expected, nearest_len_capacity);
+    EXPECT_EQ(nearest_len[i], expected_len);
+    for (int j = 0; j < expected_len; j++) {
+      EXPECT_EQ(nearest[i * nearest_len_capacity + j].index, expected[j].index);
+      EXPECT_EQ(nearest[i * nearest_len_capacity + j].dist, expected[j].dist);
+    }
+
+    /* Compare the closest point with a brute force search. */
+    float dist_sq_min = FLT_MAX;
+    for (int j = 0; j < tree_size; j++) {
+      float dist_sq = 0.0f;
+      for (int axis = 0; axis < 3; axis++) {
+        dist_sq += (tree_co[j][axis] - query_co[i][axis]) * (tree_co[j][axis] - query_co[i][axis]);
+      }
+      dist_sq_min = std::min(dist_sq_min, dist_sq);
+    }
+    EXPECT_FLOAT_EQ(nearest[i * nearest_len_capacity].dist, sqrtf(dist_sq_min));
+  }
+
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearestNBatch)
+{
+  BLI_task_scheduler_init();
+  batch_test();
+  BLI_task_scheduler_exit();
+}
@@ -9,6 +9,7 @@
 #include <iostream>
 
 #include "BLI_array.hh"
+#include "BLI_math_boolean.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_math_vector_mpq_types.hh"
 #include "BLI_mesh_intersect.hh"
@@ -177,6 +178,36 @@ TEST(mesh_intersect, Mesh)
   EXPECT_TRUE(f->is_tri());
 }
 
+TEST(mesh_intersect, Orient3d)
+{
+  IMeshArena arena;
+  const mpq_class third(1, 3);
+  const Vert *a = arena.add_or_find_vert(mpq3(0, 0, 0), 0);
+  const Vert *b = arena.add_or_find_vert(mpq3(1, 0, 0), 1);
+  const Vert *c = arena.add_or_find_vert(mpq3(0, 1, 0), 2);
+  const Vert *above = arena.add_or_find_vert(mpq3(0.25, 0.25, 1), 3);
+  /* The double coordinates of these are rounded, the exact ones are needed to decide. */
+  const Vert *on = arena.add_or_find_vert(mpq3(third, third, 0), 4);
+  const Vert *near_above = arena.add_or_find_vert(mpq3(third, third, mpq_class(1, 1000000000)),
+                                                  5);
+  const Vert *tilted = arena.add_or_find_vert(mpq3(third, 0, third), 6);
+  const Vert *near_tilted = arena.add_or_find_vert(
+      mpq3(third, third, third + mpq_class(1, 1000000000) * mpq_class(1, 1000000000)), 7);
+  const Vert *verts[] = {a, b, c, above, on, near_above, tilted, near_tilted};
+  for (const Vert *v0 : verts) {
+    for (const Vert *v1 : verts) {
+      for (const Vert *v2 : verts) {
+        for (const Vert *v3 : verts) {
+          EXPECT_EQ(orient3d(v0, v1, v2, v3),
+                    orient3d(v0->co_exact, v1->co_exact, v2->co_exact, v3->co_exact));
+        }
+      }
+    }
+  }
+  EXPECT_EQ(orient3d(a, b, c, on), 0);
+  EXPECT_NE(orient3d(a, b, c, near_above), 0);
+}
+
 TEST(mesh_intersect, TriangulateTri)
 {
   const char *spec = R"(3 1
@@ -5,6 +5,8 @@
 #include "testing/testing.h"
 #include <atomic>
 #include <cstring>
+#include <sstream>
+#include <thread>
 
 #include "atomic_ops.h"
 
@@ -14,8 +16,10 @@
 
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
+#include "BLI_string_ref.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
+#include "BLI_task_profile.hh"
 
 #define ITEMS_NUM 10000
 
@@ -245,3 +249,162 @@ TEST(task, ParallelInvoke)
                                       [&]() { counter++; });
   EXPECT_EQ(counter, 6);
 }
+
+static const blender::threading::profile::CallSiteStats *find_call_site(
+    const blender::Span<blender::threading::profile::CallSiteStats> call_sites,
+    const blender::StringRef name)
+{
+  for (const blender::threading::profile::CallSiteStats &call_site : call_sites) {
+    if (call_site.name == name) {
+      return &call_site;
+    }
+  }
+  return nullptr;
+}
+
+TEST(task, Profile)
+{
+  using namespace blender;
+  std::atomic<int64_t> sum = 0;
+  const int call_line = __LINE__ + 2;
+  threading::profile::start();
+  threading::parallel_for(IndexRange(ITEMS_NUM), 100, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      sum += i;
+    }
+  });
+  threading::profile::stop();
+  EXPECT_EQ(sum, int64_t(ITEMS_NUM) * (ITEMS_NUM - 1) / 2);
+  EXPECT_FALSE(threading::profile::is_running());
+
+  const Vector<threading::profile::CallSiteStats> call_sites =
+      threading::profile::call_site_stats();
+  const std::string expected_name = "BLI_task_test.cc:" + std::to_string(call_line);
+  const threading::profile::CallSiteStats *stats = find_call_site(call_sites, expected_name);
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->calls_num, 1);
+  EXPECT_EQ(stats->elements_num, ITEMS_NUM);
+  EXPECT_EQ(stats->grain_size_min, 100);
+  EXPECT_GE(stats->tasks_num, 1);
+  EXPECT_LE(stats->task_time_max, stats->task_time);
+
+  int64_t tasks_num = 0;
+  for (const threading::profile::ThreadStats &thread : threading::profile::thread_stats()) {
+    tasks_num += thread.tasks_num;
+    EXPECT_GE(thread.idle_time, 0.0);
+  }
+  EXPECT_EQ(tasks_num, stats->tasks_num);
+
+  std::stringstream stream;
+  threading::profile::write_chrome_trace(stream);
+  const std::string trace = stream.str();
+  EXPECT_EQ(trace.rfind("{\"traceEvents\":[", 0), 0);
+  EXPECT_NE(trace.find("\"cat\":\"parallel_for\""), std::string::npos);
+  EXPECT_NE(trace.find(expected_name), std::string::npos);
+
+  /* Nothing is recorded after stopping. */
+  threading::parallel_for(IndexRange(ITEMS_NUM), 100, [&](const IndexRange /*range*/) {});
+  EXPECT_EQ(threading::profile::call_site_stats().size(), call_sites.size());
+}
+
+TEST(task, ProfileReduceAndForEach)
+{
+  using namespace blender;
+  Vector<int> values(ITEMS_NUM);
+  threading::profile::start();
+  const int reduce_line = __LINE__ + 1;
+  const int64_t sum = threading::parallel_reduce(
+      IndexRange(ITEMS_NUM),
+      100,
+      int64_t(0),
+      [](const IndexRange range, const int64_t init) {
+        int64_t sum = init;
+        for (const int64_t i : range) {
+          sum += i;
+        }
+        return sum;
+      },
+      std::plus<int64_t>());
+  const int for_each_line = __LINE__ + 1;
+  threading::parallel_for_each(values, [](int &value) { value = 1; });
+  threading::profile::stop();
+  EXPECT_EQ(sum, int64_t(ITEMS_NUM) * (ITEMS_NUM - 1) / 2);
+
+  const Vector<threading::profile::CallSiteStats> call_sites =
+      threading::profile::call_site_stats();
+  const threading::profile::CallSiteStats *reduce_stats = find_call_site(
+      call_sites, "BLI_task_test.cc:" + std::to_string(reduce_line));
+  ASSERT_NE(reduce_stats, nullptr);
+  EXPECT_EQ(reduce_stats->calls_num, 1);
+  EXPECT_EQ(reduce_stats->elements_num, ITEMS_NUM);
+  EXPECT_EQ(reduce_stats->grain_size_max, 100);
+  EXPECT_GE(reduce_stats->tasks_num, 1);
+
+  const threading::profile::CallSiteStats *for_each_stats = find_call_site(
+      call_sites, "BLI_task_test.cc:" + std::to_string(for_each_line));
+  ASSERT_NE(for_each_stats, nullptr);
+  EXPECT_EQ(for_each_stats->calls_num, 1);
+  EXPECT_EQ(for_each_stats->tasks_num, ITEMS_NUM);
+  EXPECT_EQ(for_each_stats->elements_num, ITEMS_NUM);
+  for (const int value : values) {
+    EXPECT_EQ(value, 1);
+  }
+}
+
+TEST(task, ProfileRangeAPI)
+{
+  int data[ITEMS_NUM] = {0};
+  int sum = 0;
+
+  BLI_threadapi_init();
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+  settings.userdata_chunk = &sum;
+  settings.userdata_chunk_size = sizeof(sum);
+  settings.func_reduce = task_range_iter_reduce_func;
+
+  blender::threading::profile::start();
+  BLI_task_parallel_range(0, ITEMS_NUM, data, task_range_iter_func, &settings);
+  blender::threading::profile::stop();
+
+  EXPECT_EQ(sum, ITEMS_NUM * (ITEMS_NUM - 1) / 2);
+  const blender::Vector<blender::threading::profile::CallSiteStats> call_sites =
+      blender::threading::profile::call_site_stats();
+  const blender::threading::profile::CallSiteStats *stats = find_call_site(
+      call_sites, "BLI_task_parallel_range");
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(stats->calls_num, 1);
+  EXPECT_EQ(stats->elements_num, ITEMS_NUM);
+  EXPECT_EQ(stats->grain_size_min, 16);
+  EXPECT_GE(stats->tasks_num, 1);
+
+  BLI_threadapi_exit();
+}
+
+TEST(task, ProfileReadWhileRecording)
+{
+  using namespace blender;
+  threading::profile::start();
+  std::atomic<bool> done = false;
+  /* Results can be gathered while other threads are still recording. */
+  std::thread reader([&]() {
+    while (!done) {
+      threading::profile::call_site_stats();
+      threading::profile::thread_stats();
+    }
+  });
+  for ([[maybe_unused]] const int iteration : IndexRange(100)) {
+    threading::parallel_for(IndexRange(ITEMS_NUM), 10, [&](const IndexRange /*range*/) {});
+  }
+  done = true;
+  reader.join();
+  threading::profile::stop();
+
+  int64_t tasks_num = 0;
+  for (const threading::profile::ThreadStats &thread : threading::profile::thread_stats()) {
+    tasks_num += thread.tasks_num;
+  }
+  EXPECT_GE(tasks_num, 100);
+}
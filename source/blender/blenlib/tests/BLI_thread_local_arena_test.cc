@@ -0,0 +1,76 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+
+#include "BLI_array.hh"
+#include "BLI_task.hh"
+#include "BLI_thread_local_arena.hh"
+#include "BLI_vector.hh"
+
+namespace blender::threading::tests {
+
+TEST(thread_local_arena, ParallelAllocation)
+{
+  ThreadLocalArena arena;
+  EXPECT_EQ(arena.memory_size(), 0);
+
+  Array<MutableSpan<int>> spans(1000);
+  parallel_for(spans.index_range(), 10, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      spans[i] = arena.allocate_array<int>(i + 1);
+      spans[i].fill(int(i));
+    }
+  });
+
+  int64_t sum = 0;
+  for (const int64_t i : spans.index_range()) {
+    EXPECT_EQ(spans[i].size(), i + 1);
+    EXPECT_EQ(spans[i].first(), i);
+    EXPECT_EQ(spans[i].last(), i);
+    sum += spans[i].size() * sizeof(int);
+  }
+  EXPECT_GE(arena.memory_size(), sum);
+}
+
+TEST(thread_local_arena, VectorAllocator)
+{
+  ThreadLocalArena arena;
+  std::atomic<int64_t> total = 0;
+  parallel_for(IndexRange(100), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      Vector<int64_t, 4, ThreadLocalArena::Allocator> values(arena.allocator());
+      for (const int64_t j : IndexRange(i)) {
+        values.append(j);
+      }
+      int64_t local_total = 0;
+      for (const int64_t value : values) {
+        local_total += value;
+      }
+      total += local_total;
+    }
+  });
+  EXPECT_EQ(total, 161700);
+  EXPECT_GT(arena.memory_size(), 0);
+}
+
+TEST(thread_local_arena, TransferOwnership)
+{
+  ThreadLocalArena::LocalAllocator allocator;
+  MutableSpan<int> values;
+  {
+    ThreadLocalArena arena;
+    values = arena.allocate_array<int>(10000);
+    values.fill(5);
+    const int64_t size = arena.memory_size();
+    arena.transfer_ownership_to(allocator);
+    EXPECT_EQ(arena.memory_size(), 0);
+    EXPECT_EQ(allocator.owned_allocation_size(), size);
+  }
+  EXPECT_EQ(values.last(), 5);
+}
+
+}  // namespace blender::threading::tests
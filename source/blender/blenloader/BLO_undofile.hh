@@ -40,9 +40,32 @@ struct MemFileChunk {
    * detect unchanged IDs).
    * Defined when writing the next step (i.e. last undo step has those always false). */
   bool is_identical_future;
+  /**
+   * When true, this chunk doesn't own the memory, it's shared with a #MemFileChunk from the
+   * previous step that has the same content but is stored at a different location. Unlike
+   * #is_identical, this does not mean that the data at this location is unchanged.
+   */
+  bool is_buffer_shared;
   /** Session UID of the ID being currently written (MAIN_ID_SESSION_UID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uid;
+  /** Hash of the content, used to quickly compare chunks with the ones of the next step. */
+  uint64_t hash;
+};
+
+/** Statistics gathered while writing a #MemFile, to profile undo pushes. */
+struct MemFileWriteStats {
+  /** Total number of chunks and their size in bytes. */
+  size_t chunks_num;
+  size_t chunks_size;
+  /** Chunks identical to the chunk at the same location in the previous step. */
+  size_t identical_num;
+  size_t identical_size;
+  /** Chunks sharing the memory of another chunk with the same content in the previous step. */
+  size_t shared_num;
+  size_t shared_size;
+  /** Time spent writing the step in seconds. */
+  double time;
 };
 
 struct MemFile {
@@ -53,6 +76,7 @@ struct MemFile {
    * without making a copy. This is faster and requires less memory.
    */
   MemFileSharedStorage *shared_storage;
+  MemFileWriteStats stats;
 };
 
 struct MemFileWriteData {
@@ -64,6 +88,13 @@ struct MemFileWriteData {
 
   /** Maps an ID session uid to its first reference MemFileChunk, if existing. */
   blender::Map<uint, MemFileChunk *> id_session_uid_mapping;
+  /**
+   * Maps a content hash to the first reference MemFileChunk with that hash. Used to share memory
+   * with chunks that moved to a different location since the previous step.
+   */
+  blender::Map<uint64_t, MemFileChunk *> hash_mapping;
+
+  double time_start;
 };
 
 struct MemFileUndoData {
@@ -90,6 +121,14 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size);
+/**
+ * Add a large buffer as multiple chunks of at most \a chunk_size bytes. The chunks are hashed
+ * and compared with the previous step in parallel.
+ */
+void BLO_memfile_chunks_add(MemFileWriteData *mem_data,
+                            const char *buf,
+                            size_t size,
+                            size_t chunk_size);
 
 /* exports */
 
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
+#include <xxhash.h>
 
 /* open/close */
 #ifndef _WIN32
@@ -24,8 +25,11 @@
 
 #include "DNA_listBase.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_task.hh"
+#include "BLI_time.h"
 
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -34,14 +38,24 @@
 #include "BKE_main.hh"
 #include "BKE_undo_system.hh"
 
+#include "CLG_log.h"
+
 #include "BLI_strict_flags.h" /* Keep last. */
 
+static CLG_LogRef LOG = {"blo.undofile"};
+
 /* **************** support for memory-write, for undo buffers *************** */
 
+/** False when the buffer is owned by a chunk of a previous step. */
+static bool memfile_chunk_owns_buffer(const MemFileChunk *chunk)
+{
+  return !(chunk->is_identical || chunk->is_buffer_shared);
+}
+
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
+    if (memfile_chunk_owns_buffer(chunk)) {
       MEM_freeN((void *)chunk->buf);
     }
     MEM_freeN(chunk);
@@ -67,7 +81,7 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
 
   /* First, detect all memchunks in second memfile that are not owned by it. */
   LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
-    if (sc->is_identical) {
+    if (!memfile_chunk_owns_buffer(sc)) {
       buffer_to_second_memchunk.add(sc->buf, sc);
     }
   }
@@ -75,10 +89,11 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
   LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
-    if (!fc->is_identical) {
+    if (memfile_chunk_owns_buffer(fc)) {
       if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
-        BLI_assert(sc->is_identical);
+        BLI_assert(!memfile_chunk_owns_buffer(sc));
         sc->is_identical = false;
+        sc->is_buffer_shared = false;
         fc->is_identical = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
@@ -106,6 +121,8 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
   mem_data->reference_current_chunk = reference_memfile ? static_cast<MemFileChunk *>(
                                                               reference_memfile->chunks.first) :
                                                           nullptr;
+  mem_data->time_start = BLI_time_now_seconds();
+  written_memfile->stats = {};
 
   /* If we have a reference memfile, we generate a mapping between the session_uid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
@@ -119,52 +136,189 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
         current_session_uid = mem_chunk->id_session_uid;
         mem_data->id_session_uid_mapping.add_new(current_session_uid, mem_chunk);
       }
+      mem_data->hash_mapping.add(mem_chunk->hash, mem_chunk);
     }
   }
 }
 
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
 {
+  MemFile *memfile = mem_data->written_memfile;
+  MemFileWriteStats &stats = memfile->stats;
+  stats.time = BLI_time_now_seconds() - mem_data->time_start;
+  CLOG_INFO(&LOG,
+            1,
+            "Undo step written in %.4fs: %zu chunks (%zu bytes), %zu identical (%zu bytes), "
+            "%zu shared (%zu bytes), %zu bytes stored",
+            stats.time,
+            stats.chunks_num,
+            stats.chunks_size,
+            stats.identical_num,
+            stats.identical_size,
+            stats.shared_num,
+            stats.shared_size,
+            memfile->size);
+
   mem_data->id_session_uid_mapping.clear_and_shrink();
+  mem_data->hash_mapping.clear_and_shrink();
 }
 
-void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
+static uint64_t memfile_chunk_hash(const char *buf, const size_t size)
+{
+  return XXH3_64bits(buf, size);
+}
+
+struct MemFileChunkMatch {
+  /** Chunk of the previous step with the same content. */
+  MemFileChunk *chunk = nullptr;
+  /** True when #chunk is at the same location as the new chunk. */
+  bool is_identical = false;
+};
+
+/**
+ * Find a chunk with the same content in the previous step, preferring \a compchunk which is at
+ * the same location. The hashes avoid reading the memory of chunks that changed.
+ *
+ * Only reads data, so it can be called from multiple threads.
+ */
+static MemFileChunkMatch memfile_chunk_find_match(const MemFileWriteData *mem_data,
+                                                  MemFileChunk *compchunk,
+                                                  const char *buf,
+                                                  const size_t size,
+                                                  const uint64_t hash)
+{
+  MemFileChunkMatch match;
+  if (compchunk != nullptr && compchunk->size == size && compchunk->hash == hash) {
+    if (memcmp(compchunk->buf, buf, size) == 0) {
+      match.chunk = compchunk;
+      match.is_identical = true;
+      return match;
+    }
+  }
+  MemFileChunk *chunk = mem_data->hash_mapping.lookup_default(hash, nullptr);
+  if (chunk != nullptr && chunk != compchunk && chunk->size == size) {
+    if (memcmp(chunk->buf, buf, size) == 0) {
+      match.chunk = chunk;
+    }
+  }
+  return match;
+}
+
+static char *memfile_chunk_buffer_copy(const char *buf, const size_t size)
+{
+  char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
+  memcpy(buf_new, buf, size);
+  return buf_new;
+}
+
+/**
+ * Append a new chunk to the written memfile.
+ * \param buf_new: Copy of the data owned by the new chunk, only used when there is no match.
+ */
+static void memfile_chunk_append(MemFileWriteData *mem_data,
+                                 const size_t size,
+                                 const uint64_t hash,
+                                 const MemFileChunkMatch &match,
+                                 const char *buf_new)
 {
   MemFile *memfile = mem_data->written_memfile;
-  MemFileChunk **compchunk_step = &mem_data->reference_current_chunk;
+  MemFileWriteStats &stats = memfile->stats;
 
   MemFileChunk *curchunk = static_cast<MemFileChunk *>(
       MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk"));
   curchunk->size = size;
   curchunk->buf = nullptr;
   curchunk->is_identical = false;
+  curchunk->is_buffer_shared = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
   curchunk->is_identical_future = true;
   curchunk->id_session_uid = mem_data->current_id_session_uid;
+  curchunk->hash = hash;
   BLI_addtail(&memfile->chunks, curchunk);
 
-  /* we compare compchunk with buf */
-  if (*compchunk_step != nullptr) {
-    MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-        compchunk->is_identical_future = true;
-      }
-    }
-    *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
-  }
+  stats.chunks_num++;
+  stats.chunks_size += size;
 
-  /* not equal... */
-  if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
+  if (match.chunk == nullptr) {
+    /* not equal... */
+    BLI_assert(buf_new != nullptr);
     curchunk->buf = buf_new;
     memfile->size += size;
   }
+  else if (match.is_identical) {
+    curchunk->buf = match.chunk->buf;
+    curchunk->is_identical = true;
+    match.chunk->is_identical_future = true;
+    stats.identical_num++;
+    stats.identical_size += size;
+  }
+  else {
+    /* Only share the memory, the data at this location did change. */
+    curchunk->buf = match.chunk->buf;
+    curchunk->is_buffer_shared = true;
+    stats.shared_num++;
+    stats.shared_size += size;
+  }
+}
+
+/** Get the chunk of the previous step at the location of the next written chunk. */
+static MemFileChunk *memfile_compchunk_step(MemFileWriteData *mem_data)
+{
+  MemFileChunk *compchunk = mem_data->reference_current_chunk;
+  if (compchunk != nullptr) {
+    mem_data->reference_current_chunk = static_cast<MemFileChunk *>(compchunk->next);
+  }
+  return compchunk;
+}
+
+void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
+{
+  MemFileChunk *compchunk = memfile_compchunk_step(mem_data);
+  const uint64_t hash = memfile_chunk_hash(buf, size);
+  const MemFileChunkMatch match = memfile_chunk_find_match(mem_data, compchunk, buf, size, hash);
+  memfile_chunk_append(mem_data,
+                       size,
+                       hash,
+                       match,
+                       match.chunk ? nullptr : memfile_chunk_buffer_copy(buf, size));
+}
+
+void BLO_memfile_chunks_add(MemFileWriteData *mem_data,
+                            const char *buf,
+                            size_t size,
+                            size_t chunk_size)
+{
+  const int64_t chunks_num = int64_t((size + chunk_size - 1) / chunk_size);
+  blender::Array<MemFileChunk *> compchunks(chunks_num);
+  for (const int64_t i : compchunks.index_range()) {
+    compchunks[i] = memfile_compchunk_step(mem_data);
+  }
+
+  /* Hashing, comparing and copying are independent for every chunk. */
+  blender::Array<uint64_t> hashes(chunks_num);
+  blender::Array<MemFileChunkMatch> matches(chunks_num);
+  blender::Array<char *> buffers(chunks_num, nullptr);
+  blender::threading::parallel_for(
+      compchunks.index_range(), 4, [&](const blender::IndexRange range) {
+        for (const int64_t i : range) {
+          const size_t offset = size_t(i) * chunk_size;
+          const size_t len = std::min(chunk_size, size - offset);
+          hashes[i] = memfile_chunk_hash(buf + offset, len);
+          matches[i] = memfile_chunk_find_match(
+              mem_data, compchunks[i], buf + offset, len, hashes[i]);
+          if (matches[i].chunk == nullptr) {
+            buffers[i] = memfile_chunk_buffer_copy(buf + offset, len);
+          }
+        }
+      });
+
+  for (const int64_t i : compchunks.index_range()) {
+    const size_t offset = size_t(i) * chunk_size;
+    const size_t len = std::min(chunk_size, size - offset);
+    memfile_chunk_append(mem_data, len, hashes[i], matches[i], buffers[i]);
+  }
 }
 
 Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene)
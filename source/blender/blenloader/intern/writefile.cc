@@ -543,6 +543,13 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
         wd->buffer.used_len = 0;
       }
 
+      if (wd->use_memfile) {
+        /* Add all pieces at once so they can be compared with the previous step in parallel. */
+        BLO_memfile_chunks_add(
+            &wd->mem, static_cast<const char *>(adr), len, wd->buffer.chunk_size);
+        return;
+      }
+
       do {
         size_t writelen = std::min(len, wd->buffer.chunk_size);
         writedata_do_write(wd, adr, writelen);
@@ -0,0 +1,105 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <cstring>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_vector.hh"
+
+#include "BLO_undofile.hh"
+
+namespace blender::blenloader::tests {
+
+static Vector<char> test_data(const int64_t size, const char seed)
+{
+  Vector<char> data(size);
+  for (const int64_t i : data.index_range()) {
+    data[i] = char(seed + i * 7);
+  }
+  return data;
+}
+
+static void write_memfile(MemFile *memfile,
+                          MemFile *reference,
+                          const Span<Span<char>> chunks,
+                          const bool use_chunks_add)
+{
+  MemFileWriteData mem_data{};
+  BLO_memfile_write_init(&mem_data, memfile, reference);
+  for (const Span<char> chunk : chunks) {
+    if (use_chunks_add) {
+      BLO_memfile_chunks_add(&mem_data, chunk.data(), size_t(chunk.size()), 100);
+    }
+    else {
+      BLO_memfile_chunk_add(&mem_data, chunk.data(), size_t(chunk.size()));
+    }
+  }
+  BLO_memfile_write_finalize(&mem_data);
+}
+
+static MemFileChunk *memfile_chunk(MemFile *memfile, const int index)
+{
+  return static_cast<MemFileChunk *>(BLI_findlink(&memfile->chunks, index));
+}
+
+TEST(undofile, chunk_identical_and_shared)
+{
+  const Vector<char> a = test_data(64, 1);
+  const Vector<char> b = test_data(64, 2);
+  const Vector<char> c = test_data(64, 3);
+
+  MemFile first{};
+  write_memfile(&first, nullptr, {a, b}, false);
+  EXPECT_EQ(first.size, 128);
+  EXPECT_EQ(first.stats.chunks_num, 2);
+
+  /* The first chunk is unchanged, the second moved after a new chunk. */
+  MemFile second{};
+  BLO_memfile_clear_future(&first);
+  write_memfile(&second, &first, {a, c, b}, false);
+  EXPECT_EQ(second.size, 64);
+  EXPECT_EQ(second.stats.identical_num, 1);
+  EXPECT_EQ(second.stats.shared_num, 1);
+
+  EXPECT_TRUE(memfile_chunk(&second, 0)->is_identical);
+  EXPECT_FALSE(memfile_chunk(&second, 1)->is_identical);
+  EXPECT_FALSE(memfile_chunk(&second, 2)->is_identical);
+  EXPECT_TRUE(memfile_chunk(&second, 2)->is_buffer_shared);
+  EXPECT_EQ(memfile_chunk(&second, 2)->buf, memfile_chunk(&first, 1)->buf);
+  EXPECT_TRUE(memfile_chunk(&first, 0)->is_identical_future);
+  EXPECT_FALSE(memfile_chunk(&first, 1)->is_identical_future);
+
+  /* Ownership of the shared buffers is transferred to the remaining step. */
+  BLO_memfile_merge(&first, &second);
+  EXPECT_EQ(memcmp(memfile_chunk(&second, 2)->buf, b.data(), 64), 0);
+  BLO_memfile_free(&second);
+}
+
+TEST(undofile, chunks_add_parallel)
+{
+  const Vector<char> a = test_data(1050, 1);
+  Vector<char> b = a;
+  b[550] += 1;
+
+  MemFile first{};
+  write_memfile(&first, nullptr, {a}, true);
+  EXPECT_EQ(first.stats.chunks_num, 11);
+  EXPECT_EQ(first.size, 1050);
+
+  MemFile second{};
+  write_memfile(&second, &first, {b}, true);
+  EXPECT_EQ(second.stats.chunks_num, 11);
+  EXPECT_EQ(second.stats.identical_num, 10);
+  EXPECT_EQ(second.size, 100);
+  EXPECT_FALSE(memfile_chunk(&second, 5)->is_identical);
+  EXPECT_EQ(memfile_chunk(&second, 10)->size, 50);
+
+  BLO_memfile_free(&first);
+  BLO_memfile_free(&second);
+}
+
+}  // namespace blender::blenloader::tests
@@ -0,0 +1,190 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup editor/io
+ */
+
+#include "BKE_context.hh"
+#include "BKE_global.hh"
+#include "BKE_report.hh"
+
+#include "DNA_scene_types.h"
+
+#include "ED_outliner.hh"
+#include "ED_undo.hh"
+
+#include "RNA_access.hh"
+#include "RNA_define.hh"
+
+#include "WM_api.hh"
+#include "WM_types.hh"
+
+#include "io_import_job.hh"
+#include "io_utils.hh"
+
+namespace blender::ed::io {
+
+using blender::io::FileImportTask;
+using blender::io::FileImportTaskStatus;
+
+struct ImportJobData {
+  bContext *C;
+  Main *bmain;
+  Scene *scene;
+  ViewLayer *view_layer;
+  wmWindowManager *wm;
+
+  std::string name;
+  Vector<std::unique_ptr<FileImportTask>> tasks;
+  /** Whether each task was read successfully. */
+  Vector<bool> read_ok;
+  /** The job's reports, or the operator reports when not running as a job. */
+  ReportList *reports = nullptr;
+
+  bool was_canceled = false;
+  bool import_ok = false;
+  bool is_background_job = false;
+};
+
+static void import_startjob(void *customdata, wmJobWorkerStatus *worker_status)
+{
+  ImportJobData *data = static_cast<ImportJobData *>(customdata);
+  data->reports = worker_status->reports;
+  data->read_ok = Vector<bool>(data->tasks.size(), false);
+
+  const float progress_range = 1.0f / float(data->tasks.size());
+  for (const int i : data->tasks.index_range()) {
+    if (worker_status->stop) {
+      break;
+    }
+    FileImportTaskStatus status;
+    status.stop = &worker_status->stop;
+    status.progress = &worker_status->progress;
+    status.do_update = &worker_status->do_update;
+    status.progress_start = float(i) * progress_range;
+    status.progress_range = progress_range;
+    status.reports = worker_status->reports;
+
+    status.set_progress(0.0f);
+    data->read_ok[i] = data->tasks[i]->read(status);
+    status.set_progress(1.0f);
+  }
+
+  data->was_canceled = worker_status->stop;
+}
+
+static void import_endjob(void *customdata)
+{
+  ImportJobData *data = static_cast<ImportJobData *>(customdata);
+  ReportList *reports = data->reports;
+
+  if (data->is_background_job) {
+    WM_set_locked_interface(data->wm, false);
+  }
+
+  if (data->was_canceled) {
+    BKE_reportf(reports, RPT_WARNING, "%s canceled", data->name.c_str());
+    return;
+  }
+
+  data->import_ok = true;
+  for (const int i : data->tasks.index_range()) {
+    if (!data->read_ok[i]) {
+      data->import_ok = false;
+      continue;
+    }
+    data->tasks[i]->add_to_main(data->bmain, data->scene, data->view_layer, reports);
+  }
+
+  WM_main_add_notifier(NC_SCENE | ND_OB_SELECT, data->scene);
+  WM_main_add_notifier(NC_SCENE | ND_OB_ACTIVE, data->scene);
+  WM_main_add_notifier(NC_SCENE | ND_LAYER_CONTENT, data->scene);
+  ED_outliner_select_sync_from_object_tag(data->C);
+
+  if (data->is_background_job) {
+    /* Blender already returned from the import operator, so we need to store our own extra undo
+     * step. */
+    ED_undo_push(data->C, data->name.c_str());
+  }
+}
+
+static void import_freejob(void *customdata)
+{
+  ImportJobData *data = static_cast<ImportJobData *>(customdata);
+  delete data;
+}
+
+bool import_files(bContext *C,
+                  const char *job_name,
+                  Vector<std::unique_ptr<blender::io::FileImportTask>> tasks,
+                  const bool as_background_job,
+                  ReportList *reports)
+{
+  if (tasks.is_empty()) {
+    return false;
+  }
+
+  /* Using new here since `MEM_*` functions do not call constructor to properly initialize data. */
+  ImportJobData *job = new ImportJobData();
+  job->C = C;
+  job->bmain = CTX_data_main(C);
+  job->scene = CTX_data_scene(C);
+  job->view_layer = CTX_data_view_layer(C);
+  job->wm = CTX_wm_manager(C);
+  job->name = job_name;
+  job->tasks = std::move(tasks);
+  job->is_background_job = as_background_job;
+
+  G.is_break = false;
+
+  if (as_background_job) {
+    wmJob *wm_job = WM_jobs_get(job->wm,
+                                CTX_wm_window(C),
+                                job->scene,
+                                job_name,
+                                WM_JOB_PROGRESS,
+                                WM_JOB_TYPE_FILE_IMPORT);
+
+    /* The worker thread does not touch Main, but the scene and view layer that the results are
+     * added to have to stay valid until the job ends. */
+    WM_set_locked_interface(job->wm, true);
+
+    WM_jobs_customdata_set(wm_job, job, import_freejob);
+    WM_jobs_timer(wm_job, 0.1, NC_SCENE, NC_SCENE);
+    WM_jobs_callbacks(wm_job, import_startjob, nullptr, nullptr, import_endjob);
+    WM_jobs_start(job->wm, wm_job);
+    return true;
+  }
+
+  wmJobWorkerStatus worker_status = {};
+  worker_status.reports = reports;
+  import_startjob(job, &worker_status);
+  import_endjob(job);
+  const bool import_ok = job->import_ok;
+  import_freejob(job);
+  return import_ok;
+}
+
+void import_files_background_job_property_define(wmOperatorType *ot)
+{
+  PropertyRNA *prop = RNA_def_boolean(
+      ot->srna,
+      "as_background_job",
+      false,
+      "Run as Background Job",
+      "Read the files in the background, keeping the interface responsive. EXECUTE this operator "
+      "to run in the foreground, and INVOKE it to run as a background job");
+  RNA_def_property_flag(prop, PropertyFlag(PROP_HIDDEN | PROP_SKIP_SAVE));
+}
+
+int import_files_invoke(bContext *C, wmOperator *op, const wmEvent *event)
+{
+  if (!RNA_struct_property_is_set(op->ptr, "as_background_job")) {
+    RNA_boolean_set(op->ptr, "as_background_job", true);
+  }
+  return filesel_drop_import_invoke(C, op, event);
+}
+
+}  // namespace blender::ed::io
@@ -0,0 +1,49 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup editor/io
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "BLI_vector.hh"
+
+#include "IO_file_import_task.hh"
+
+struct bContext;
+struct wmEvent;
+struct ReportList;
+struct wmOperator;
+struct wmOperatorType;
+
+namespace blender::ed::io {
+
+/**
+ * Run the given file imports. As a background job the files are read on a worker thread with
+ * progress reporting and cancellation, and the results are added to the scene on the main thread
+ * once all files are read. Otherwise everything runs before this function returns.
+ *
+ * \param reports: Used when not running as a background job (the job has its own reports).
+ * \return False if any file failed to import. Always true for background jobs.
+ */
+bool import_files(bContext *C,
+                  const char *job_name,
+                  Vector<std::unique_ptr<blender::io::FileImportTask>> tasks,
+                  bool as_background_job,
+                  ReportList *reports);
+
+/** Define the `as_background_job` property used by #import_files_invoke. */
+void import_files_background_job_property_define(wmOperatorType *ot);
+
+/**
+ * Invoke callback for importers using #import_files: runs the import as a background job unless
+ * the `as_background_job` property is set explicitly, then shows the file browser or import
+ * dialog (see #filesel_drop_import_invoke).
+ */
+int import_files_invoke(bContext *C, wmOperator *op, const wmEvent *event);
+
+}  // namespace blender::ed::io
@@ -41,6 +41,7 @@
 #  include "IO_path_util_types.hh"
 #  include "IO_wavefront_obj.hh"
 
+#  include "io_import_job.hh"
 #  include "io_obj.hh"
 #  include "io_utils.hh"
 
@@ -426,18 +427,17 @@ static int wm_obj_import_exec(bContext *C, wmOperator *op)
     BKE_report(op->reports, RPT_ERROR, "No filepath given");
     return OPERATOR_CANCELLED;
   }
+  blender::Vector<std::unique_ptr<blender::io::FileImportTask>> tasks;
   for (const auto &path : paths) {
     STRNCPY(import_params.filepath, path.c_str());
-    OBJ_import(C, &import_params);
+    tasks.append(OBJ_import_task(&import_params));
     /* Only first import clears selection. */
     import_params.clear_selection = false;
-  };
+  }
 
-  Scene *scene = CTX_data_scene(C);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_SELECT, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_ACTIVE, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_LAYER_CONTENT, scene);
-  ED_outliner_select_sync_from_object_tag(C);
+  const bool as_background_job = RNA_boolean_get(op->ptr, "as_background_job");
+  blender::ed::io::import_files(
+      C, "OBJ Import", std::move(tasks), as_background_job, op->reports);
 
   return OPERATOR_FINISHED;
 }
@@ -479,7 +479,7 @@ void WM_OT_obj_import(wmOperatorType *ot)
   ot->idname = "WM_OT_obj_import";
   ot->flag = OPTYPE_UNDO | OPTYPE_PRESET;
 
-  ot->invoke = blender::ed::io::filesel_drop_import_invoke;
+  ot->invoke = blender::ed::io::import_files_invoke;
   ot->exec = wm_obj_import_exec;
   ot->poll = WM_operator_winactive;
   ot->ui = wm_obj_import_draw;
@@ -548,6 +548,8 @@ void WM_OT_obj_import(wmOperatorType *ot)
                  "Path Separator",
                  "Character used to separate objects name into hierarchical structure");
 
+  blender::ed::io::import_files_background_job_property_define(ot);
+
   /* Only show `.obj` or `.mtl` files by default. */
   prop = RNA_def_string(ot->srna, "filter_glob", "*.obj;*.mtl", 0, "Extension Filter", "");
   RNA_def_property_flag(prop, PROP_HIDDEN);
@@ -34,6 +34,7 @@
 #  include "IO_orientation.hh"
 
 #  include "IO_ply.hh"
+#  include "io_import_job.hh"
 #  include "io_ply_ops.hh"
 #  include "io_utils.hh"
 
@@ -255,6 +256,8 @@ static int wm_ply_import_exec(bContext *C, wmOperator *op)
   params.merge_verts = RNA_boolean_get(op->ptr, "merge_verts");
   params.import_attributes = RNA_boolean_get(op->ptr, "import_attributes");
   params.vertex_colors = ePLYVertexColorMode(RNA_enum_get(op->ptr, "import_colors"));
+  params.import_as_point_cloud = RNA_boolean_get(op->ptr, "import_as_point_cloud");
+  params.point_cloud_voxel_size = RNA_float_get(op->ptr, "point_cloud_voxel_size");
 
   params.reports = op->reports;
 
@@ -264,16 +267,14 @@ static int wm_ply_import_exec(bContext *C, wmOperator *op)
     BKE_report(op->reports, RPT_ERROR, "No filepath given");
     return OPERATOR_CANCELLED;
   }
+  blender::Vector<std::unique_ptr<blender::io::FileImportTask>> tasks;
   for (const auto &path : paths) {
     STRNCPY(params.filepath, path.c_str());
-    PLY_import(C, &params);
-  };
+    tasks.append(PLY_import_task(&params));
+  }
 
-  Scene *scene = CTX_data_scene(C);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_SELECT, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_ACTIVE, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_LAYER_CONTENT, scene);
-  ED_outliner_select_sync_from_object_tag(C);
+  const bool as_background_job = RNA_boolean_get(op->ptr, "as_background_job");
+  blender::ed::io::import_files(C, "PLY Import", std::move(tasks), as_background_job, op->reports);
 
   return OPERATOR_FINISHED;
 }
@@ -295,6 +296,10 @@ static void ui_ply_import_settings(const bContext *C, uiLayout *layout, PointerR
     uiLayout *col = uiLayoutColumn(panel, false);
     uiItemR(col, ptr, "merge_verts", UI_ITEM_NONE, nullptr, ICON_NONE);
     uiItemR(col, ptr, "import_colors", UI_ITEM_NONE, nullptr, ICON_NONE);
+    uiItemR(col, ptr, "import_as_point_cloud", UI_ITEM_NONE, nullptr, ICON_NONE);
+    uiLayout *sub = uiLayoutRow(col, false);
+    uiLayoutSetActive(sub, RNA_boolean_get(ptr, "import_as_point_cloud"));
+    uiItemR(sub, ptr, "point_cloud_voxel_size", UI_ITEM_NONE, nullptr, ICON_NONE);
   }
 }
 
@@ -311,7 +316,7 @@ void WM_OT_ply_import(wmOperatorType *ot)
   ot->description = "Import an PLY file as an object";
   ot->idname = "WM_OT_ply_import";
 
-  ot->invoke = blender::ed::io::filesel_drop_import_invoke;
+  ot->invoke = blender::ed::io::import_files_invoke;
   ot->exec = wm_ply_import_exec;
   ot->ui = wm_ply_import_draw;
   ot->poll = WM_operator_winactive;
@@ -345,6 +350,23 @@ void WM_OT_ply_import(wmOperatorType *ot)
                "Import vertex color attributes");
   RNA_def_boolean(
       ot->srna, "import_attributes", true, "Vertex Attributes", "Import custom vertex attributes");
+  RNA_def_boolean(ot->srna,
+                  "import_as_point_cloud",
+                  false,
+                  "Point Cloud",
+                  "Import files that only contain vertices as a point cloud instead of a mesh");
+  RNA_def_float_distance(ot->srna,
+                         "point_cloud_voxel_size",
+                         0.0f,
+                         0.0f,
+                         FLT_MAX,
+                         "Voxel Size",
+                         "Keep only one point per grid cell of this size when importing a point "
+                         "cloud (zero keeps all points)",
+                         0.0f,
+                         1.0f);
+
+  blender::ed::io::import_files_background_job_property_define(ot);
 
   /* Only show `.ply` files by default. */
   prop = RNA_def_string(ot->srna, "filter_glob", "*.ply", 0, "Extension Filter", "");
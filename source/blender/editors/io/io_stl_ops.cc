@@ -31,6 +31,7 @@
 #  include "UI_resources.hh"
 
 #  include "IO_stl.hh"
+#  include "io_import_job.hh"
 #  include "io_stl_ops.hh"
 #  include "io_utils.hh"
 
@@ -208,16 +209,14 @@ static int wm_stl_import_exec(bContext *C, wmOperator *op)
     BKE_report(op->reports, RPT_ERROR, "No filepath given");
     return OPERATOR_CANCELLED;
   }
+  blender::Vector<std::unique_ptr<blender::io::FileImportTask>> tasks;
   for (const auto &path : paths) {
     STRNCPY(params.filepath, path.c_str());
-    STL_import(C, &params);
+    tasks.append(STL_import_task(&params));
   }
 
-  Scene *scene = CTX_data_scene(C);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_SELECT, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_ACTIVE, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_LAYER_CONTENT, scene);
-  ED_outliner_select_sync_from_object_tag(C);
+  const bool as_background_job = RNA_boolean_get(op->ptr, "as_background_job");
+  blender::ed::io::import_files(C, "STL Import", std::move(tasks), as_background_job, op->reports);
 
   return OPERATOR_FINISHED;
 }
@@ -268,7 +267,7 @@ void WM_OT_stl_import(wmOperatorType *ot)
   ot->description = "Import an STL file as an object";
   ot->idname = "WM_OT_stl_import";
 
-  ot->invoke = blender::ed::io::filesel_drop_import_invoke;
+  ot->invoke = blender::ed::io::import_files_invoke;
   ot->exec = wm_stl_import_exec;
   ot->poll = WM_operator_winactive;
   ot->check = wm_stl_import_check;
@@ -306,6 +305,8 @@ void WM_OT_stl_import(wmOperatorType *ot)
       "Ensure the data is valid "
       "(when disabled, data may be imported which causes crashes displaying or editing)");
 
+  blender::ed::io::import_files_background_job_property_define(ot);
+
   /* Only show `.stl` files by default. */
   prop = RNA_def_string(ot->srna, "filter_glob", "*.stl", 0, "Extension Filter", "");
   RNA_def_property_flag(prop, PROP_HIDDEN);
@@ -32,6 +32,7 @@
 
 #  include "IO_ueformat.hh"
 
+#  include "io_import_job.hh"
 #  include "io_ueformat_ops.hh"
 #  include "io_utils.hh"
 
@@ -49,18 +50,17 @@ static int wm_ueformat_import_exec(bContext *C, wmOperator *op)
     BKE_report(op->reports, RPT_ERROR, "No filepath given");
     return OPERATOR_CANCELLED;
   }
+  blender::Vector<std::unique_ptr<blender::io::FileImportTask>> tasks;
   for (const auto &path : paths) {
     STRNCPY(import_params.filepath, path.c_str());
-    UEFORMAT_import(C, &import_params);
+    tasks.append(UEFORMAT_import_task(&import_params));
     /* Only first import clears selection. */
     //import_params.clear_selection = false;
   }
 
-  Scene *scene = CTX_data_scene(C);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_SELECT, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_OB_ACTIVE, scene);
-  WM_event_add_notifier(C, NC_SCENE | ND_LAYER_CONTENT, scene);
-  ED_outliner_select_sync_from_object_tag(C);
+  const bool as_background_job = RNA_boolean_get(op->ptr, "as_background_job");
+  blender::ed::io::import_files(
+      C, "UEFORMAT Import", std::move(tasks), as_background_job, op->reports);
 
   return OPERATOR_FINISHED;
 }
@@ -92,7 +92,7 @@ void WM_OT_ueformat_import(wmOperatorType *ot)
   ot->idname = "WM_OT_ueformat_import";
   ot->flag = OPTYPE_UNDO | OPTYPE_PRESET;
 
-  ot->invoke = blender::ed::io::filesel_drop_import_invoke;
+  ot->invoke = blender::ed::io::import_files_invoke;
   ot->exec = wm_ueformat_import_exec;
   ot->poll = WM_operator_winactive;
   ot->ui = wm_ueformat_import_draw;
@@ -118,6 +118,8 @@ void WM_OT_ueformat_import(wmOperatorType *ot)
         0.0001f,
         10000.0f);
 
+  blender::ed::io::import_files_background_job_property_define(ot);
+
   prop = RNA_def_string(ot->srna, "filter_glob", "*.uemodel;*.ueanim;*.ueworld", 0, "Extension Filter", "");
   RNA_def_property_flag(prop, PROP_HIDDEN);
 }
@@ -4,15 +4,69 @@
 
 #pragma once
 
+#include <string>
+
+#include "BLI_implicit_sharing_ptr.hh"
+#include "BLI_map.hh"
+
 #include "BKE_anonymous_attribute_id.hh"
 #include "BKE_geometry_set.hh"
 
 namespace blender::geometry {
 
+/**
+ * Remembers the arrays created by previous #join_attributes and #join_geometries calls, together
+ * with weak references to the source arrays they were joined from. When the same attributes are
+ * joined again, e.g. on the next frame, an array whose sources are all unchanged is shared instead
+ * of copied. Otherwise only the parts of the array that belong to changed sources are copied.
+ *
+ * For point clouds, meshes and curves, generic attributes and the built-in arrays that
+ * #realize_instances only copies (positions, radii, mesh topology and face and curve offsets) are
+ * cached. The cached arrays are passed to #realize_instances with
+ * #RealizeInstancesOptions::joined_attributes, so the attributes are in the same order as without
+ * the cache. The remaining attributes are joined by #realize_instances as usual.
+ *
+ * The cache keeps a reference to every joined array, so after the joined geometry has been freed,
+ * the arrays use as much memory as the geometry did. See #unshared_memory_size.
+ *
+ * The cache must not be used by multiple threads at the same time.
+ */
+struct JoinAttributesCache : NonCopyable, NonMovable {
+  struct Source {
+    /** Weak user of the source array, null if the source array can't be tracked. */
+    const ImplicitSharingInfo *sharing_info = nullptr;
+    int64_t version = 0;
+    int size = 0;
+    /** Added to the values of indices, the start of the source in the domain they index. */
+    int index_offset = 0;
+    /** The source component does not have the attribute, so default values are used. */
+    bool is_default = false;
+  };
+
+  struct Attribute {
+    eCustomDataType data_type;
+    bke::AttrDomain domain;
+    Vector<Source> sources;
+    ImplicitSharingPtrAndData data;
+  };
+
+  /** Attributes by the type of the joined component and the attribute name. */
+  Map<std::pair<bke::GeometryComponent::Type, std::string>, Attribute> attributes;
+
+  ~JoinAttributesCache();
+
+  /** Size in bytes of the joined arrays that are not used by anything but the cache. */
+  int64_t unshared_memory_size() const;
+  /** Forget the joined arrays that are not used by anything but the cache to free them. */
+  void remove_unshared();
+};
+
 bke::GeometrySet join_geometries(Span<bke::GeometrySet> geometries,
-                                 const bke::AnonymousAttributePropagationInfo &propagation_info);
+                                 const bke::AnonymousAttributePropagationInfo &propagation_info,
+                                 JoinAttributesCache *cache = nullptr);
 
 void join_attributes(const Span<const bke::GeometryComponent *> src_components,
                      bke::GeometryComponent &r_result,
-                     const Span<StringRef> ignored_attributes = {});
+                     const Span<StringRef> ignored_attributes = {},
+                     JoinAttributesCache *cache = nullptr);
 }  // namespace blender::geometry
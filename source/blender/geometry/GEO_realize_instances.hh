@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include "BLI_function_ref.hh"
+#include "BLI_implicit_sharing_ptr.hh"
+#include "BLI_map.hh"
+
 #include "BKE_geometry_set.hh"
 
 namespace blender::geometry {
@@ -24,6 +28,24 @@ struct RealizeInstancesOptions {
    * instances. Otherwise, instance attributes are ignored.
    */
   bool realize_instance_attributes = true;
+  /**
+   * Generic attributes of realized point clouds, meshes and curves that the caller has joined
+   * already, by the component type and attribute name. Their arrays are shared with the result
+   * instead of copying the values from the instances, and must have the size of the attribute
+   * domain in the result. Attributes with a different domain or type are realized as usual.
+   *
+   * Some built-in arrays can be joined too: "position" and "radius", the mesh topology
+   * (".edge_verts", ".corner_vert" and ".corner_edge") and the offsets of faces and curves
+   * (".face_offsets" and ".curve_offsets" on the face and curve domain, with one more element).
+   * Since they are not transformed, they may only be passed when all instance transforms are
+   * the identity.
+   */
+  struct JoinedAttribute {
+    bke::AttrDomain domain;
+    eCustomDataType data_type;
+    ImplicitSharingPtrAndData data;
+  };
+  Map<std::pair<bke::GeometryComponent::Type, std::string>, JoinedAttribute> joined_attributes;
 
   bke::AnonymousAttributePropagationInfo propagation_info;
 };
@@ -69,4 +91,25 @@ bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
                                    const RealizeInstancesOptions &options,
                                    const VariedDepthOptions &varied_depth_option);
 
+/**
+ * Same as #realize_instances, but the top-level instances are realized in batches, so that the
+ * realized geometry of all instances never has to exist at the same time. This is useful when the
+ * caller consumes the geometry incrementally, e.g. when exporting it, and the fully realized
+ * geometry would not fit into memory.
+ *
+ * Batches contain consecutive top-level instances. The geometry that is not instanced is part of
+ * the first batch. Ids are generated the same way as in #realize_instances. Every batch has the
+ * same attributes and materials as the fully realized geometry, so joining the batches gives the
+ * same result as #realize_instances. The instanced geometry is only preprocessed once for all
+ * batches. #RealizeInstancesOptions::joined_attributes are not supported.
+ *
+ * \param memory_budget: Approximate number of bytes that the realized attributes of a batch may
+ * use. Batches contain at least one instance, even if it exceeds the budget on its own.
+ * \param fn: Called with the realized geometry of every batch, in instance order.
+ */
+void realize_instances_in_batches(bke::GeometrySet geometry_set,
+                                  const RealizeInstancesOptions &options,
+                                  int64_t memory_budget,
+                                  FunctionRef<void(bke::GeometrySet batch)> fn);
+
 }  // namespace blender::geometry
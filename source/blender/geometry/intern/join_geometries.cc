@@ -7,7 +7,11 @@
 #include "GEO_join_geometries.hh"
 #include "GEO_realize_instances.hh"
 
+#include "BKE_curves.hh"
 #include "BKE_instances.hh"
+#include "BKE_mesh.hh"
+
+#include "MEM_guardedalloc.h"
 
 namespace blender::geometry {
 
@@ -73,13 +77,469 @@ static void fill_new_attribute(const Span<const GeometryComponent *> src_compone
   }
 }
 
+static void remove_weak_users(const JoinAttributesCache::Attribute &attribute)
+{
+  for (const JoinAttributesCache::Source &source : attribute.sources) {
+    if (source.sharing_info) {
+      source.sharing_info->remove_weak_user_and_delete_if_last();
+    }
+  }
+}
+
+JoinAttributesCache::~JoinAttributesCache()
+{
+  for (const Attribute &attribute : this->attributes.values()) {
+    remove_weak_users(attribute);
+  }
+}
+
+static bool is_unshared(const JoinAttributesCache::Attribute &attribute)
+{
+  return attribute.data.sharing_info->is_mutable();
+}
+
+int64_t JoinAttributesCache::unshared_memory_size() const
+{
+  int64_t size = 0;
+  for (const Attribute &attribute : this->attributes.values()) {
+    if (!is_unshared(attribute)) {
+      continue;
+    }
+    const CPPType &type = *bke::custom_data_type_to_cpp_type(attribute.data_type);
+    for (const Source &source : attribute.sources) {
+      size += type.size() * source.size;
+    }
+  }
+  return size;
+}
+
+void JoinAttributesCache::remove_unshared()
+{
+  this->attributes.remove_if([](const auto &item) {
+    if (!is_unshared(item.value)) {
+      return false;
+    }
+    remove_weak_users(item.value);
+    return true;
+  });
+}
+
+static bool source_is_unchanged(const JoinAttributesCache::Source &old_source,
+                                const JoinAttributesCache::Source &new_source)
+{
+  if (old_source.size != new_source.size || old_source.index_offset != new_source.index_offset) {
+    return false;
+  }
+  if (old_source.is_default || new_source.is_default) {
+    return old_source.is_default && new_source.is_default;
+  }
+  /* The old sharing info can't be freed while there is a weak user, so if the pointers are the
+   * same, it is the same array. */
+  return new_source.sharing_info != nullptr &&
+         old_source.sharing_info == new_source.sharing_info &&
+         old_source.version == new_source.version;
+}
+
+static void add_shared_attribute(GeometryComponent &result,
+                                 const AttributeIDRef &attribute_id,
+                                 const AttributeMetaData &meta_data,
+                                 const ImplicitSharingPtrAndData &data,
+                                 const int64_t size)
+{
+  bke::MutableAttributeAccessor attributes = *result.attributes_for_write();
+  if (!attributes.contains(attribute_id) &&
+      attributes.add(attribute_id,
+                     meta_data.domain,
+                     meta_data.data_type,
+                     bke::AttributeInitShared(data.data, *data.sharing_info)))
+  {
+    return;
+  }
+  /* Attributes that exist already, like builtin attributes, are copied so that the order of the
+   * attributes is the same as without the cache. */
+  bke::GSpanAttributeWriter write_attribute = attributes.lookup_or_add_for_write_only_span(
+      attribute_id, meta_data.domain, meta_data.data_type);
+  if (write_attribute) {
+    write_attribute.span.type().copy_assign_n(data.data, write_attribute.span.data(), size);
+    write_attribute.finish();
+  }
+}
+
+static void add_index_offset(GMutableSpan values, const int offset)
+{
+  if (offset == 0) {
+    return;
+  }
+  if (values.type().is<int>()) {
+    for (int &value : values.typed<int>()) {
+      value += offset;
+    }
+  }
+  else if (values.type().is<int2>()) {
+    for (int2 &value : values.typed<int2>()) {
+      value += offset;
+    }
+  }
+  else {
+    BLI_assert_unreachable();
+  }
+}
+
+/**
+ * Join the arrays of the sources into the array of the cache, reusing the previous array where
+ * possible.
+ * \param get_values: Values of a source that isn't #Source::is_default, in the joined type.
+ * \param default_value: Value for sources without the array, null for the default of the type.
+ * \param offsets_total: For offsets arrays, the last value after the values of all sources.
+ */
+static void join_array_cached(const std::pair<GeometryComponent::Type, std::string> &key,
+                              const AttributeMetaData &meta_data,
+                              Vector<JoinAttributesCache::Source> sources,
+                              const FunctionRef<GVArray(int source_index)> get_values,
+                              const void *default_value,
+                              const std::optional<int> offsets_total,
+                              JoinAttributesCache &cache)
+{
+  using Source = JoinAttributesCache::Source;
+  const CPPType &type = *bke::custom_data_type_to_cpp_type(meta_data.data_type);
+
+  Array<int> offsets_data(sources.size() + 1);
+  for (const int i : sources.index_range()) {
+    offsets_data[i] = sources[i].size;
+  }
+  const OffsetIndices offsets = offset_indices::accumulate_counts_to_offsets(offsets_data);
+  const int64_t size = offsets.total_size() + (offsets_total ? 1 : 0);
+
+  JoinAttributesCache::Attribute *cached = cache.attributes.lookup_ptr(key);
+  const bool layout_matches = cached && cached->data_type == meta_data.data_type &&
+                              cached->domain == meta_data.domain &&
+                              cached->sources.size() == sources.size() &&
+                              std::equal(sources.begin(),
+                                         sources.end(),
+                                         cached->sources.begin(),
+                                         [](const Source &a, const Source &b) {
+                                           return a.size == b.size;
+                                         });
+  Array<bool> changed(sources.size(), true);
+  if (layout_matches) {
+    for (const int i : sources.index_range()) {
+      changed[i] = !source_is_unchanged(cached->sources[i], sources[i]);
+    }
+    const bool total_matches = !offsets_total ||
+                               static_cast<const int *>(cached->data.data)[size - 1] ==
+                                   *offsets_total;
+    if (!changed.as_span().contains(true) && total_matches) {
+      return;
+    }
+  }
+
+  ImplicitSharingPtrAndData data;
+  if (layout_matches && cached->data.sharing_info->is_mutable()) {
+    /* The previous result isn't used anymore, so it can be updated in place. */
+    data = std::move(cached->data);
+    data.sharing_info->tag_ensured_mutable();
+  }
+  else {
+    void *buffer = MEM_mallocN_aligned(size * type.size(), type.alignment(), __func__);
+    type.default_construct_n(buffer, size);
+    data = ImplicitSharingPtrAndData(
+        ImplicitSharingPtr<ImplicitSharingInfo>(implicit_sharing::info_for_mem_free(buffer)),
+        buffer);
+    if (layout_matches) {
+      for (const int i : sources.index_range()) {
+        if (!changed[i]) {
+          type.copy_assign_n(POINTER_OFFSET(cached->data.data, type.size() * offsets[i].start()),
+                             POINTER_OFFSET(buffer, type.size() * offsets[i].start()),
+                             offsets[i].size());
+        }
+      }
+    }
+  }
+
+  GMutableSpan dst_span(type, const_cast<void *>(data.data), size);
+  if (offsets_total) {
+    dst_span.typed<int>().last() = *offsets_total;
+  }
+  for (const int i : sources.index_range()) {
+    if (!changed[i] || offsets[i].is_empty()) {
+      continue;
+    }
+    GMutableSpan dst = dst_span.slice(offsets[i]);
+    if (sources[i].is_default) {
+      type.fill_assign_n(
+          default_value ? default_value : type.default_value(), dst.data(), dst.size());
+      continue;
+    }
+    const GVArray src = get_values(i);
+    const int index_offset = sources[i].index_offset;
+    threading::parallel_for(IndexRange(dst.size()), 4096, [&](const IndexRange range) {
+      src.materialize(range, dst.data());
+      add_index_offset(dst.slice(range), index_offset);
+    });
+  }
+
+  if (cached) {
+    remove_weak_users(*cached);
+  }
+  for (const Source &source : sources) {
+    if (source.sharing_info) {
+      source.sharing_info->add_weak_user();
+    }
+  }
+  cache.attributes.add_overwrite(
+      key, {meta_data.data_type, meta_data.domain, std::move(sources), std::move(data)});
+}
+
+/**
+ * Start indices of the components in the joined domain, used to offset indices into it.
+ */
+static Array<int> domain_start_indices(const Span<const GeometryComponent *> components,
+                                       const bke::AttrDomain domain)
+{
+  Array<int> starts(components.size());
+  int start = 0;
+  for (const int i : components.index_range()) {
+    starts[i] = start;
+    start += components[i]->attribute_domain_size(domain);
+  }
+  return starts;
+}
+
+/**
+ * Join the attribute into the array of the cache.
+ * \param index_domain: If set, the values are indices into this domain, and the start index of
+ * each component in it is added.
+ */
+static void join_attribute_cached(const Span<const GeometryComponent *> src_components,
+                                  const AttributeIDRef &attribute_id,
+                                  const AttributeMetaData &meta_data,
+                                  const GeometryComponent::Type component_type,
+                                  JoinAttributesCache &cache,
+                                  const std::optional<bke::AttrDomain> index_domain = {},
+                                  const void *default_value = nullptr)
+{
+  const CPPType &type = *bke::custom_data_type_to_cpp_type(meta_data.data_type);
+  const Array<int> index_offsets = index_domain ?
+                                       domain_start_indices(src_components, *index_domain) :
+                                       Array<int>(src_components.size(), 0);
+
+  Vector<JoinAttributesCache::Source> sources(src_components.size());
+  for (const int i : src_components.index_range()) {
+    const GeometryComponent &component = *src_components[i];
+    JoinAttributesCache::Source &source = sources[i];
+    source.size = component.attribute_domain_size(meta_data.domain);
+    source.index_offset = index_offsets[i];
+    const bke::GAttributeReader src = component.attributes()->lookup(attribute_id);
+    if (!src) {
+      source.is_default = true;
+    }
+    else if (src.sharing_info && src.domain == meta_data.domain && src.varray.type() == type) {
+      source.sharing_info = src.sharing_info;
+      source.version = src.sharing_info->version();
+    }
+  }
+
+  join_array_cached(
+      {component_type, attribute_id.name()},
+      meta_data,
+      std::move(sources),
+      [&](const int i) {
+        return *src_components[i]->attributes()->lookup(
+            attribute_id, meta_data.domain, meta_data.data_type);
+      },
+      default_value,
+      std::nullopt,
+      cache);
+}
+
+/**
+ * Join offsets arrays into the array of the cache. It has one more element than the domain.
+ * \param get_offsets: The offsets of the component and their sharing info.
+ */
+static void join_offsets_cached(
+    const Span<const GeometryComponent *> src_components,
+    const StringRef name,
+    const bke::AttrDomain domain,
+    const bke::AttrDomain index_domain,
+    const GeometryComponent::Type component_type,
+    const FunctionRef<std::pair<Span<int>, const ImplicitSharingInfo *>(
+        const GeometryComponent &component)> get_offsets,
+    JoinAttributesCache &cache)
+{
+  const Array<int> index_offsets = domain_start_indices(src_components, index_domain);
+
+  Vector<JoinAttributesCache::Source> sources(src_components.size());
+  for (const int i : src_components.index_range()) {
+    JoinAttributesCache::Source &source = sources[i];
+    source.size = src_components[i]->attribute_domain_size(domain);
+    source.index_offset = index_offsets[i];
+    source.sharing_info = get_offsets(*src_components[i]).second;
+    if (source.sharing_info) {
+      source.version = source.sharing_info->version();
+    }
+  }
+  const int total = index_offsets.last() +
+                    src_components.last()->attribute_domain_size(index_domain);
+
+  join_array_cached(
+      {component_type, name},
+      {domain, CD_PROP_INT32},
+      std::move(sources),
+      [&](const int i) {
+        return VArray<int>::ForSpan(get_offsets(*src_components[i]).first.drop_back(1));
+      },
+      nullptr,
+      total,
+      cache);
+}
+
+/**
+ * Join the built-in arrays that #realize_instances would only copy with the cache, see
+ * #RealizeInstancesOptions::joined_attributes.
+ * \return The names of the joined arrays.
+ */
+static Vector<std::string> join_builtin_arrays_cached(
+    const Span<const GeometryComponent *> components,
+    const GeometryComponent::Type component_type,
+    JoinAttributesCache &cache)
+{
+  using bke::AttrDomain;
+  Vector<std::string> names;
+  const auto join_attribute = [&](const StringRef name,
+                                  const AttrDomain domain,
+                                  const eCustomDataType data_type,
+                                  const std::optional<AttrDomain> index_domain,
+                                  const void *default_value) {
+    join_attribute_cached(
+        components, name, {domain, data_type}, component_type, cache, index_domain, default_value);
+    names.append(name);
+  };
+  /* The radius is only added to the result when any component has it. */
+  const bool has_radius = std::any_of(
+      components.begin(), components.end(), [](const GeometryComponent *component) {
+        return component->attributes()->contains("radius");
+      });
+
+  switch (component_type) {
+    case GeometryComponent::Type::Mesh: {
+      join_attribute("position", AttrDomain::Point, CD_PROP_FLOAT3, std::nullopt, nullptr);
+      join_attribute(
+          ".edge_verts", AttrDomain::Edge, CD_PROP_INT32_2D, AttrDomain::Point, nullptr);
+      join_attribute(
+          ".corner_vert", AttrDomain::Corner, CD_PROP_INT32, AttrDomain::Point, nullptr);
+      join_attribute(
+          ".corner_edge", AttrDomain::Corner, CD_PROP_INT32, AttrDomain::Edge, nullptr);
+      join_offsets_cached(components,
+                          ".face_offsets",
+                          AttrDomain::Face,
+                          AttrDomain::Corner,
+                          component_type,
+                          [](const GeometryComponent &component) {
+                            const Mesh &mesh =
+                                *static_cast<const bke::MeshComponent &>(component).get();
+                            return std::make_pair(mesh.face_offsets(),
+                                                  mesh.runtime->face_offsets_sharing_info);
+                          },
+                          cache);
+      names.append(".face_offsets");
+      break;
+    }
+    case GeometryComponent::Type::PointCloud: {
+      join_attribute("position", AttrDomain::Point, CD_PROP_FLOAT3, std::nullopt, nullptr);
+      if (has_radius) {
+        /* Same default as in #realize_instances. */
+        static const float default_radius = 0.01f;
+        join_attribute("radius", AttrDomain::Point, CD_PROP_FLOAT, std::nullopt, &default_radius);
+      }
+      break;
+    }
+    case GeometryComponent::Type::Curve: {
+      join_attribute("position", AttrDomain::Point, CD_PROP_FLOAT3, std::nullopt, nullptr);
+      if (has_radius) {
+        static const float default_radius = 1.0f;
+        join_attribute("radius", AttrDomain::Point, CD_PROP_FLOAT, std::nullopt, &default_radius);
+      }
+      join_offsets_cached(components,
+                          ".curve_offsets",
+                          AttrDomain::Curve,
+                          AttrDomain::Point,
+                          component_type,
+                          [](const GeometryComponent &component) {
+                            const bke::CurvesGeometry &curves =
+                                static_cast<const bke::CurveComponent &>(component)
+                                    .get()
+                                    ->geometry.wrap();
+                            return std::make_pair(curves.offsets(),
+                                                  curves.runtime->curve_offsets_sharing_info);
+                          },
+                          cache);
+      names.append(".curve_offsets");
+      break;
+    }
+    default:
+      BLI_assert_unreachable();
+      break;
+  }
+  return names;
+}
+
+/**
+ * Forget the cached arrays of the component type that are not joined anymore.
+ */
+static void remove_unused_cached_arrays(const GeometryComponent::Type component_type,
+                                        const FunctionRef<bool(StringRef name)> is_used,
+                                        JoinAttributesCache &cache)
+{
+  using Key = std::pair<GeometryComponent::Type, std::string>;
+  Vector<Key> removed_keys;
+  for (const MapItem<Key, JoinAttributesCache::Attribute> item : cache.attributes.items()) {
+    if (item.key.first == component_type && !is_used(item.key.second)) {
+      remove_weak_users(item.value);
+      removed_keys.append(item.key);
+    }
+  }
+  for (const Key &key : removed_keys) {
+    cache.attributes.remove(key);
+  }
+}
+
+/**
+ * Join the given attributes into the arrays of the cache.
+ */
+static void join_attributes_cached(const Span<const GeometryComponent *> src_components,
+                                   const Map<AttributeIDRef, AttributeMetaData> &info,
+                                   const GeometryComponent::Type component_type,
+                                   JoinAttributesCache &cache)
+{
+  for (const MapItem<AttributeIDRef, AttributeMetaData> item : info.items()) {
+    join_attribute_cached(src_components, item.key, item.value, component_type, cache);
+  }
+}
+
 void join_attributes(const Span<const GeometryComponent *> src_components,
                      GeometryComponent &result,
-                     const Span<StringRef> ignored_attributes)
+                     const Span<StringRef> ignored_attributes,
+                     JoinAttributesCache *cache)
 {
   const Map<AttributeIDRef, AttributeMetaData> info = get_final_attribute_info(src_components,
                                                                                ignored_attributes);
 
+  if (cache) {
+    remove_unused_cached_arrays(
+        result.type(), [&](const StringRef name) { return info.contains(name); }, *cache);
+    join_attributes_cached(src_components, info, result.type(), *cache);
+    for (const MapItem<AttributeIDRef, AttributeMetaData> item : info.items()) {
+      const JoinAttributesCache::Attribute &attribute = cache->attributes.lookup(
+          {result.type(), item.key.name()});
+      add_shared_attribute(result,
+                           item.key,
+                           item.value,
+                           attribute.data,
+                           result.attribute_domain_size(item.value.domain));
+    }
+    return;
+  }
+
   for (const MapItem<AttributeIDRef, AttributeMetaData> item : info.items()) {
     const AttributeIDRef attribute_id = item.key;
     const AttributeMetaData &meta_data = item.value;
@@ -97,7 +557,8 @@ void join_attributes(const Span<const GeometryComponent *> src_components,
 }
 
 static void join_instances(const Span<const GeometryComponent *> src_components,
-                           GeometrySet &result)
+                           GeometrySet &result,
+                           JoinAttributesCache *cache)
 {
   Array<int> offsets_data(src_components.size() + 1);
   for (const int i : src_components.index_range()) {
@@ -129,7 +590,7 @@ static void join_instances(const Span<const GeometryComponent *> src_components,
 
   result.replace_instances(dst_instances.release());
   auto &dst_component = result.get_component_for_write<bke::InstancesComponent>();
-  join_attributes(src_components, dst_component, {".reference_index"});
+  join_attributes(src_components, dst_component, {".reference_index"}, cache);
 }
 
 static void join_volumes(const Span<const GeometryComponent *> /*src_components*/,
@@ -139,9 +600,34 @@ static void join_volumes(const Span<const GeometryComponent *> /*src_components*
    * of the grids. The cell size of the resulting volume has to be determined somehow. */
 }
 
+/**
+ * Generic attributes that #realize_instances would join by copying them without any changes, so
+ * that they can be joined with the cache instead.
+ */
+static Map<AttributeIDRef, AttributeMetaData> get_cacheable_attribute_info(
+    const Span<const GeometryComponent *> components,
+    const GeometryComponent::Type component_type,
+    const bke::AnonymousAttributePropagationInfo &propagation_info)
+{
+  const bke::GeometryComponentPtr dummy_component = GeometryComponent::create(component_type);
+  const bke::AttributeAccessor dummy_attributes = *dummy_component->attributes();
+  Map<AttributeIDRef, AttributeMetaData> info = get_final_attribute_info(components, {"id"});
+  info.remove_if([&](const auto &item) {
+    if (dummy_attributes.is_builtin(item.key)) {
+      return true;
+    }
+    if (item.key.is_anonymous() && !propagation_info.propagate(item.key.anonymous_id())) {
+      return true;
+    }
+    return false;
+  });
+  return info;
+}
+
 static void join_component_type(const bke::GeometryComponent::Type component_type,
                                 const Span<GeometrySet> src_geometry_sets,
                                 const bke::AnonymousAttributePropagationInfo &propagation_info,
+                                JoinAttributesCache *cache,
                                 GeometrySet &result)
 {
   Vector<const GeometryComponent *> components;
@@ -162,7 +648,7 @@ static void join_component_type(const bke::GeometryComponent::Type component_typ
 
   switch (component_type) {
     case bke::GeometryComponent::Type::Instance:
-      join_instances(components, result);
+      join_instances(components, result, cache);
       return;
     case bke::GeometryComponent::Type::Volume:
       join_volumes(components, result);
@@ -185,13 +671,38 @@ static void join_component_type(const bke::GeometryComponent::Type component_typ
   options.keep_original_ids = true;
   options.realize_instance_attributes = false;
   options.propagation_info = propagation_info;
+
+  /* Edit data components have no attributes. */
+  const bool use_cache = cache && ELEM(component_type,
+                                       GeometryComponent::Type::Mesh,
+                                       GeometryComponent::Type::PointCloud,
+                                       GeometryComponent::Type::Curve);
+  if (use_cache) {
+    const Map<AttributeIDRef, AttributeMetaData> cached_attributes = get_cacheable_attribute_info(
+        components, component_type, propagation_info);
+    Vector<std::string> names = join_builtin_arrays_cached(components, component_type, *cache);
+    join_attributes_cached(components, cached_attributes, component_type, *cache);
+    for (const AttributeIDRef &attribute_id : cached_attributes.keys()) {
+      names.append(attribute_id.name());
+    }
+    remove_unused_cached_arrays(
+        component_type, [&](const StringRef name) { return names.contains(name); }, *cache);
+    for (const std::string &name : names) {
+      const std::pair<GeometryComponent::Type, std::string> key(component_type, name);
+      const JoinAttributesCache::Attribute &attribute = cache->attributes.lookup(key);
+      options.joined_attributes.add_new(key,
+                                        {attribute.domain, attribute.data_type, attribute.data});
+    }
+  }
+
   GeometrySet joined_components = realize_instances(
       GeometrySet::from_instances(instances.release()), options);
   result.add(joined_components.get_component_for_write(component_type));
 }
 
 GeometrySet join_geometries(const Span<GeometrySet> geometries,
-                            const bke::AnonymousAttributePropagationInfo &propagation_info)
+                            const bke::AnonymousAttributePropagationInfo &propagation_info,
+                            JoinAttributesCache *cache)
 {
   GeometrySet result;
   static const Array<GeometryComponent::Type> supported_types({GeometryComponent::Type::Mesh,
@@ -201,7 +712,7 @@ GeometrySet join_geometries(const Span<GeometrySet> geometries,
                                                                GeometryComponent::Type::Curve,
                                                                GeometryComponent::Type::Edit});
   for (const GeometryComponent::Type type : supported_types) {
-    join_component_type(type, geometries, propagation_info, result);
+    join_component_type(type, geometries, propagation_info, cache, result);
   }
 
   return result;
@@ -53,7 +53,7 @@ struct AttributeFallbacksArray {
   /**
    * Instance attribute values used as fallback when the geometry does not have the
    * corresponding attributes itself. The pointers point to attributes stored in the instances
-   * component or in #r_temporary_arrays. The order depends on the corresponding #OrderedAttributes
+   * component or in #r_converted_arrays. The order depends on the corresponding #OrderedAttributes
    * instance.
    */
   Array<const void *> array;
@@ -264,10 +264,11 @@ struct GatherTasksInfo {
   /**
    * Under some circumstances, temporary arrays need to be allocated during the gather operation.
    * For example, when an instance attribute has to be realized as a different data type. This
-   * array owns all the temporary arrays so that they can live until all processing is done.
+   * map owns all the converted arrays so that they can live until all processing is done. They
+   * are stored by the source array and the new type, so that every array is only converted once.
    * Use #std::unique_ptr to avoid depending on whether #GArray has an inline buffer or not.
    */
-  Vector<std::unique_ptr<GArray<>>> &r_temporary_arrays;
+  Map<std::pair<const void *, const CPPType *>, std::unique_ptr<GArray<>>> &r_converted_arrays;
 
   AllInstancesInfo instances;
 
@@ -394,6 +395,10 @@ static void copy_generic_attributes_to_result(
   threading::parallel_for(
       dst_attribute_writers.index_range(), 10, [&](const IndexRange attribute_range) {
         for (const int attribute_index : attribute_range) {
+          if (!dst_attribute_writers[attribute_index]) {
+            /* The attribute has been joined already. */
+            continue;
+          }
           const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
           const IndexRange element_slice = range_fn(domain);
 
@@ -488,11 +493,13 @@ static Vector<std::pair<int, GSpan>> prepare_attribute_fallbacks(
         return true;
       }
       /* Convert the attribute on the instances component to the expected attribute type. */
-      std::unique_ptr<GArray<>> temporary_array = std::make_unique<GArray<>>(
-          to_type, instances.instances_num());
-      conversions.convert_to_initialized_n(span, temporary_array->as_mutable_span());
-      span = temporary_array->as_span();
-      gather_info.r_temporary_arrays.append(std::move(temporary_array));
+      std::unique_ptr<GArray<>> &converted_array = gather_info.r_converted_arrays.lookup_or_add_cb(
+          {span.data(), &to_type}, [&]() {
+            auto array = std::make_unique<GArray<>>(to_type, instances.instances_num());
+            conversions.convert_to_initialized_n(span, array->as_mutable_span());
+            return array;
+          });
+      span = converted_array->as_span();
     }
     attributes_to_override.append({attribute_index, span});
     return true;
@@ -879,6 +886,76 @@ static void gather_attributes_for_propagation(
                     });
 }
 
+/**
+ * Add the attribute from #RealizeInstancesOptions::joined_attributes to the result, if there is
+ * one with the same domain and type.
+ * \return False if the attribute has to be realized from the instances instead.
+ */
+static bool add_joined_attribute(const RealizeInstancesOptions &options,
+                                 const bke::GeometryComponent::Type component_type,
+                                 const AttributeIDRef &attribute_id,
+                                 const AttributeKind &kind,
+                                 bke::MutableAttributeAccessor dst_attributes)
+{
+  const RealizeInstancesOptions::JoinedAttribute *joined = options.joined_attributes.lookup_ptr(
+      {component_type, attribute_id.name()});
+  if (joined == nullptr || joined->domain != kind.domain || joined->data_type != kind.data_type) {
+    return false;
+  }
+  return dst_attributes.add(
+      attribute_id,
+      kind.domain,
+      kind.data_type,
+      bke::AttributeInitShared(joined->data.data, *joined->data.sharing_info));
+}
+
+/**
+ * Replace a built-in attribute that the result has already with the array from
+ * #RealizeInstancesOptions::joined_attributes, if there is one.
+ * \return False if the attribute has to be realized from the instances instead.
+ */
+static bool replace_with_joined_attribute(const RealizeInstancesOptions &options,
+                                          const bke::GeometryComponent::Type component_type,
+                                          const StringRef name,
+                                          const AttributeKind &kind,
+                                          CustomData &custom_data,
+                                          const int size,
+                                          bke::MutableAttributeAccessor dst_attributes)
+{
+  const RealizeInstancesOptions::JoinedAttribute *joined = options.joined_attributes.lookup_ptr(
+      {component_type, name});
+  if (joined == nullptr || joined->domain != kind.domain || joined->data_type != kind.data_type) {
+    return false;
+  }
+  CustomData_free_layer_named(&custom_data, name, size);
+  return add_joined_attribute(options, component_type, name, kind, dst_attributes);
+}
+
+/**
+ * Share the offsets array from #RealizeInstancesOptions::joined_attributes with the result, if
+ * there is one. It is stored with the name of the offsets and the domain they are offsets for.
+ * \return False if the offsets have to be realized from the instances instead.
+ */
+static bool replace_with_joined_offsets(const RealizeInstancesOptions &options,
+                                        const bke::GeometryComponent::Type component_type,
+                                        const StringRef name,
+                                        const AttrDomain domain,
+                                        int **offsets,
+                                        const ImplicitSharingInfo **sharing_info)
+{
+  const RealizeInstancesOptions::JoinedAttribute *joined = options.joined_attributes.lookup_ptr(
+      {component_type, name});
+  if (joined == nullptr || joined->domain != domain || joined->data_type != CD_PROP_INT32) {
+    return false;
+  }
+  implicit_sharing::free_shared_data(offsets, sharing_info);
+  implicit_sharing::copy_shared_pointer(static_cast<int *>(const_cast<void *>(joined->data.data)),
+                                        joined->data.sharing_info.get(),
+                                        offsets,
+                                        sharing_info);
+  return true;
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1117,8 +1194,10 @@ static void execute_realize_pointcloud_task(
   const PointCloud &pointcloud = *pointcloud_info.pointcloud;
   const IndexRange point_slice{task.start_index, pointcloud.totpoint};
 
-  copy_transformed_positions(
-      pointcloud_info.positions, task.transform, all_dst_positions.slice(point_slice));
+  if (!all_dst_positions.is_empty()) {
+    copy_transformed_positions(
+        pointcloud_info.positions, task.transform, all_dst_positions.slice(point_slice));
+  }
 
   /* Create point ids. */
   if (!all_dst_ids.is_empty()) {
@@ -1165,8 +1244,18 @@ static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &opti
   dst_pointcloud->mat = static_cast<Material **>(MEM_dupallocN(first_pointcloud.mat));
   dst_pointcloud->totcol = first_pointcloud.totcol;
 
-  SpanAttributeWriter<float3> positions = dst_attributes.lookup_or_add_for_write_only_span<float3>(
-      "position", bke::AttrDomain::Point);
+  SpanAttributeWriter<float3> positions;
+  if (!replace_with_joined_attribute(options,
+                                     bke::GeometryComponent::Type::PointCloud,
+                                     "position",
+                                     {bke::AttrDomain::Point, CD_PROP_FLOAT3},
+                                     dst_pointcloud->pdata,
+                                     tot_points,
+                                     dst_attributes))
+  {
+    positions = dst_attributes.lookup_or_add_for_write_only_span<float3>("position",
+                                                                         bke::AttrDomain::Point);
+  }
 
   /* Prepare id attribute. */
   SpanAttributeWriter<int> point_ids;
@@ -1175,7 +1264,13 @@ static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &opti
                                                                       bke::AttrDomain::Point);
   }
   SpanAttributeWriter<float> point_radii;
-  if (all_pointclouds_info.create_radius_attribute) {
+  if (all_pointclouds_info.create_radius_attribute &&
+      !add_joined_attribute(options,
+                            bke::GeometryComponent::Type::PointCloud,
+                            "radius",
+                            {bke::AttrDomain::Point, CD_PROP_FLOAT},
+                            dst_attributes))
+  {
     point_radii = dst_attributes.lookup_or_add_for_write_only_span<float>("radius",
                                                                           bke::AttrDomain::Point);
   }
@@ -1185,6 +1280,15 @@ static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &opti
   for (const int attribute_index : ordered_attributes.index_range()) {
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
+    if (add_joined_attribute(options,
+                             bke::GeometryComponent::Type::PointCloud,
+                             attribute_id,
+                             ordered_attributes.kinds[attribute_index],
+                             dst_attributes))
+    {
+      dst_attribute_writers.append({});
+      continue;
+    }
     dst_attribute_writers.append(dst_attributes.lookup_or_add_for_write_only_span(
         attribute_id, bke::AttrDomain::Point, data_type));
   }
@@ -1382,37 +1486,49 @@ static void execute_realize_mesh_task(const RealizeInstancesOptions &options,
   const IndexRange dst_face_range(task.start_indices.face, src_faces.size());
   const IndexRange dst_loop_range(task.start_indices.loop, src_corner_verts.size());
 
-  MutableSpan<float3> dst_positions = all_dst_positions.slice(dst_vert_range);
-  MutableSpan<int2> dst_edges = all_dst_edges.slice(dst_edge_range);
-  MutableSpan<int> dst_face_offsets = all_dst_face_offsets.slice(dst_face_range);
-  MutableSpan<int> dst_corner_verts = all_dst_corner_verts.slice(dst_loop_range);
-  MutableSpan<int> dst_corner_edges = all_dst_corner_edges.slice(dst_loop_range);
-
-  threading::parallel_for(src_positions.index_range(), 1024, [&](const IndexRange vert_range) {
-    for (const int i : vert_range) {
-      dst_positions[i] = math::transform_point(task.transform, src_positions[i]);
-    }
-  });
-  threading::parallel_for(src_edges.index_range(), 1024, [&](const IndexRange edge_range) {
-    for (const int i : edge_range) {
-      dst_edges[i] = src_edges[i] + task.start_indices.vertex;
-    }
-  });
-  threading::parallel_for(src_corner_verts.index_range(), 1024, [&](const IndexRange loop_range) {
-    for (const int i : loop_range) {
-      dst_corner_verts[i] = src_corner_verts[i] + task.start_indices.vertex;
-    }
-  });
-  threading::parallel_for(src_corner_edges.index_range(), 1024, [&](const IndexRange loop_range) {
-    for (const int i : loop_range) {
-      dst_corner_edges[i] = src_corner_edges[i] + task.start_indices.edge;
-    }
-  });
-  threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange face_range) {
-    for (const int i : face_range) {
-      dst_face_offsets[i] = src_faces[i].start() + task.start_indices.loop;
-    }
-  });
+  /* Arrays that have been joined already are empty. */
+  if (!all_dst_positions.is_empty()) {
+    MutableSpan<float3> dst_positions = all_dst_positions.slice(dst_vert_range);
+    threading::parallel_for(src_positions.index_range(), 1024, [&](const IndexRange vert_range) {
+      for (const int i : vert_range) {
+        dst_positions[i] = math::transform_point(task.transform, src_positions[i]);
+      }
+    });
+  }
+  if (!all_dst_edges.is_empty()) {
+    MutableSpan<int2> dst_edges = all_dst_edges.slice(dst_edge_range);
+    threading::parallel_for(src_edges.index_range(), 1024, [&](const IndexRange edge_range) {
+      for (const int i : edge_range) {
+        dst_edges[i] = src_edges[i] + task.start_indices.vertex;
+      }
+    });
+  }
+  if (!all_dst_corner_verts.is_empty()) {
+    MutableSpan<int> dst_corner_verts = all_dst_corner_verts.slice(dst_loop_range);
+    threading::parallel_for(
+        src_corner_verts.index_range(), 1024, [&](const IndexRange loop_range) {
+          for (const int i : loop_range) {
+            dst_corner_verts[i] = src_corner_verts[i] + task.start_indices.vertex;
+          }
+        });
+  }
+  if (!all_dst_corner_edges.is_empty()) {
+    MutableSpan<int> dst_corner_edges = all_dst_corner_edges.slice(dst_loop_range);
+    threading::parallel_for(
+        src_corner_edges.index_range(), 1024, [&](const IndexRange loop_range) {
+          for (const int i : loop_range) {
+            dst_corner_edges[i] = src_corner_edges[i] + task.start_indices.edge;
+          }
+        });
+  }
+  if (!all_dst_face_offsets.is_empty()) {
+    MutableSpan<int> dst_face_offsets = all_dst_face_offsets.slice(dst_face_range);
+    threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange face_range) {
+      for (const int i : face_range) {
+        dst_face_offsets[i] = src_faces[i].start() + task.start_indices.loop;
+      }
+    });
+  }
   if (!all_dst_material_indices.is_empty()) {
     const Span<int> material_index_map = mesh_info.material_index_map;
     MutableSpan<int> dst_material_indices = all_dst_material_indices.slice(dst_face_range);
@@ -1489,11 +1605,52 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
   Mesh *dst_mesh = BKE_mesh_new_nomain(tot_vertices, tot_edges, tot_faces, tot_loops);
   r_realized_geometry.replace_mesh(dst_mesh);
   bke::MutableAttributeAccessor dst_attributes = dst_mesh->attributes_for_write();
-  MutableSpan<float3> dst_positions = dst_mesh->vert_positions_for_write();
-  MutableSpan<int2> dst_edges = dst_mesh->edges_for_write();
-  MutableSpan<int> dst_face_offsets = dst_mesh->face_offsets_for_write();
-  MutableSpan<int> dst_corner_verts = dst_mesh->corner_verts_for_write();
-  MutableSpan<int> dst_corner_edges = dst_mesh->corner_edges_for_write();
+  const auto replace_with_joined = [&](const StringRef name,
+                                       const bke::AttrDomain domain,
+                                       const eCustomDataType data_type,
+                                       CustomData &custom_data) {
+    return replace_with_joined_attribute(options,
+                                         bke::GeometryComponent::Type::Mesh,
+                                         name,
+                                         {domain, data_type},
+                                         custom_data,
+                                         dst_attributes.domain_size(domain),
+                                         dst_attributes);
+  };
+  MutableSpan<float3> dst_positions;
+  if (!replace_with_joined(
+          "position", bke::AttrDomain::Point, CD_PROP_FLOAT3, dst_mesh->vert_data))
+  {
+    dst_positions = dst_mesh->vert_positions_for_write();
+  }
+  MutableSpan<int2> dst_edges;
+  if (!replace_with_joined(
+          ".edge_verts", bke::AttrDomain::Edge, CD_PROP_INT32_2D, dst_mesh->edge_data))
+  {
+    dst_edges = dst_mesh->edges_for_write();
+  }
+  MutableSpan<int> dst_corner_verts;
+  if (!replace_with_joined(
+          ".corner_vert", bke::AttrDomain::Corner, CD_PROP_INT32, dst_mesh->corner_data))
+  {
+    dst_corner_verts = dst_mesh->corner_verts_for_write();
+  }
+  MutableSpan<int> dst_corner_edges;
+  if (!replace_with_joined(
+          ".corner_edge", bke::AttrDomain::Corner, CD_PROP_INT32, dst_mesh->corner_data))
+  {
+    dst_corner_edges = dst_mesh->corner_edges_for_write();
+  }
+  MutableSpan<int> dst_face_offsets;
+  if (tot_faces == 0 || !replace_with_joined_offsets(options,
+                                   bke::GeometryComponent::Type::Mesh,
+                                   ".face_offsets",
+                                   bke::AttrDomain::Face,
+                                   &dst_mesh->face_offset_indices,
+                                   &dst_mesh->runtime->face_offsets_sharing_info))
+  {
+    dst_face_offsets = dst_mesh->face_offsets_for_write();
+  }
 
   /* Copy settings from the first input geometry set with a mesh. */
   const RealizeMeshTask &first_task = tasks.first();
@@ -1528,6 +1685,15 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
+    if (add_joined_attribute(options,
+                             bke::GeometryComponent::Type::Mesh,
+                             attribute_id,
+                             ordered_attributes.kinds[attribute_index],
+                             dst_attributes))
+    {
+      dst_attribute_writers.append({});
+      continue;
+    }
     dst_attribute_writers.append(
         dst_attributes.lookup_or_add_for_write_only_span(attribute_id, domain, data_type));
   }
@@ -1709,8 +1875,9 @@ static void execute_realize_curve_task(const RealizeInstancesOptions &options,
                                        const AllCurvesInfo &all_curves_info,
                                        const RealizeCurveTask &task,
                                        const OrderedAttributes &ordered_attributes,
-                                       bke::CurvesGeometry &dst_curves,
                                        MutableSpan<GSpanAttributeWriter> dst_attribute_writers,
+                                       MutableSpan<float3> all_dst_positions,
+                                       MutableSpan<int> all_dst_offsets,
                                        MutableSpan<int> all_dst_ids,
                                        MutableSpan<float3> all_handle_left,
                                        MutableSpan<float3> all_handle_right,
@@ -1726,8 +1893,11 @@ static void execute_realize_curve_task(const RealizeInstancesOptions &options,
   const IndexRange dst_point_range{task.start_indices.point, curves.points_num()};
   const IndexRange dst_curve_range{task.start_indices.curve, curves.curves_num()};
 
-  copy_transformed_positions(
-      curves.positions(), task.transform, dst_curves.positions_for_write().slice(dst_point_range));
+  /* Arrays that have been joined already are empty. */
+  if (!all_dst_positions.is_empty()) {
+    copy_transformed_positions(
+        curves.positions(), task.transform, all_dst_positions.slice(dst_point_range));
+  }
 
   /* Copy and transform handle positions if necessary. */
   if (all_curves_info.create_handle_postion_attributes) {
@@ -1756,7 +1926,7 @@ static void execute_realize_curve_task(const RealizeInstancesOptions &options,
           all_dst.slice(dst_point_range).copy_from(src);
         }
       };
-  if (all_curves_info.create_radius_attribute) {
+  if (!all_radii.is_empty()) {
     copy_point_span_with_default(curves_info.radius, all_radii, 1.0f);
   }
   if (all_curves_info.create_nurbs_weight_attribute) {
@@ -1778,13 +1948,15 @@ static void execute_realize_curve_task(const RealizeInstancesOptions &options,
   }
 
   /* Copy curve offsets. */
-  const Span<int> src_offsets = curves.offsets();
-  const MutableSpan<int> dst_offsets = dst_curves.offsets_for_write().slice(dst_curve_range);
-  threading::parallel_for(curves.curves_range(), 2048, [&](const IndexRange range) {
-    for (const int i : range) {
-      dst_offsets[i] = task.start_indices.point + src_offsets[i];
-    }
-  });
+  if (!all_dst_offsets.is_empty()) {
+    const Span<int> src_offsets = curves.offsets();
+    const MutableSpan<int> dst_offsets = all_dst_offsets.slice(dst_curve_range);
+    threading::parallel_for(curves.curves_range(), 2048, [&](const IndexRange range) {
+      for (const int i : range) {
+        dst_offsets[i] = task.start_indices.point + src_offsets[i];
+      }
+    });
+  }
 
   if (!all_dst_ids.is_empty()) {
     create_result_ids(
@@ -1827,10 +1999,32 @@ static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
   /* Allocate new curves data-block. */
   Curves *dst_curves_id = bke::curves_new_nomain(points_num, curves_num);
   bke::CurvesGeometry &dst_curves = dst_curves_id->geometry.wrap();
-  dst_curves.offsets_for_write().last() = points_num;
   r_realized_geometry.replace_curves(dst_curves_id);
   bke::MutableAttributeAccessor dst_attributes = dst_curves.attributes_for_write();
 
+  MutableSpan<int> dst_offsets;
+  if (!replace_with_joined_offsets(options,
+                                   bke::GeometryComponent::Type::Curve,
+                                   ".curve_offsets",
+                                   bke::AttrDomain::Curve,
+                                   &dst_curves.curve_offsets,
+                                   &dst_curves.runtime->curve_offsets_sharing_info))
+  {
+    dst_offsets = dst_curves.offsets_for_write();
+    dst_offsets.last() = points_num;
+  }
+  MutableSpan<float3> dst_positions;
+  if (!replace_with_joined_attribute(options,
+                                     bke::GeometryComponent::Type::Curve,
+                                     "position",
+                                     {bke::AttrDomain::Point, CD_PROP_FLOAT3},
+                                     dst_curves.point_data,
+                                     points_num,
+                                     dst_attributes))
+  {
+    dst_positions = dst_curves.positions_for_write();
+  }
+
   /* Copy settings from the first input geometry set with curves. */
   const RealizeCurveTask &first_task = tasks.first();
   const Curves &first_curves_id = *first_task.curve_info->curves;
@@ -1849,6 +2043,15 @@ static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
+    if (add_joined_attribute(options,
+                             bke::GeometryComponent::Type::Curve,
+                             attribute_id,
+                             ordered_attributes.kinds[attribute_index],
+                             dst_attributes))
+    {
+      dst_attribute_writers.append({});
+      continue;
+    }
     dst_attribute_writers.append(
         dst_attributes.lookup_or_add_for_write_only_span(attribute_id, domain, data_type));
   }
@@ -1864,7 +2067,13 @@ static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
   }
 
   SpanAttributeWriter<float> radius;
-  if (all_curves_info.create_radius_attribute) {
+  if (all_curves_info.create_radius_attribute &&
+      !add_joined_attribute(options,
+                            bke::GeometryComponent::Type::Curve,
+                            "radius",
+                            {bke::AttrDomain::Point, CD_PROP_FLOAT},
+                            dst_attributes))
+  {
     radius = dst_attributes.lookup_or_add_for_write_only_span<float>("radius",
                                                                      bke::AttrDomain::Point);
   }
@@ -1892,8 +2101,9 @@ static void execute_realize_curve_tasks(const RealizeInstancesOptions &options,
                                  all_curves_info,
                                  task,
                                  ordered_attributes,
-                                 dst_curves,
                                  dst_attribute_writers,
+                                 dst_positions,
+                                 dst_offsets,
                                  point_ids.span,
                                  handle_left.span,
                                  handle_right.span,
@@ -1980,48 +2190,70 @@ bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
   return realize_instances(geometry_set, options, all_instances);
 }
 
-bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
-                                   const RealizeInstancesOptions &options,
-                                   const VariedDepthOptions &varied_depth_option)
+/** Information about all geometries that are realized, gathered before any tasks. */
+struct AllGeometriesInfo {
+  AllPointCloudsInfo pointclouds;
+  AllMeshesInfo meshes;
+  AllCurvesInfo curves;
+  OrderedAttributes instance_attributes;
+  Map<std::pair<const void *, const CPPType *>, std::unique_ptr<GArray<>>> converted_arrays;
+};
+
+/**
+ * Preprocess each unique geometry that is instanced (e.g. each `Mesh`) and gather the attributes
+ * of the result.
+ */
+static void preprocess_geometries(const bke::GeometrySet &geometry_set,
+                                  const RealizeInstancesOptions &options,
+                                  const VariedDepthOptions &varied_depth_option,
+                                  AllGeometriesInfo &r_info)
+{
+  r_info.pointclouds = preprocess_pointclouds(geometry_set, options, varied_depth_option);
+  r_info.meshes = preprocess_meshes(geometry_set, options, varied_depth_option);
+  r_info.curves = preprocess_curves(geometry_set, options, varied_depth_option);
+  r_info.instance_attributes = gather_generic_instance_attributes_to_propagate(
+      geometry_set, options, varied_depth_option);
+}
+
+/**
+ * \param info: The preprocessed geometry, see #preprocess_geometries. Attributes and materials
+ * are always gathered from the entire geometry, so that realizing parts of it separately gives
+ * consistent results.
+ * \param not_to_realize_set: Contains the instances that are kept, they are added to the result.
+ * \param tasks_geometry_set: The geometry that is realized. It is either the preprocessed
+ * geometry or a part of it.
+ * \param tasks_selection: Top-level instances of \a tasks_geometry_set that are realized.
+ */
+static bke::GeometrySet realize_instances_impl(AllGeometriesInfo &info,
+                                               const RealizeInstancesOptions &options,
+                                               const VariedDepthOptions &varied_depth_option,
+                                               bke::GeometrySet &not_to_realize_set,
+                                               const bke::GeometrySet &tasks_geometry_set,
+                                               const IndexMask &tasks_selection)
 {
   /* The algorithm works in three steps:
-   * 1. Preprocess each unique geometry that is instanced (e.g. each `Mesh`).
+   * 1. Preprocess each unique geometry that is instanced (e.g. each `Mesh`), this is done by the
+   *    caller with #preprocess_geometries.
    * 2. Gather "tasks" that need to be executed to realize the instances. Each task corresponds to
    *    instances of the previously preprocessed geometry.
    * 3. Execute all tasks in parallel.
    */
-
-  if (!geometry_set.has_instances()) {
-    return geometry_set;
-  }
-
-  bke::GeometrySet not_to_realize_set;
-  propagate_instances_to_keep(
-      geometry_set, varied_depth_option.selection, not_to_realize_set, options.propagation_info);
-
-  if (options.keep_original_ids) {
-    remove_id_attribute_from_instances(geometry_set);
-  }
-
-  AllPointCloudsInfo all_pointclouds_info = preprocess_pointclouds(
-      geometry_set, options, varied_depth_option);
-  AllMeshesInfo all_meshes_info = preprocess_meshes(geometry_set, options, varied_depth_option);
-  AllCurvesInfo all_curves_info = preprocess_curves(geometry_set, options, varied_depth_option);
-  OrderedAttributes all_instance_attributes = gather_generic_instance_attributes_to_propagate(
-      geometry_set, options, varied_depth_option);
+  const AllPointCloudsInfo &all_pointclouds_info = info.pointclouds;
+  const AllMeshesInfo &all_meshes_info = info.meshes;
+  const AllCurvesInfo &all_curves_info = info.curves;
+  const OrderedAttributes &all_instance_attributes = info.instance_attributes;
 
   const bool create_id_attribute = all_pointclouds_info.create_id_attribute ||
                                    all_meshes_info.create_id_attribute ||
                                    all_curves_info.create_id_attribute;
-  Vector<std::unique_ptr<GArray<>>> temporary_arrays;
   GatherTasksInfo gather_info = {all_pointclouds_info,
                                  all_meshes_info,
                                  all_curves_info,
                                  all_instance_attributes,
                                  create_id_attribute,
-                                 varied_depth_option.selection,
+                                 tasks_selection,
                                  varied_depth_option.depths,
-                                 temporary_arrays};
+                                 info.converted_arrays};
 
   if (not_to_realize_set.has_instances()) {
     gather_info.instances.instances_components_to_merge.append(
@@ -2033,8 +2265,12 @@ bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
   const float4x4 transform = float4x4::identity();
   InstanceContext attribute_fallbacks(gather_info);
 
-  gather_realize_tasks_recursive(
-      gather_info, 0, VariedDepthOptions::MAX_DEPTH, geometry_set, transform, attribute_fallbacks);
+  gather_realize_tasks_recursive(gather_info,
+                                 0,
+                                 VariedDepthOptions::MAX_DEPTH,
+                                 tasks_geometry_set,
+                                 transform,
+                                 attribute_fallbacks);
 
   bke::GeometrySet new_geometry_set;
   execute_instances_tasks(gather_info.instances.instances_components_to_merge,
@@ -2075,6 +2311,128 @@ bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
   return new_geometry_set;
 }
 
+bke::GeometrySet realize_instances(bke::GeometrySet geometry_set,
+                                   const RealizeInstancesOptions &options,
+                                   const VariedDepthOptions &varied_depth_option)
+{
+  if (!geometry_set.has_instances()) {
+    return geometry_set;
+  }
+
+  bke::GeometrySet not_to_realize_set;
+  propagate_instances_to_keep(
+      geometry_set, varied_depth_option.selection, not_to_realize_set, options.propagation_info);
+
+  if (options.keep_original_ids) {
+    remove_id_attribute_from_instances(geometry_set);
+  }
+
+  AllGeometriesInfo info;
+  preprocess_geometries(geometry_set, options, varied_depth_option, info);
+  return realize_instances_impl(info,
+                                options,
+                                varied_depth_option,
+                                not_to_realize_set,
+                                geometry_set,
+                                varied_depth_option.selection);
+}
+
+/**
+ * Rough number of bytes used by the attributes of the geometry when all its instances are
+ * realized. The realized geometry of instance references is only estimated once per reference.
+ */
+static int64_t estimate_realized_size(const bke::GeometrySet &geometry_set)
+{
+  int64_t size = 0;
+  for (const bke::GeometryComponent *component : geometry_set.get_components()) {
+    if (component->type() == bke::GeometryComponent::Type::Instance) {
+      const Instances &instances = *static_cast<const bke::InstancesComponent *>(component)->get();
+      const Span<InstanceReference> references = instances.references();
+      Array<int64_t> reference_sizes(references.size());
+      for (const int i : references.index_range()) {
+        reference_sizes[i] = estimate_realized_size(geometry_set_from_reference(references[i]));
+      }
+      for (const int handle : instances.reference_handles()) {
+        size += reference_sizes[handle];
+      }
+      continue;
+    }
+    const std::optional<bke::AttributeAccessor> attributes = component->attributes();
+    if (!attributes) {
+      continue;
+    }
+    attributes->for_all([&](const AttributeIDRef & /*id*/, const AttributeMetaData &meta_data) {
+      const CPPType *type = bke::custom_data_type_to_cpp_type(meta_data.data_type);
+      if (type != nullptr) {
+        size += int64_t(attributes->domain_size(meta_data.domain)) * type->size();
+      }
+      return true;
+    });
+  }
+  return size;
+}
+
+void realize_instances_in_batches(bke::GeometrySet geometry_set,
+                                  const RealizeInstancesOptions &options,
+                                  const int64_t memory_budget,
+                                  const FunctionRef<void(bke::GeometrySet batch)> fn)
+{
+  BLI_assert(options.joined_attributes.is_empty());
+  if (!geometry_set.has_instances()) {
+    fn(std::move(geometry_set));
+    return;
+  }
+  if (options.keep_original_ids) {
+    remove_id_attribute_from_instances(geometry_set);
+  }
+
+  /* Geometry that is not instanced is only realized once, as part of the first batch. */
+  bke::GeometrySet instances_set = geometry_set;
+  instances_set.keep_only({bke::GeometryComponent::Type::Instance});
+
+  const Instances &instances = *geometry_set.get_instances();
+  const Span<InstanceReference> references = instances.references();
+  const Span<int> handles = instances.reference_handles();
+  Array<int64_t> reference_sizes(references.size());
+  threading::parallel_for(references.index_range(), 1, [&](const IndexRange range) {
+    for (const int i : range) {
+      reference_sizes[i] = estimate_realized_size(geometry_set_from_reference(references[i]));
+    }
+  });
+
+  /* Attributes are gathered from all instances, so that every batch has the same attributes. */
+  VariedDepthOptions varied_depth_option;
+  varied_depth_option.depths = VArray<int>::ForSingle(VariedDepthOptions::MAX_DEPTH,
+                                                      instances.instances_num());
+  varied_depth_option.selection = IndexMask(instances.instances_num());
+  AllGeometriesInfo info;
+  preprocess_geometries(geometry_set, options, varied_depth_option, info);
+
+  bke::GeometrySet not_to_realize_set;
+  int batch_start = 0;
+  int64_t batch_size = 0;
+  for (const int i : handles.index_range()) {
+    const int64_t instance_size = reference_sizes[handles[i]];
+    const bool is_last = i == handles.size() - 1;
+    batch_size += instance_size;
+    const bool next_exceeds_budget = !is_last &&
+                                     batch_size + reference_sizes[handles[i + 1]] > memory_budget;
+    if (!is_last && !next_exceeds_budget) {
+      continue;
+    }
+    const IndexMask batch_selection(IndexRange::from_begin_end(batch_start, i + 1));
+    const bke::GeometrySet &batch_set = batch_start == 0 ? geometry_set : instances_set;
+    fn(realize_instances_impl(info,
+                              options,
+                              varied_depth_option,
+                              not_to_realize_set,
+                              batch_set,
+                              batch_selection));
+    batch_start = i + 1;
+    batch_size = 0;
+  }
+}
+
 /** \} */
 
 }  // namespace blender::geometry
@@ -22,6 +22,9 @@
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
 #include "BLI_rect.h"
+#include "BLI_simd.hh"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
 #include "BLI_vector.hh"
 
 #include "DNA_scene_types.h"
@@ -1128,10 +1131,21 @@ static void pack_island_box_pack_2d(const Span<std::unique_ptr<UVAABBIsland>> aa
   MEM_freeN(box_array);
 }
 
+/**
+ * Book keeping variables that speed up consecutive queries of an #Occupancy.
+ * Kept separate from the bitmap, so that multiple threads can query the same bitmap.
+ */
+struct OccupancyHint {
+  float2 witness = float2(-1.0f); /* Witness to a previously known occupied pixel. */
+  float witness_distance = 0.0f;  /* Signed distance to nearest placed island. */
+  uint triangle_hint = 0;         /* Hint to a previously suspected overlapping triangle. */
+};
+
 /**
  * Helper class for the `xatlas` strategy.
  * Accelerates geometry queries by approximating exact queries with a bitmap.
- * Includes some book keeping variables to simplify the algorithm.
+ * Queries don't modify the bitmap, so they can run in parallel as long as every thread uses its
+ * own #OccupancyHint.
  *
  * \note The last entry, `(width-1, height-1)` is named the "top-right".
  */
@@ -1147,25 +1161,31 @@ class Occupancy {
                        const float2 &uv1,
                        const float2 &uv2,
                        const float margin,
-                       const bool write) const;
+                       const bool write,
+                       OccupancyHint &hint) const;
 
   /* Write or Query an island on the bitmap. */
   float trace_island(const PackIsland *island,
                      const UVPhi phi,
                      const float scale,
                      const float margin,
-                     const bool write) const;
+                     const bool write,
+                     OccupancyHint &hint) const;
 
   int bitmap_radix;              /* Width and Height of `bitmap`. */
   float bitmap_scale_reciprocal; /* == 1.0f / `bitmap_scale`. */
  private:
   mutable Array<float> bitmap_;
 
-  mutable float2 witness_;         /* Witness to a previously known occupied pixel. */
-  mutable float witness_distance_; /* Signed distance to nearest placed island. */
-  mutable uint triangle_hint_;     /* Hint to a previously suspected overlapping triangle. */
-
   const float terminal = 1048576.0f; /* 4 * bitmap_radix < terminal < INT_MAX / 4. */
+
+  void write_triangle_row(float *row,
+                          int ix0,
+                          int ix1,
+                          float y,
+                          const float2 &uv0,
+                          const float2 &uv1,
+                          const float2 &uv2) const;
 };
 
 Occupancy::Occupancy(const float initial_scale)
@@ -1189,10 +1209,6 @@ void Occupancy::clear()
   for (int i = 0; i < bitmap_radix * bitmap_radix; i++) {
     bitmap_[i] = terminal;
   }
-  witness_.x = -1;
-  witness_.y = -1;
-  witness_distance_ = 0.0f;
-  triangle_hint_ = 0;
 }
 
 static float signed_distance_fat_triangle(const float2 probe,
@@ -1216,11 +1232,69 @@ static float signed_distance_fat_triangle(const float2 probe,
   return sqrtf(result_ssq);
 }
 
+/**
+ * Write the distance to a triangle into the pixels `[ix0, ix1)` of a bitmap row, keeping the
+ * smaller distance. This is where most of the time is spent when re-tracing islands after the
+ * bitmap was resized, so four pixels are processed at once where possible.
+ */
+void Occupancy::write_triangle_row(float *row,
+                                   const int ix0,
+                                   const int ix1,
+                                   const float y,
+                                   const float2 &uv0,
+                                   const float2 &uv1,
+                                   const float2 &uv2) const
+{
+  int x = ix0;
+#if BLI_HAVE_SSE2
+  const float2 edges[3] = {uv1 - uv0, uv2 - uv1, uv0 - uv2};
+  const float2 starts[3] = {uv0, uv1, uv2};
+  const bool has_degenerate_edge = math::length_squared(edges[0]) < 1e-40f ||
+                                   math::length_squared(edges[1]) < 1e-40f ||
+                                   math::length_squared(edges[2]) < 1e-40f;
+  /* Degenerate edges are rare, they are left to the scalar code below. */
+  if (!has_degenerate_edge) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 probe_y = _mm_set1_ps(y);
+    for (; x + 4 <= ix1; x += 4) {
+      const __m128 probe_x = _mm_add_ps(_mm_set1_ps(float(x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+      /* Same as #dist_signed_squared_to_edge and #signed_distance_fat_triangle. */
+      __m128 result_ssq = _mm_set1_ps(-FLT_MAX);
+      __m128 corner_sq = _mm_set1_ps(FLT_MAX);
+      for (int i = 0; i < 3; i++) {
+        const __m128 side_x = _mm_sub_ps(probe_x, _mm_set1_ps(starts[i].x));
+        const __m128 side_y = _mm_sub_ps(probe_y, _mm_set1_ps(starts[i].y));
+        const __m128 numerator = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(edges[i].x), side_y),
+                                            _mm_mul_ps(_mm_set1_ps(edges[i].y), side_x));
+        const __m128 numerator_ssq = _mm_mul_ps(numerator, _mm_andnot_ps(sign_mask, numerator));
+        const __m128 edge_ssq = _mm_div_ps(numerator_ssq,
+                                           _mm_set1_ps(math::length_squared(edges[i])));
+        result_ssq = _mm_max_ps(result_ssq, edge_ssq);
+        corner_sq = _mm_min_ps(
+            corner_sq, _mm_add_ps(_mm_mul_ps(side_x, side_x), _mm_mul_ps(side_y, side_y)));
+      }
+      const __m128 inside = _mm_cmplt_ps(result_ssq, _mm_setzero_ps());
+      const __m128 inside_distance = _mm_xor_ps(
+          sign_mask, _mm_sqrt_ps(_mm_max_ps(_mm_xor_ps(sign_mask, result_ssq), _mm_setzero_ps())));
+      const __m128 outside_distance = _mm_sqrt_ps(_mm_min_ps(result_ssq, corner_sq));
+      const __m128 distance = _mm_or_ps(_mm_and_ps(inside, inside_distance),
+                                        _mm_andnot_ps(inside, outside_distance));
+      _mm_storeu_ps(row + x, _mm_min_ps(distance, _mm_loadu_ps(row + x)));
+    }
+  }
+#endif
+  for (; x < ix1; x++) {
+    const float distance = signed_distance_fat_triangle(float2(x, y), uv0, uv1, uv2);
+    row[x] = min_ff(distance, row[x]);
+  }
+}
+
 float Occupancy::trace_triangle(const float2 &uv0,
                                 const float2 &uv1,
                                 const float2 &uv2,
                                 const float margin,
-                                const bool write) const
+                                const bool write,
+                                OccupancyHint &hint) const
 {
   const float x0 = min_fff(uv0.x, uv1.x, uv2.x);
   const float y0 = min_fff(uv0.y, uv1.y, uv2.y);
@@ -1240,15 +1314,20 @@ float Occupancy::trace_triangle(const float2 &uv0,
   float epsilon = 0.7071f; /* == sqrt(0.5f), rounded up by 0.00002f. */
   epsilon = std::max(epsilon, 2 * margin * bitmap_scale_reciprocal);
 
-  if (!write) {
-    if (ix0 <= witness_.x && witness_.x < ix1) {
-      if (iy0 <= witness_.y && witness_.y < iy1) {
-        const float distance = signed_distance_fat_triangle(witness_, uv0s, uv1s, uv2s);
-        const float extent = epsilon - distance - witness_distance_;
-        const float pixel_round_off = -0.1f; /* Go faster on nearly-axis aligned edges. */
-        if (extent > pixel_round_off) {
-          return std::max(0.0f, extent); /* Witness observes occupied. */
-        }
+  if (write) {
+    for (int y = iy0; y < iy1; y++) {
+      write_triangle_row(&bitmap_[y * bitmap_radix], ix0, ix1, float(y), uv0s, uv1s, uv2s);
+    }
+    return -1.0f;
+  }
+
+  if (ix0 <= hint.witness.x && hint.witness.x < ix1) {
+    if (iy0 <= hint.witness.y && hint.witness.y < iy1) {
+      const float distance = signed_distance_fat_triangle(hint.witness, uv0s, uv1s, uv2s);
+      const float extent = epsilon - distance - hint.witness_distance;
+      const float pixel_round_off = -0.1f; /* Go faster on nearly-axis aligned edges. */
+      if (extent > pixel_round_off) {
+        return std::max(0.0f, extent); /* Witness observes occupied. */
       }
     }
   }
@@ -1256,20 +1335,16 @@ float Occupancy::trace_triangle(const float2 &uv0,
   /* Iterate in opposite direction to outer search to improve witness effectiveness. */
   for (int y = iy1 - 1; y >= iy0; y--) {
     for (int x = ix1 - 1; x >= ix0; x--) {
-      float *hotspot = &bitmap_[y * bitmap_radix + x];
-      if (!write && *hotspot > epsilon) {
+      const float hotspot = bitmap_[y * bitmap_radix + x];
+      if (hotspot > epsilon) {
         continue;
       }
       const float2 probe(x, y);
       const float distance = signed_distance_fat_triangle(probe, uv0s, uv1s, uv2s);
-      if (write) {
-        *hotspot = min_ff(distance, *hotspot);
-        continue;
-      }
-      const float extent = epsilon - distance - *hotspot;
+      const float extent = epsilon - distance - hotspot;
       if (extent > 0.0f) {
-        witness_ = probe;
-        witness_distance_ = *hotspot;
+        hint.witness = probe;
+        hint.witness_distance = hotspot;
         return extent; /* Occupied. */
       }
     }
@@ -1310,7 +1385,8 @@ float Occupancy::trace_island(const PackIsland *island,
                               const UVPhi phi,
                               const float scale,
                               const float margin,
-                              const bool write) const
+                              const bool write,
+                              OccupancyHint &hint) const
 {
   const float2 diagonal_support = island->get_diagonal_support(scale, phi.rotation, margin);
 
@@ -1334,17 +1410,18 @@ float Occupancy::trace_island(const PackIsland *island,
   const uint vert_count = uint(
       island->triangle_vertices_.size()); /* `uint` is faster than `int`. */
   for (uint i = 0; i < vert_count; i += 3) {
-    const uint j = (i + triangle_hint_) % vert_count;
+    const uint j = (i + hint.triangle_hint) % vert_count;
     float2 uv0;
     float2 uv1;
     float2 uv2;
     mul_v2_m2v2(uv0, matrix, island->triangle_vertices_[j]);
     mul_v2_m2v2(uv1, matrix, island->triangle_vertices_[j + 1]);
     mul_v2_m2v2(uv2, matrix, island->triangle_vertices_[j + 2]);
-    const float extent = trace_triangle(uv0 + delta, uv1 + delta, uv2 + delta, margin, write);
+    const float extent = trace_triangle(
+        uv0 + delta, uv1 + delta, uv2 + delta, margin, write, hint);
 
     if (!write && extent >= 0.0f) {
-      triangle_hint_ = j;
+      hint.triangle_hint = j;
       return extent; /* Occupied. */
     }
   }
@@ -1358,7 +1435,8 @@ static UVPhi find_best_fit_for_island(const PackIsland *island,
                                       const int angle_90_multiple,
                                       /* TODO: const bool reflect, */
                                       const float margin,
-                                      const float target_aspect_y)
+                                      const float target_aspect_y,
+                                      OccupancyHint &hint)
 {
   /* Discussion: Different xatlas implementation make different choices here, either
    * fixing the output bitmap size before packing begins, or sometimes allowing
@@ -1400,7 +1478,7 @@ static UVPhi find_best_fit_for_island(const PackIsland *island,
   int t = int(ceilf((2 * support_diagonal.x + margin) * occupancy.bitmap_scale_reciprocal));
   while (t < scan_line_x) { /* "less-than" */
     phi.translation = float2(t * bitmap_scale, scan_line_y * bitmap_scale) - support_diagonal;
-    const float extent = occupancy.trace_island(island, phi, scale, margin, false);
+    const float extent = occupancy.trace_island(island, phi, scale, margin, false, hint);
     if (extent < 0.0f) {
       return phi; /* Success. */
     }
@@ -1411,7 +1489,7 @@ static UVPhi find_best_fit_for_island(const PackIsland *island,
   t = int(ceilf((2 * support_diagonal.y + margin) * occupancy.bitmap_scale_reciprocal));
   while (t <= scan_line_y) { /* "less-than-or-equal" */
     phi.translation = float2(scan_line_x * bitmap_scale, t * bitmap_scale) - support_diagonal;
-    const float extent = occupancy.trace_island(island, phi, scale, margin, false);
+    const float extent = occupancy.trace_island(island, phi, scale, margin, false, hint);
     if (extent < 0.0f) {
       return phi; /* Success. */
     }
@@ -1421,6 +1499,72 @@ static UVPhi find_best_fit_for_island(const PackIsland *island,
   return UVPhi(); /* Unable to find a place to fit. */
 }
 
+/**
+ * Search multiple scan lines for a place to fit the island at once, trying all rotations for
+ * each scan line. The searches only read from `occupancy`, so they run in parallel.
+ *
+ * The hint changes which positions are tried, so every scan line starts with the same \a hint.
+ * This makes the result of each scan line independent of the other scan lines: the island is
+ * placed on the lowest scan line where it fits. \a hint is updated when the island fits, or when
+ * a single scan line was searched. With a single thread only one scan line is searched at a time,
+ * which gives the same hints and results as searching the scan lines serially. With more scan
+ * lines, the hint changes made on scan lines where the island does not fit are discarded, so the
+ * layout can differ slightly from the serial search.
+ *
+ * \return The first scan line (in the order of `scan_lines`) where the island fits, or -1.
+ */
+static int64_t find_best_fit_for_island_on_scan_lines(const PackIsland *island,
+                                                      const Span<int> scan_lines,
+                                                      const Occupancy &occupancy,
+                                                      const float scale,
+                                                      const int max_90_multiple,
+                                                      const float margin,
+                                                      const float target_aspect_y,
+                                                      OccupancyHint &hint,
+                                                      UVPhi &r_phi)
+{
+  if (scan_lines.is_empty()) {
+    return -1;
+  }
+  Array<UVPhi> phis(scan_lines.size());
+  Array<OccupancyHint> hints(scan_lines.size(), hint);
+  std::atomic<int64_t> first_found = scan_lines.size();
+  threading::parallel_for(scan_lines.index_range(), 1, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      if (i > first_found.load(std::memory_order_relaxed)) {
+        /* A place on an earlier scan line has been found already. */
+        return;
+      }
+      for (int angle_90_multiple = 0; angle_90_multiple < max_90_multiple; angle_90_multiple++) {
+        phis[i] = find_best_fit_for_island(island,
+                                           scan_lines[i],
+                                           occupancy,
+                                           scale,
+                                           angle_90_multiple,
+                                           margin,
+                                           target_aspect_y,
+                                           hints[i]);
+        if (phis[i].is_valid()) {
+          int64_t found = first_found.load();
+          while (i < found && !first_found.compare_exchange_weak(found, i)) {
+          }
+          break;
+        }
+      }
+    }
+  });
+  const int64_t found = first_found.load();
+  if (found == scan_lines.size()) {
+    if (scan_lines.size() == 1) {
+      hint = hints[0];
+    }
+    return -1;
+  }
+  hint = hints[found];
+  r_phi = phis[found];
+  return found;
+}
+
 static float guess_initial_scale(const Span<PackIsland *> islands,
                                  const float scale,
                                  const float margin)
@@ -1642,6 +1786,17 @@ static int64_t pack_island_xatlas(const Span<std::unique_ptr<UVAABBIsland>> isla
   int traced_islands = 0; /* Which islands are currently traced in `occupancy`. */
   int i = 0;
   bool placed_can_rotate = true;
+  const float aspect_y_min = std::min(params.target_aspect_y, 1.0f / params.target_aspect_y);
+  const float scan_line_max = occupancy.bitmap_radix * sqrtf(aspect_y_min);
+
+  /* Number of scan lines that are searched at once. Usually an island fits on the first scan line,
+   * so the batch only grows while the search for the current island fails. Without multiple
+   * threads, searching ahead would only do extra work. */
+  const int scan_lines_batch_max = BLI_system_thread_count() > 1 ? 64 : 1;
+  int scan_lines_batch = 1;
+  Vector<int> scan_lines;
+  /* Speeds up consecutive searches, reset whenever the bitmap is cleared. */
+  OccupancyHint hint;
 
   /* The following `while` loop is setting up a three-way race:
    * `for (scan_line = 0; scan_line < bitmap_radix; scan_line++)`
@@ -1663,7 +1818,7 @@ static int64_t pack_island_xatlas(const Span<std::unique_ptr<UVAABBIsland>> isla
       const int64_t island_index = island_indices[traced_islands]->index;
       PackIsland *island = islands[island_index];
       const float island_scale = island->can_scale_(params) ? scale : 1.0f;
-      occupancy.trace_island(island, phis[island_index], island_scale, margin, true);
+      occupancy.trace_island(island, phis[island_index], island_scale, margin, true, hint);
       traced_islands++;
     }
 
@@ -1692,47 +1847,48 @@ static int64_t pack_island_xatlas(const Span<std::unique_ptr<UVAABBIsland>> isla
       placed_can_rotate = false;
     }
 
-    for (int angle_90_multiple = 0; angle_90_multiple < max_90_multiple; angle_90_multiple++) {
-      phi = find_best_fit_for_island(island,
-                                     scan_line,
-                                     occupancy,
-                                     island_scale,
-                                     angle_90_multiple,
-                                     margin,
-                                     params.target_aspect_y);
-      if (phi.is_valid()) {
-        break;
-      }
-    }
-
-    if (!phi.is_valid()) {
-      /* Unable to find a fit on this scan_line. */
+    /* Increasing by 2 has the effect of changing the sampling pattern.
+     * The parameter '2' is not "free" in the sense that changing it requires
+     * a change to `bitmap_radix` and then re-tuning `alpaca_cutoff`.
+     * Possible values here *could* be 1, 2 or 3, however the only *reasonable*
+     * choice is 2. */
+    const int scan_line_step = i < 10 ? 1 : 2;
+    scan_lines.clear();
+    for (int line = scan_line; line < scan_line_max && scan_lines.size() < scan_lines_batch;
+         line += scan_line_step)
+    {
+      scan_lines.append(line);
+    }
+    const int64_t found = find_best_fit_for_island_on_scan_lines(island,
+                                                                 scan_lines,
+                                                                 occupancy,
+                                                                 island_scale,
+                                                                 max_90_multiple,
+                                                                 margin,
+                                                                 params.target_aspect_y,
+                                                                 hint,
+                                                                 phi);
+
+    if (found == -1) {
+      /* Unable to find a fit on these scan lines. */
 
       island = nullptr; /* Just mark it as null, we won't use it further. */
 
-      if (i < 10) {
-        scan_line++;
-      }
-      else {
-        /* Increasing by 2 here has the effect of changing the sampling pattern.
-         * The parameter '2' is not "free" in the sense that changing it requires
-         * a change to `bitmap_radix` and then re-tuning `alpaca_cutoff`.
-         * Possible values here *could* be 1, 2 or 3, however the only *reasonable*
-         * choice is 2. */
-        scan_line += 2;
-      }
-      if (scan_line < occupancy.bitmap_radix *
-                          sqrtf(std::min(params.target_aspect_y, 1.0f / params.target_aspect_y)))
-      {
+      scan_lines_batch = std::min(scan_lines_batch * 2, scan_lines_batch_max);
+      scan_line = scan_lines.is_empty() ? scan_line : scan_lines.last() + scan_line_step;
+      if (scan_line < scan_line_max) {
         continue; /* Try again on next scan_line. */
       }
 
       /* Enlarge search parameters. */
       scan_line = 0;
       occupancy.increase_scale();
+      hint = OccupancyHint();
       traced_islands = 0; /* Will trigger a re-trace of previously solved islands. */
       continue;
     }
+    scan_line = scan_lines[found];
+    scan_lines_batch = 1;
 
     /* Place island. */
     phis[island_indices[i]->index] = phi;
@@ -1745,6 +1901,7 @@ static int64_t pack_island_xatlas(const Span<std::unique_ptr<UVAABBIsland>> isla
         scan_line = 0;
         traced_islands = 0;
         occupancy.clear();
+        hint = OccupancyHint();
         continue;
       }
     }
@@ -18,6 +18,8 @@
 #include "BLI_polyfill_2d.h"
 #include "BLI_polyfill_2d_beautify.h"
 #include "BLI_rand.h"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
 
 #include "GEO_uv_pack.hh"
 
@@ -30,6 +32,9 @@ namespace blender::geometry {
 #define param_warning(message) \
   {/* `printf("Warning %s:%d: %s\n", __FILE__, __LINE__, message);` */}(void)0
 
+/* Print the time spent in the different steps of unwrapping. */
+// #define USE_PARAM_DEBUG_TIME
+
 /* Special Purpose Hash */
 
 using PHashKey = uintptr_t;
@@ -3956,28 +3961,53 @@ void uv_parametrizer_construct_end(ParamHandle *phandle,
   phandle->state = PHANDLE_STATE_CONSTRUCTED;
 }
 
+/**
+ * Charts don't share any data, so they can be processed in parallel. The size of a chart is used
+ * to distribute the work, because a few large charts often take most of the time.
+ */
+template<typename Fn> static void p_charts_parallel(ParamHandle *phandle, const Fn &fn)
+{
+  threading::parallel_for(
+      IndexRange(phandle->ncharts),
+      1024,
+      [&](const IndexRange range) {
+        for (const int i : range) {
+          fn(i, phandle->charts[i]);
+        }
+      },
+      threading::individual_task_sizes(
+          [&](const int64_t i) { return int64_t(phandle->charts[i]->nfaces); }));
+}
+
 void uv_parametrizer_lscm_begin(ParamHandle *phandle, bool live, bool abf)
 {
   BLI_assert(phandle->state == PHANDLE_STATE_CONSTRUCTED);
   phandle->state = PHANDLE_STATE_LSCM;
+#ifdef USE_PARAM_DEBUG_TIME
+  SCOPED_TIMER(__func__);
+#endif
 
-  for (int i = 0; i < phandle->ncharts; i++) {
-    for (PFace *f = phandle->charts[i]->faces; f; f = f->nextlink) {
+  p_charts_parallel(phandle, [&](const int /*i*/, PChart *chart) {
+    for (PFace *f = chart->faces; f; f = f->nextlink) {
       p_face_backup_uvs(f);
     }
-    p_chart_lscm_begin(phandle->charts[i], live, abf);
-  }
+    p_chart_lscm_begin(chart, live, abf);
+  });
 }
 
 void uv_parametrizer_lscm_solve(ParamHandle *phandle, int *count_changed, int *count_failed)
 {
   BLI_assert(phandle->state == PHANDLE_STATE_LSCM);
+#ifdef USE_PARAM_DEBUG_TIME
+  SCOPED_TIMER(__func__);
+#endif
 
-  for (int i = 0; i < phandle->ncharts; i++) {
-    PChart *chart = phandle->charts[i];
-
+  /* Whether solving succeeded, -1 for charts that are skipped. */
+  Array<int8_t> results(phandle->ncharts);
+  p_charts_parallel(phandle, [&](const int i, PChart *chart) {
     if (!chart->context) {
-      continue;
+      results[i] = -1;
+      return;
     }
     const bool result = p_chart_lscm_solve(phandle, chart);
 
@@ -3993,13 +4023,16 @@ void uv_parametrizer_lscm_solve(ParamHandle *phandle, int *count_changed, int *c
     if (!result || !chart->has_pins) {
       p_chart_lscm_end(chart);
     }
+    results[i] = result;
+  });
 
-    if (result) {
+  for (const int8_t result : results) {
+    if (result == 1) {
       if (count_changed != nullptr) {
         *count_changed += 1;
       }
     }
-    else {
+    else if (result == 0) {
       if (count_failed != nullptr) {
         *count_failed += 1;
       }
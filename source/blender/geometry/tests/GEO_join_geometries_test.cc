@@ -0,0 +1,241 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_mesh.hh"
+#include "BKE_pointcloud.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "GEO_join_geometries.hh"
+#include "GEO_mesh_primitive_cuboid.hh"
+
+namespace blender::geometry::tests {
+
+using bke::AttrDomain;
+using bke::GeometrySet;
+
+class JoinGeometriesTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+static GeometrySet create_pointcloud(const int points_num, const float value)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(points_num);
+  bke::MutableAttributeAccessor attributes = pointcloud->attributes_for_write();
+  bke::SpanAttributeWriter<float> attribute =
+      attributes.lookup_or_add_for_write_only_span<float>("a", AttrDomain::Point);
+  attribute.span.fill(value);
+  attribute.finish();
+  return GeometrySet::from_pointcloud(pointcloud);
+}
+
+static void fill_attribute(GeometrySet &geometry, const StringRef name, const float value)
+{
+  bke::MutableAttributeAccessor attributes =
+      geometry.get_pointcloud_for_write()->attributes_for_write();
+  bke::SpanAttributeWriter<float> attribute = attributes.lookup_or_add_for_write_span<float>(
+      name, AttrDomain::Point);
+  attribute.span.fill(value);
+  attribute.finish();
+}
+
+static const void *attribute_data(const GeometrySet &geometry, const StringRef name)
+{
+  const bke::AttributeAccessor attributes = geometry.get_pointcloud()->attributes();
+  return attributes.lookup<float>(name).varray.get_internal_span().data();
+}
+
+static Array<float> attribute_values(const GeometrySet &geometry, const StringRef name)
+{
+  const bke::AttributeAccessor attributes = geometry.get_pointcloud()->attributes();
+  const VArraySpan<float> values = *attributes.lookup<float>(name);
+  return Array<float>(Span<float>(values));
+}
+
+static Vector<std::string> attribute_names(const bke::AttributeAccessor &attributes)
+{
+  Vector<std::string> names;
+  attributes.for_all([&](const bke::AttributeIDRef &id, const bke::AttributeMetaData & /*meta*/) {
+    names.append(id.name());
+    return true;
+  });
+  return names;
+}
+
+TEST_F(JoinGeometriesTest, CacheSharesUnchangedAttribute)
+{
+  const Array<GeometrySet> geometries = {create_pointcloud(3, 1.0f), create_pointcloud(4, 2.0f)};
+  JoinAttributesCache cache;
+  const GeometrySet first = join_geometries(geometries, {}, &cache);
+  const GeometrySet second = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(attribute_data(first, "a"), attribute_data(second, "a"));
+  EXPECT_EQ(attribute_values(second, "a").as_span(),
+            Span<float>({1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f}));
+}
+
+TEST_F(JoinGeometriesTest, CacheUpdatesUnusedArrayInPlace)
+{
+  Array<GeometrySet> geometries = {create_pointcloud(3, 1.0f), create_pointcloud(4, 2.0f)};
+  JoinAttributesCache cache;
+  GeometrySet first = join_geometries(geometries, {}, &cache);
+  const void *first_data = attribute_data(first, "a");
+  /* Only the cache uses the joined array now. */
+  first.clear();
+
+  fill_attribute(geometries[1], "a", 5.0f);
+  const GeometrySet second = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(attribute_data(second, "a"), first_data);
+  EXPECT_EQ(attribute_values(second, "a").as_span(),
+            Span<float>({1.0f, 1.0f, 1.0f, 5.0f, 5.0f, 5.0f, 5.0f}));
+}
+
+TEST_F(JoinGeometriesTest, CacheCopiesArrayInUse)
+{
+  Array<GeometrySet> geometries = {create_pointcloud(3, 1.0f), create_pointcloud(4, 2.0f)};
+  JoinAttributesCache cache;
+  const GeometrySet first = join_geometries(geometries, {}, &cache);
+
+  fill_attribute(geometries[0], "a", 5.0f);
+  const GeometrySet second = join_geometries(geometries, {}, &cache);
+  EXPECT_NE(attribute_data(second, "a"), attribute_data(first, "a"));
+  EXPECT_EQ(attribute_values(first, "a").as_span(),
+            Span<float>({1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f}));
+  EXPECT_EQ(attribute_values(second, "a").as_span(),
+            Span<float>({5.0f, 5.0f, 5.0f, 2.0f, 2.0f, 2.0f, 2.0f}));
+}
+
+TEST_F(JoinGeometriesTest, CacheAddAndRemoveAttribute)
+{
+  Array<GeometrySet> geometries = {create_pointcloud(3, 1.0f), create_pointcloud(4, 2.0f)};
+  JoinAttributesCache cache;
+  join_geometries(geometries, {}, &cache);
+
+  fill_attribute(geometries[0], "b", 3.0f);
+  const GeometrySet added = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(attribute_values(added, "b").as_span(),
+            Span<float>({3.0f, 3.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f}));
+  EXPECT_EQ(attribute_values(added, "a").as_span(),
+            Span<float>({1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 2.0f}));
+
+  for (GeometrySet &geometry : geometries) {
+    geometry.get_pointcloud_for_write()->attributes_for_write().remove("a");
+  }
+  const GeometrySet removed = join_geometries(geometries, {}, &cache);
+  EXPECT_FALSE(removed.get_pointcloud()->attributes().contains("a"));
+  EXPECT_FALSE(cache.attributes.contains({bke::GeometryComponent::Type::PointCloud, "a"}));
+  EXPECT_EQ(attribute_values(removed, "b").as_span(),
+            Span<float>({3.0f, 3.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f}));
+}
+
+TEST_F(JoinGeometriesTest, CacheKeepsAttributeOrder)
+{
+  Array<GeometrySet> geometries(3);
+  for (const int i : geometries.index_range()) {
+    Mesh *mesh = create_cuboid_mesh(float3(1.0f), 2, 2, 2);
+    bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
+    attributes.add<float>("d", AttrDomain::Face, bke::AttributeInitDefaultValue());
+    attributes.add<float>("a", AttrDomain::Point, bke::AttributeInitDefaultValue());
+    attributes.add<int>("c", AttrDomain::Edge, bke::AttributeInitDefaultValue());
+    if (i == 1) {
+      attributes.add<float>("b", AttrDomain::Point, bke::AttributeInitDefaultValue());
+    }
+    geometries[i] = GeometrySet::from_mesh(mesh);
+  }
+  const GeometrySet expected = join_geometries(geometries, {});
+  const Vector<std::string> expected_names = attribute_names(expected.get_mesh()->attributes());
+
+  JoinAttributesCache cache;
+  const GeometrySet first = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(attribute_names(first.get_mesh()->attributes()), expected_names);
+  const GeometrySet second = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(attribute_names(second.get_mesh()->attributes()), expected_names);
+}
+
+static const void *mesh_attribute_data(const GeometrySet &geometry, const StringRef name)
+{
+  const bke::AttributeAccessor attributes = geometry.get_mesh()->attributes();
+  return attributes.lookup(name).varray.get_internal_span().data();
+}
+
+static void expect_same_mesh(const Mesh &a, const Mesh &b)
+{
+  EXPECT_EQ(a.vert_positions(), b.vert_positions());
+  EXPECT_EQ(a.edges(), b.edges());
+  EXPECT_EQ(a.face_offsets(), b.face_offsets());
+  EXPECT_EQ(a.corner_verts(), b.corner_verts());
+  EXPECT_EQ(a.corner_edges(), b.corner_edges());
+}
+
+TEST_F(JoinGeometriesTest, CacheSharesBuiltinArrays)
+{
+  const Array<GeometrySet> geometries = {
+      GeometrySet::from_mesh(create_cuboid_mesh(float3(1.0f), 2, 2, 2)),
+      GeometrySet::from_mesh(create_cuboid_mesh(float3(2.0f), 3, 3, 3))};
+  JoinAttributesCache cache;
+  const GeometrySet first = join_geometries(geometries, {}, &cache);
+  const GeometrySet second = join_geometries(geometries, {}, &cache);
+  for (const StringRef name : {"position", ".edge_verts", ".corner_vert", ".corner_edge"}) {
+    EXPECT_EQ(mesh_attribute_data(first, name), mesh_attribute_data(second, name));
+  }
+  EXPECT_EQ(first.get_mesh()->face_offsets().data(), second.get_mesh()->face_offsets().data());
+
+  const GeometrySet expected = join_geometries(geometries, {});
+  expect_same_mesh(*second.get_mesh(), *expected.get_mesh());
+}
+
+TEST_F(JoinGeometriesTest, CacheOffsetsIndicesOfChangedMesh)
+{
+  Array<GeometrySet> geometries = {
+      GeometrySet::from_mesh(create_cuboid_mesh(float3(1.0f), 2, 2, 2)),
+      GeometrySet::from_mesh(create_cuboid_mesh(float3(1.0f), 2, 2, 2))};
+  JoinAttributesCache cache;
+  join_geometries(geometries, {}, &cache);
+
+  /* The second mesh is unchanged, but its indices start after the larger first mesh now. */
+  geometries[0] = GeometrySet::from_mesh(create_cuboid_mesh(float3(1.0f), 4, 3, 2));
+  const GeometrySet joined = join_geometries(geometries, {}, &cache);
+  const GeometrySet expected = join_geometries(geometries, {});
+  expect_same_mesh(*joined.get_mesh(), *expected.get_mesh());
+}
+
+TEST_F(JoinGeometriesTest, CacheBuiltinDefaultValue)
+{
+  GeometrySet with_radius = create_pointcloud(3, 1.0f);
+  fill_attribute(with_radius, "radius", 0.5f);
+  const Array<GeometrySet> geometries = {with_radius, create_pointcloud(2, 2.0f)};
+  JoinAttributesCache cache;
+  const GeometrySet joined = join_geometries(geometries, {}, &cache);
+  const GeometrySet expected = join_geometries(geometries, {});
+  EXPECT_EQ(attribute_values(joined, "radius").as_span(),
+            attribute_values(expected, "radius").as_span());
+}
+
+TEST_F(JoinGeometriesTest, CacheUnsharedMemory)
+{
+  const Array<GeometrySet> geometries = {create_pointcloud(3, 1.0f), create_pointcloud(4, 2.0f)};
+  JoinAttributesCache cache;
+  GeometrySet joined = join_geometries(geometries, {}, &cache);
+  EXPECT_EQ(cache.unshared_memory_size(), 0);
+
+  joined.clear();
+  /* The "a" and "position" attributes. */
+  EXPECT_EQ(cache.unshared_memory_size(), int64_t(7 * (sizeof(float) + sizeof(float3))));
+  cache.remove_unshared();
+  EXPECT_EQ(cache.unshared_memory_size(), 0);
+  EXPECT_TRUE(cache.attributes.is_empty());
+}
+
+}  // namespace blender::geometry::tests
@@ -0,0 +1,171 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array_utils.hh"
+#include "BLI_math_matrix.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_instances.hh"
+#include "BKE_mesh.hh"
+#include "BKE_pointcloud.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "GEO_join_geometries.hh"
+#include "GEO_mesh_primitive_cuboid.hh"
+#include "GEO_realize_instances.hh"
+
+namespace blender::geometry::tests {
+
+using bke::AttrDomain;
+using bke::GeometrySet;
+
+class RealizeInstancesTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+static PointCloud *create_pointcloud(const int points_num,
+                                     const StringRef attribute_name,
+                                     const bool with_ids)
+{
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(points_num);
+  bke::MutableAttributeAccessor attributes = pointcloud->attributes_for_write();
+  MutableSpan<float3> positions = pointcloud->positions_for_write();
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(i, 0.0f, 0.0f);
+  }
+  bke::SpanAttributeWriter<float> attribute =
+      attributes.lookup_or_add_for_write_only_span<float>(attribute_name, AttrDomain::Point);
+  attribute.span.fill(float(points_num));
+  attribute.finish();
+  if (with_ids) {
+    bke::SpanAttributeWriter<int> ids = attributes.lookup_or_add_for_write_only_span<int>(
+        "id", AttrDomain::Point);
+    array_utils::fill_index_range(ids.span, 100);
+    ids.finish();
+  }
+  return pointcloud;
+}
+
+/**
+ * Point cloud instances with different attributes, and a point cloud that is not instanced.
+ */
+static GeometrySet create_instanced_pointclouds(const int instances_num)
+{
+  bke::Instances *instances = new bke::Instances();
+  const int handle_a = instances->add_reference(
+      bke::InstanceReference{GeometrySet::from_pointcloud(create_pointcloud(3, "a", true))});
+  const int handle_b = instances->add_reference(
+      bke::InstanceReference{GeometrySet::from_pointcloud(create_pointcloud(5, "b", false))});
+  instances->resize(instances_num);
+  MutableSpan<int> handles = instances->reference_handles_for_write();
+  MutableSpan<float4x4> transforms = instances->transforms_for_write();
+  for (const int i : IndexRange(instances_num)) {
+    handles[i] = i % 3 == 0 ? handle_b : handle_a;
+    transforms[i] = math::from_location<float4x4>(float3(0.0f, i, 0.0f));
+  }
+  GeometrySet geometry_set = GeometrySet::from_instances(instances);
+  geometry_set.replace_pointcloud(create_pointcloud(4, "c", false));
+  return geometry_set;
+}
+
+static Vector<std::string> attribute_names(const bke::AttributeAccessor &attributes)
+{
+  Vector<std::string> names;
+  attributes.for_all([&](const bke::AttributeIDRef &id, const bke::AttributeMetaData & /*meta*/) {
+    names.append(id.name());
+    return true;
+  });
+  return names;
+}
+
+TEST_F(RealizeInstancesTest, BatchesMatchRealizeInstances)
+{
+  const GeometrySet geometry_set = create_instanced_pointclouds(50);
+  RealizeInstancesOptions options;
+  options.keep_original_ids = false;
+  options.realize_instance_attributes = true;
+
+  const GeometrySet realized = realize_instances(geometry_set, options);
+  const PointCloud &expected = *realized.get_pointcloud();
+  const Vector<std::string> expected_names = attribute_names(expected.attributes());
+  EXPECT_EQ(expected_names.size(), 5);
+
+  Vector<float3> positions;
+  Vector<int> ids;
+  Vector<float> values_a;
+  int batches_num = 0;
+  /* Every instance uses less than 200 bytes, so most batches contain multiple instances. */
+  realize_instances_in_batches(geometry_set, options, 500, [&](GeometrySet batch) {
+    batches_num++;
+    EXPECT_FALSE(batch.has_instances());
+    const PointCloud &pointcloud = *batch.get_pointcloud();
+    const bke::AttributeAccessor attributes = pointcloud.attributes();
+    EXPECT_EQ(attribute_names(attributes), expected_names);
+    positions.extend(pointcloud.positions());
+    const VArraySpan<int> batch_ids = *attributes.lookup<int>("id");
+    ids.extend(batch_ids);
+    const VArraySpan<float> batch_values_a = *attributes.lookup<float>("a");
+    values_a.extend(batch_values_a);
+  });
+  EXPECT_GT(batches_num, 5);
+
+  const bke::AttributeAccessor expected_attributes = expected.attributes();
+  EXPECT_EQ(positions.as_span(), expected.positions());
+  const VArraySpan<int> expected_ids = *expected_attributes.lookup<int>("id");
+  EXPECT_EQ(ids.as_span(), Span<int>(expected_ids));
+  const VArraySpan<float> expected_values_a = *expected_attributes.lookup<float>("a");
+  EXPECT_EQ(values_a.as_span(), Span<float>(expected_values_a));
+}
+
+TEST_F(RealizeInstancesTest, JoinedBatchesMatchRealizeInstances)
+{
+  bke::Instances *instances = new bke::Instances();
+  Mesh *mesh = create_cuboid_mesh(float3(1.0f), 3, 3, 3);
+  bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
+  bke::SpanAttributeWriter<int> mesh_ids = attributes.lookup_or_add_for_write_only_span<int>(
+      "id", AttrDomain::Point);
+  array_utils::fill_index_range(mesh_ids.span);
+  mesh_ids.finish();
+  const int handle = instances->add_reference(
+      bke::InstanceReference{GeometrySet::from_mesh(mesh)});
+  for (const int i : IndexRange(20)) {
+    instances->add_instance(handle, math::from_location<float4x4>(float3(i, 0.0f, 0.0f)));
+  }
+  const GeometrySet geometry_set = GeometrySet::from_instances(instances);
+  RealizeInstancesOptions options;
+  options.keep_original_ids = false;
+  options.realize_instance_attributes = true;
+
+  const GeometrySet realized = realize_instances(geometry_set, options);
+  Vector<GeometrySet> batches;
+  realize_instances_in_batches(geometry_set, options, 2000, [&](GeometrySet batch) {
+    batches.append(std::move(batch));
+  });
+  EXPECT_GT(batches.size(), 1);
+  const GeometrySet joined = join_geometries(batches, {});
+
+  const Mesh &expected_mesh = *realized.get_mesh();
+  const Mesh &joined_mesh = *joined.get_mesh();
+  EXPECT_EQ(joined_mesh.vert_positions(), expected_mesh.vert_positions());
+  EXPECT_EQ(joined_mesh.edges(), expected_mesh.edges());
+  EXPECT_EQ(joined_mesh.face_offsets(), expected_mesh.face_offsets());
+  EXPECT_EQ(joined_mesh.corner_verts(), expected_mesh.corner_verts());
+  EXPECT_EQ(attribute_names(joined_mesh.attributes()),
+            attribute_names(expected_mesh.attributes()));
+  const VArraySpan<int> joined_ids = *joined_mesh.attributes().lookup<int>("id");
+  const VArraySpan<int> expected_ids = *expected_mesh.attributes().lookup<int>("id");
+  EXPECT_EQ(Span<int>(joined_ids), Span<int>(expected_ids));
+}
+
+}  // namespace blender::geometry::tests
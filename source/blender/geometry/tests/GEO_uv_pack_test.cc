@@ -0,0 +1,162 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <array>
+
+#include "BLI_array.hh"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_system.h"
+#include "BLI_task.h"
+#include "BLI_vector.hh"
+
+#include "GEO_uv_pack.hh"
+
+namespace blender::geometry::tests {
+
+struct PackResult {
+  float scale;
+  Array<float2> translations;
+  Array<float> angles;
+};
+
+/**
+ * L-shaped islands of different sizes, which can be interlocked by the `xatlas` strategy but not
+ * by the bounding box based strategies.
+ */
+static Array<PackIsland> l_shaped_islands(const int islands_num)
+{
+  RandomNumberGenerator rng(7);
+  Array<PackIsland> islands(islands_num);
+  for (const int i : islands.index_range()) {
+    const float size = 0.05f + rng.get_float() * 0.2f;
+    const float2 offset(rng.get_float(), rng.get_float());
+    const float width = size * 0.3f;
+    const float height = size * (1.0f + i % 3);
+    const float2 corner = offset + float2(0.0f, width);
+    const float2 inner_corner = offset + float2(width, width);
+    islands[i].add_triangle(offset, offset + float2(size, 0.0f), offset + float2(size, width));
+    islands[i].add_triangle(offset, offset + float2(size, width), corner);
+    islands[i].add_triangle(corner, inner_corner, offset + float2(width, height));
+    islands[i].add_triangle(corner, offset + float2(width, height), offset + float2(0.0f, height));
+    islands[i].caller_index = i;
+  }
+  return islands;
+}
+
+static UVPackIsland_Params concave_params()
+{
+  UVPackIsland_Params params;
+  params.shape_method = ED_UVPACK_SHAPE_CONCAVE;
+  params.rotate_method = ED_UVPACK_ROTATION_CARDINAL;
+  params.margin_method = ED_UVPACK_MARGIN_ADD;
+  params.margin = 0.002f;
+  return params;
+}
+
+static PackResult pack(const int islands_num, const int threads_num)
+{
+  BLI_system_num_threads_override_set(threads_num);
+  BLI_task_scheduler_init();
+
+  Array<PackIsland> islands = l_shaped_islands(islands_num);
+  Array<PackIsland *> island_ptrs(islands.size());
+  for (const int i : islands.index_range()) {
+    island_ptrs[i] = &islands[i];
+  }
+  PackResult result;
+  result.scale = pack_islands(island_ptrs, concave_params());
+  result.translations.reinitialize(islands.size());
+  result.angles.reinitialize(islands.size());
+  for (const int i : islands.index_range()) {
+    result.translations[i] = islands[i].pre_translate;
+    result.angles[i] = islands[i].angle;
+  }
+
+  BLI_task_scheduler_exit();
+  BLI_system_num_threads_override_set(0);
+  return result;
+}
+
+/** The triangles of the island after packing, slightly shrunk to ignore touching edges. */
+static Vector<std::array<float2, 3>> packed_triangles(const PackIsland &island,
+                                                      const PackResult &result,
+                                                      const int index)
+{
+  float matrix[2][2];
+  island.build_transformation(result.scale, result.angles[index], matrix);
+  Vector<std::array<float2, 3>> triangles;
+  for (int i = 0; i < island.triangle_vertices_.size(); i += 3) {
+    std::array<float2, 3> triangle;
+    for (const int j : IndexRange(3)) {
+      mul_v2_m2_add_v2v2(
+          triangle[j], matrix, island.triangle_vertices_[i + j], result.translations[index]);
+    }
+    const float2 center = (triangle[0] + triangle[1] + triangle[2]) / 3.0f;
+    for (float2 &position : triangle) {
+      position = math::interpolate(center, position, 0.99f);
+    }
+    triangles.append(triangle);
+  }
+  return triangles;
+}
+
+static void expect_no_overlaps(const int islands_num, const PackResult &result)
+{
+  const Array<PackIsland> islands = l_shaped_islands(islands_num);
+  Array<Vector<std::array<float2, 3>>> triangles(islands_num);
+  for (const int i : islands.index_range()) {
+    triangles[i] = packed_triangles(islands[i], result, i);
+    for (const std::array<float2, 3> &triangle : triangles[i]) {
+      for (const float2 &position : triangle) {
+        EXPECT_GE(position.x, -1e-4f);
+        EXPECT_GE(position.y, -1e-4f);
+        EXPECT_LE(position.x, 1.0f + 1e-4f);
+        EXPECT_LE(position.y, 1.0f + 1e-4f);
+      }
+    }
+  }
+  for (const int i : islands.index_range()) {
+    for (const int j : islands.index_range().drop_front(i + 1)) {
+      for (const std::array<float2, 3> &a : triangles[i]) {
+        for (const std::array<float2, 3> &b : triangles[j]) {
+          EXPECT_FALSE(isect_tri_tri_v2(a[0], a[1], a[2], b[0], b[1], b[2])) << i << " " << j;
+        }
+      }
+    }
+  }
+}
+
+TEST(uv_pack, ConcaveIslandsDoNotOverlap)
+{
+  expect_no_overlaps(60, pack(60, 0));
+}
+
+TEST(uv_pack, ConcaveSingleThread)
+{
+  /* With a single thread, scan lines are searched one at a time, which gives the same layout as
+   * before the scan lines were searched in parallel. */
+  const PackResult result = pack(100, 1);
+  EXPECT_NEAR(result.scale, 0.583323658f, 1e-5f);
+  EXPECT_V2_NEAR(result.translations[0], float2(0.286885113f, 0.325512528f), 1e-5f);
+  EXPECT_V2_NEAR(result.translations[1], float2(1.23596358f, 0.908922315f), 1e-5f);
+  EXPECT_V2_NEAR(result.translations[50], float2(0.594674289f, 0.134230822f), 1e-5f);
+  EXPECT_V2_NEAR(result.translations[99], float2(0.255978197f, 0.0396106839f), 1e-5f);
+}
+
+TEST(uv_pack, ConcaveParallelSearch)
+{
+  /* Searching scan lines in parallel batches discards the hints of scan lines where an island
+   * doesn't fit, which can move some islands slightly, but shouldn't make the packing less
+   * efficient. */
+  const int islands_num = 100;
+  const PackResult result = pack(islands_num, 4);
+  EXPECT_NEAR(result.scale, 0.583323658f, 1e-5f);
+  expect_no_overlaps(islands_num, result);
+}
+
+}  // namespace blender::geometry::tests
@@ -0,0 +1,77 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup io
+ */
+
+#pragma once
+
+struct Main;
+struct ReportList;
+struct Scene;
+struct ViewLayer;
+
+namespace blender::io {
+
+/**
+ * State shared between a running #FileImportTask and the job that runs it.
+ * Pointers may be null when the task runs without a job (e.g. from tests).
+ */
+struct FileImportTaskStatus {
+  /** Set from the main thread when the user cancels the import. */
+  const bool *stop = nullptr;
+  /** Overall progress of the job, updated through #set_progress. */
+  float *progress = nullptr;
+  bool *do_update = nullptr;
+  /** Part of the overall progress that belongs to this file. */
+  float progress_start = 0.0f;
+  float progress_range = 1.0f;
+  /** Reports are thread-safe, so they can be added to from the worker thread. */
+  ReportList *reports = nullptr;
+
+  bool stop_requested() const
+  {
+    return stop != nullptr && *stop;
+  }
+
+  /** Set the progress of this file, from zero to one. */
+  void set_progress(const float fraction)
+  {
+    if (progress != nullptr) {
+      *progress = progress_start + progress_range * fraction;
+    }
+    if (do_update != nullptr) {
+      *do_update = true;
+    }
+  }
+};
+
+/**
+ * Import of a single file, split into two stages so that the expensive part can run in a
+ * background job without blocking the user interface:
+ *
+ * - #read runs on a worker thread. It must not access #Main or any other global data; it parses
+ *   the file and builds geometry outside of Main (e.g. with #BKE_mesh_new_nomain).
+ * - #add_to_main runs on the main thread once reading succeeded, and creates the data-blocks and
+ *   objects in the scene.
+ */
+class FileImportTask {
+ public:
+  virtual ~FileImportTask() = default;
+
+  /**
+   * Read and decode the file. Errors are added to the status reports. Reading large files should
+   * report progress and check #FileImportTaskStatus::stop_requested regularly.
+   * \return False if reading failed or was canceled, #add_to_main is not called then.
+   */
+  virtual bool read(FileImportTaskStatus &status) = 0;
+
+  virtual void add_to_main(Main *bmain,
+                           Scene *scene,
+                           ViewLayer *view_layer,
+                           ReportList *reports) = 0;
+};
+
+}  // namespace blender::io
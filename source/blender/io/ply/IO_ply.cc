@@ -38,3 +38,8 @@ void PLY_import(bContext *C, const PLYImportParams *import_params)
   blender::io::ply::importer_main(C, *import_params);
   report_duration("import", start_time, import_params->filepath);
 }
+
+std::unique_ptr<blender::io::FileImportTask> PLY_import_task(const PLYImportParams *import_params)
+{
+  return blender::io::ply::create_import_task(*import_params);
+}
@@ -8,10 +8,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "BLI_path_util.h"
 
 #include "DNA_ID.h"
 
+#include "IO_file_import_task.hh"
 #include "IO_orientation.hh"
 
 struct bContext;
@@ -63,6 +66,10 @@ struct PLYImportParams {
   ePLYVertexColorMode vertex_colors;
   bool import_attributes;
   bool merge_verts;
+  /** Import files without faces or edges as a point cloud instead of a mesh. */
+  bool import_as_point_cloud;
+  /** When importing a point cloud, keep only one point per grid cell of this size (if > 0). */
+  float point_cloud_voxel_size;
 
   ReportList *reports = nullptr;
 };
@@ -73,3 +80,6 @@ struct PLYImportParams {
 void PLY_export(bContext *C, const PLYExportParams *export_params);
 
 void PLY_import(bContext *C, const PLYImportParams *import_params);
+
+/** Import that can run as a background job, see #blender::io::FileImportTask. */
+std::unique_ptr<blender::io::FileImportTask> PLY_import_task(const PLYImportParams *import_params);
@@ -8,12 +8,15 @@
 
 #include "BKE_context.hh"
 #include "BKE_layer.hh"
+#include "BKE_lib_id.hh"
 #include "BKE_mesh.hh"
 #include "BKE_object.hh"
+#include "BKE_pointcloud.hh"
 #include "BKE_report.hh"
 
 #include "DNA_collection_types.h"
 #include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
 #include "DNA_scene_types.h"
 
 #include "BLI_math_matrix.h"
@@ -30,6 +33,7 @@
 #include "ply_import_buffer.hh"
 #include "ply_import_data.hh"
 #include "ply_import_mesh.hh"
+#include "ply_import_pointcloud.hh"
 
 namespace blender::io::ply {
 
@@ -169,82 +173,150 @@ void importer_main(bContext *C, const PLYImportParams &import_params)
   importer_main(bmain, scene, view_layer, import_params);
 }
 
+/**
+ * Reads the file and builds the mesh or point cloud outside of Main on a worker thread, then adds
+ * it to the scene on the main thread.
+ */
+class PlyImportTask : public FileImportTask {
+  PLYImportParams params_;
+  /** File base name used for both mesh and object. */
+  char ob_name_[FILE_MAX];
+  Mesh *mesh_ = nullptr;
+  PointCloud *pointcloud_ = nullptr;
+
+ public:
+  PlyImportTask(const PLYImportParams &params) : params_(params)
+  {
+    STRNCPY(ob_name_, BLI_path_basename(params_.filepath));
+    BLI_path_extension_strip(ob_name_);
+  }
+
+  ~PlyImportTask() override
+  {
+    if (mesh_ != nullptr) {
+      BKE_id_free(nullptr, mesh_);
+    }
+    if (pointcloud_ != nullptr) {
+      BKE_id_free(nullptr, pointcloud_);
+    }
+  }
+
+  bool read(FileImportTaskStatus &status) override
+  {
+    /* Parse header. Binary element data is read through a memory mapping when possible. */
+    PlyReadBuffer file(params_.filepath, 64 * 1024, true);
+    file.set_import_status(&status, 0.5f);
+
+    PlyHeader header;
+    const char *err = read_header(file, header);
+    if (err != nullptr) {
+      fprintf(stderr, "PLY Importer: %s: %s\n", ob_name_, err);
+      BKE_reportf(status.reports, RPT_ERROR, "PLY Importer: %s: %s", ob_name_, err);
+      return false;
+    }
+
+    /* Parse actual file data. */
+    std::unique_ptr<PlyData> data = import_ply_data(file, header);
+    if (status.stop_requested()) {
+      return false;
+    }
+    if (data == nullptr) {
+      fprintf(stderr, "PLY Importer: failed importing %s, unknown error\n", ob_name_);
+      BKE_report(status.reports, RPT_ERROR, "PLY Importer: failed importing, unknown error");
+      return false;
+    }
+    if (!data->error.empty()) {
+      fprintf(stderr, "PLY Importer: failed importing %s: %s\n", ob_name_, data->error.c_str());
+      BKE_report(status.reports, RPT_ERROR, "PLY Importer: failed importing, unknown error");
+      return false;
+    }
+    if (data->vertices.is_empty()) {
+      fprintf(stderr, "PLY Importer: file %s contains no vertices\n", ob_name_);
+      BKE_report(status.reports, RPT_ERROR, "PLY Importer: failed importing, no vertices");
+      return false;
+    }
+    status.set_progress(0.5f);
+
+    /* Stuff ply data into the mesh or point cloud. */
+    if (params_.import_as_point_cloud && data->face_sizes.is_empty() && data->edges.is_empty()) {
+      pointcloud_ = convert_ply_to_point_cloud(*data, params_);
+    }
+    else {
+      mesh_ = convert_ply_to_mesh(*data, params_);
+    }
+    return true;
+  }
+
+  void add_to_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   ReportList * /*reports*/) override
+  {
+    /* Create the object and move the mesh or point cloud into Main. */
+    BKE_view_layer_base_deselect_all(scene, view_layer);
+    LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+    Object *obj = BKE_object_add_only_object(
+        bmain, pointcloud_ ? OB_POINTCLOUD : OB_MESH, ob_name_);
+    if (pointcloud_) {
+      PointCloud *pointcloud_in_main = static_cast<PointCloud *>(
+          BKE_pointcloud_add(bmain, ob_name_));
+      BKE_pointcloud_nomain_to_pointcloud(pointcloud_, pointcloud_in_main);
+      pointcloud_ = nullptr;
+      obj->data = pointcloud_in_main;
+    }
+    else {
+      Mesh *mesh_in_main = BKE_mesh_add(bmain, ob_name_);
+      obj->data = mesh_in_main;
+      BKE_mesh_nomain_to_mesh(mesh_, mesh_in_main, obj);
+      mesh_ = nullptr;
+    }
+    BKE_collection_object_add(bmain, lc->collection, obj);
+    BKE_view_layer_synced_ensure(scene, view_layer);
+    Base *base = BKE_view_layer_base_find(view_layer, obj);
+    BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+    /* Object matrix and finishing up. */
+    float global_scale = params_.global_scale;
+    if ((scene->unit.system != USER_UNIT_NONE) && params_.use_scene_unit) {
+      global_scale /= scene->unit.scale_length;
+    }
+    float scale_vec[3] = {global_scale, global_scale, global_scale};
+    float obmat3x3[3][3];
+    unit_m3(obmat3x3);
+    float obmat4x4[4][4];
+    unit_m4(obmat4x4);
+    /* +Y-forward and +Z-up are the Blender's default axis settings. */
+    mat3_from_axis_conversion(
+        IO_AXIS_Y, IO_AXIS_Z, params_.forward_axis, params_.up_axis, obmat3x3);
+    copy_m4_m3(obmat4x4, obmat3x3);
+    rescale_m4(obmat4x4, scale_vec);
+    BKE_object_apply_mat4(obj, obmat4x4, true, false);
+
+    DEG_id_tag_update(&lc->collection->id, ID_RECALC_SYNC_TO_EVAL);
+    int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+                ID_RECALC_BASE_FLAGS;
+    DEG_id_tag_update_ex(bmain, &obj->id, flags);
+    DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+    DEG_relations_tag_update(bmain);
+  }
+};
+
+std::unique_ptr<FileImportTask> create_import_task(const PLYImportParams &import_params)
+{
+  return std::make_unique<PlyImportTask>(import_params);
+}
+
 void importer_main(Main *bmain,
                    Scene *scene,
                    ViewLayer *view_layer,
                    const PLYImportParams &import_params)
 {
-  /* File base name used for both mesh and object. */
-  char ob_name[FILE_MAX];
-  STRNCPY(ob_name, BLI_path_basename(import_params.filepath));
-  BLI_path_extension_strip(ob_name);
-
-  /* Parse header. */
-  PlyReadBuffer file(import_params.filepath, 64 * 1024);
-
-  PlyHeader header;
-  const char *err = read_header(file, header);
-  if (err != nullptr) {
-    fprintf(stderr, "PLY Importer: %s: %s\n", ob_name, err);
-    BKE_reportf(import_params.reports, RPT_ERROR, "PLY Importer: %s: %s", ob_name, err);
-    return;
-  }
-
-  /* Parse actual file data. */
-  std::unique_ptr<PlyData> data = import_ply_data(file, header);
-  if (data == nullptr) {
-    fprintf(stderr, "PLY Importer: failed importing %s, unknown error\n", ob_name);
-    BKE_report(import_params.reports, RPT_ERROR, "PLY Importer: failed importing, unknown error");
-    return;
-  }
-  if (!data->error.empty()) {
-    fprintf(stderr, "PLY Importer: failed importing %s: %s\n", ob_name, data->error.c_str());
-    BKE_report(import_params.reports, RPT_ERROR, "PLY Importer: failed importing, unknown error");
-    return;
-  }
-  if (data->vertices.is_empty()) {
-    fprintf(stderr, "PLY Importer: file %s contains no vertices\n", ob_name);
-    BKE_report(import_params.reports, RPT_ERROR, "PLY Importer: failed importing, no vertices");
-    return;
-  }
-
-  /* Create mesh and do all prep work. */
-  Mesh *mesh_in_main = BKE_mesh_add(bmain, ob_name);
-  BKE_view_layer_base_deselect_all(scene, view_layer);
-  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
-  Object *obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name);
-  obj->data = mesh_in_main;
-  BKE_collection_object_add(bmain, lc->collection, obj);
-  BKE_view_layer_synced_ensure(scene, view_layer);
-  Base *base = BKE_view_layer_base_find(view_layer, obj);
-  BKE_view_layer_base_select_and_set_active(view_layer, base);
-
-  /* Stuff ply data into the mesh. */
-  Mesh *mesh = convert_ply_to_mesh(*data, import_params);
-  BKE_mesh_nomain_to_mesh(mesh, mesh_in_main, obj);
-
-  /* Object matrix and finishing up. */
-  float global_scale = import_params.global_scale;
-  if ((scene->unit.system != USER_UNIT_NONE) && import_params.use_scene_unit) {
-    global_scale /= scene->unit.scale_length;
-  }
-  float scale_vec[3] = {global_scale, global_scale, global_scale};
-  float obmat3x3[3][3];
-  unit_m3(obmat3x3);
-  float obmat4x4[4][4];
-  unit_m4(obmat4x4);
-  /* +Y-forward and +Z-up are the Blender's default axis settings. */
-  mat3_from_axis_conversion(
-      IO_AXIS_Y, IO_AXIS_Z, import_params.forward_axis, import_params.up_axis, obmat3x3);
-  copy_m4_m3(obmat4x4, obmat3x3);
-  rescale_m4(obmat4x4, scale_vec);
-  BKE_object_apply_mat4(obj, obmat4x4, true, false);
-
-  DEG_id_tag_update(&lc->collection->id, ID_RECALC_SYNC_TO_EVAL);
-  int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
-              ID_RECALC_BASE_FLAGS;
-  DEG_id_tag_update_ex(bmain, &obj->id, flags);
-  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
-  DEG_relations_tag_update(bmain);
+  PlyImportTask task(import_params);
+  FileImportTaskStatus status;
+  status.reports = import_params.reports;
+  if (task.read(status)) {
+    task.add_to_main(bmain, scene, view_layer, import_params.reports);
+  }
 }
+
 }  // namespace blender::io::ply
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "IO_file_import_task.hh"
 #include "IO_ply.hh"
 #include "ply_data.hh"
 
@@ -29,6 +32,9 @@ void importer_main(Main *bmain,
                    ViewLayer *view_layer,
                    const PLYImportParams &import_params);
 
+/** Import split into reading on a worker thread and adding to Main, see #FileImportTask. */
+std::unique_ptr<FileImportTask> create_import_task(const PLYImportParams &import_params);
+
 const char *read_header(PlyReadBuffer &file, PlyHeader &r_header);
 
 }  // namespace blender::io::ply
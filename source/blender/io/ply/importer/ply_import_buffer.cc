@@ -5,6 +5,9 @@
 #include "ply_import_buffer.hh"
 
 #include "BLI_fileops.h"
+#include "BLI_mmap.h"
+
+#include "IO_file_import_task.hh"
 
 #include <cstdio>
 #include <cstring>
@@ -17,22 +20,80 @@ static inline bool is_newline(char ch)
 
 namespace blender::io::ply {
 
-PlyReadBuffer::PlyReadBuffer(const char *file_path, size_t read_buffer_size)
-    : buffer_(read_buffer_size), read_buffer_size_(read_buffer_size)
+PlyReadBuffer::PlyReadBuffer(const char *file_path, size_t read_buffer_size, bool use_mmap)
+    : buffer_(read_buffer_size), read_buffer_size_(read_buffer_size), use_mmap_(use_mmap)
 {
   file_ = BLI_fopen(file_path, "rb");
 }
 
 PlyReadBuffer::~PlyReadBuffer()
 {
+  if (mmap_file_ != nullptr) {
+    BLI_mmap_free(mmap_file_);
+  }
   if (file_ != nullptr) {
     fclose(file_);
   }
 }
 
+void PlyReadBuffer::set_import_status(FileImportTaskStatus *status, const float progress_end)
+{
+  import_status_ = status;
+  progress_end_ = progress_end;
+  if (file_ != nullptr) {
+    const size_t size = BLI_file_descriptor_size(fileno(file_));
+    file_size_ = size == size_t(-1) ? 0 : size;
+  }
+}
+
+bool PlyReadBuffer::update_import_status(const size_t file_offset)
+{
+  if (import_status_ == nullptr || file_offset < next_status_offset_) {
+    return true;
+  }
+  /* Don't update for every row that is read from the mapping. */
+  next_status_offset_ = file_offset + read_buffer_size_;
+  if (import_status_->stop_requested()) {
+    return false;
+  }
+  if (file_size_ > 0) {
+    import_status_->set_progress(progress_end_ * float(file_offset) / float(file_size_));
+  }
+  return true;
+}
+
 void PlyReadBuffer::after_header(bool is_binary)
 {
   is_binary_ = is_binary;
+  if (is_binary_ && use_mmap_) {
+    map_file();
+  }
+}
+
+void PlyReadBuffer::map_file()
+{
+  if (file_ == nullptr) {
+    return;
+  }
+  /* Position of the underlying file, restored if mapping fails (mapping seeks to the end). */
+  const size_t file_pos = buffer_file_offset_ + buf_used_;
+  const size_t read_pos = buffer_file_offset_ + pos_;
+
+  mmap_file_ = BLI_mmap_open(fileno(file_));
+  if (mmap_file_ != nullptr) {
+    const void *data = BLI_mmap_get_pointer(mmap_file_);
+    const size_t size = BLI_mmap_get_length(mmap_file_);
+    if (data != nullptr && read_pos <= size) {
+      mmap_data_ = static_cast<const uint8_t *>(data);
+      mmap_size_ = size;
+      mmap_pos_ = read_pos;
+      return;
+    }
+    BLI_mmap_free(mmap_file_);
+    mmap_file_ = nullptr;
+  }
+  /* Not an error, keep reading through the buffer. */
+  fseek(file_, long(file_pos), SEEK_SET);
 }
 
 Span<char> PlyReadBuffer::read_line()
@@ -62,6 +123,14 @@ Span<char> PlyReadBuffer::read_line()
 
 bool PlyReadBuffer::read_bytes(void *dst, size_t size)
 {
+  if (mmap_data_ != nullptr) {
+    const uint8_t *src = map_bytes(size);
+    if (src == nullptr) {
+      return false;
+    }
+    memcpy(dst, src, size);
+    return true;
+  }
   while (size > 0) {
     if (pos_ + size > buf_used_) {
       if (!refill_buffer()) {
@@ -80,6 +149,29 @@ bool PlyReadBuffer::read_bytes(void *dst, size_t size)
   return true;
 }
 
+const uint8_t *PlyReadBuffer::map_bytes(size_t size)
+{
+  if (mmap_data_ == nullptr || size > mmap_size_ - mmap_pos_) {
+    return nullptr;
+  }
+  if (!update_import_status(mmap_pos_)) {
+    return nullptr;
+  }
+  const uint8_t *ptr = mmap_data_ + mmap_pos_;
+  mmap_pos_ += size;
+  return ptr;
+}
+
+bool PlyReadBuffer::any_io_error() const
+{
+  if (mmap_file_ == nullptr) {
+    return false;
+  }
+  /* Reading nothing only fails when an earlier access to the mapped memory failed. */
+  char dummy;
+  return !BLI_mmap_read(mmap_file_, &dummy, 0, 0);
+}
+
 bool PlyReadBuffer::refill_buffer()
 {
   BLI_assert(pos_ <= buf_used_);
@@ -89,6 +181,9 @@ bool PlyReadBuffer::refill_buffer()
   if (file_ == nullptr || at_eof_) {
     return false; /* File is fully read. */
   }
+  if (!update_import_status(buffer_file_offset_ + pos_)) {
+    return false;
+  }
 
   /* Move any leftover to start of buffer. */
   int keep = buf_used_ - pos_;
@@ -96,6 +191,7 @@ bool PlyReadBuffer::refill_buffer()
     memmove(buffer_.data(), buffer_.data() + pos_, keep);
   }
   /* Read in data from the file. */
+  buffer_file_offset_ += pos_;
   size_t read = fread(buffer_.data() + keep, 1, read_buffer_size_ - keep, file_) + keep;
   at_eof_ = read < read_buffer_size_;
   pos_ = 0;
@@ -13,17 +13,33 @@
 #include "BLI_array.hh"
 #include "BLI_span.hh"
 
+struct BLI_mmap_file;
+
+namespace blender::io {
+struct FileImportTaskStatus;
+}
+
 namespace blender::io::ply {
 
 /**
  * Reads underlying PLY file in large chunks, and provides interface for ascii/header
  * parsing to read individual lines, and for binary parsing to read chunks of bytes.
+ *
+ * When \a use_mmap is set, the binary part of the file (everything after the header) is
+ * memory-mapped instead, which allows direct access to whole element blocks without copying
+ * them through the read buffer first (see #map_bytes).
  */
 class PlyReadBuffer {
  public:
-  PlyReadBuffer(const char *file_path, size_t read_buffer_size = 64 * 1024);
+  PlyReadBuffer(const char *file_path, size_t read_buffer_size = 64 * 1024, bool use_mmap = false);
   ~PlyReadBuffer();
 
+  /**
+   * Report the read position of the file as progress, from zero to \a progress_end, and stop
+   * reading when the import is canceled. Reading fails then as if the file ended.
+   */
+  void set_import_status(FileImportTaskStatus *status, float progress_end);
+
   /** After header is parsed, indicate whether the rest of reading will be ascii or binary. */
   void after_header(bool is_binary);
 
@@ -38,18 +54,52 @@ class PlyReadBuffer {
    */
   bool read_bytes(void *dst, size_t size);
 
+  /** Whether binary data is read from a memory-mapped file. */
+  bool is_memory_mapped() const
+  {
+    return mmap_data_ != nullptr;
+  }
+
+  /**
+   * Returns a pointer to the next \a size bytes of the memory-mapped file and advances past
+   * them. Returns null if the file is not memory-mapped or does not contain enough bytes.
+   */
+  const uint8_t *map_bytes(size_t size);
+
+  /**
+   * Whether reading the memory-mapped file failed at any point. The affected bytes read as zeros
+   * then, so this has to be checked after all data was accessed.
+   */
+  bool any_io_error() const;
+
  private:
   bool refill_buffer();
+  void map_file();
+  bool update_import_status(size_t file_offset);
 
  private:
   FILE *file_ = nullptr;
   Array<char> buffer_;
+  /** Offset in the file of the first byte in the buffer. */
+  size_t buffer_file_offset_ = 0;
   int pos_ = 0;
   int buf_used_ = 0;
   int last_newline_ = 0;
   size_t read_buffer_size_ = 0;
   bool at_eof_ = false;
   bool is_binary_ = false;
+  bool use_mmap_ = false;
+
+  BLI_mmap_file *mmap_file_ = nullptr;
+  const uint8_t *mmap_data_ = nullptr;
+  size_t mmap_size_ = 0;
+  size_t mmap_pos_ = 0;
+
+  FileImportTaskStatus *import_status_ = nullptr;
+  float progress_end_ = 1.0f;
+  size_t file_size_ = 0;
+  /** File offset from which the progress is reported next. */
+  size_t next_status_offset_ = 0;
 };
 
 }  // namespace blender::io::ply
@@ -10,8 +10,10 @@
 #include "ply_data.hh"
 #include "ply_import_buffer.hh"
 
+#include "BLI_array.hh"
 #include "BLI_endian_switch.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 
 #include "fast_float.h"
 
@@ -229,6 +231,99 @@ static const char *parse_row_binary(PlyReadBuffer &file,
   return nullptr;
 }
 
+/**
+ * Decode all rows of a fixed stride little endian vertex element directly from the
+ * memory-mapped file, in parallel. Component indices of absent properties are negative.
+ */
+static const char *load_vertex_rows_mapped(PlyReadBuffer &file,
+                                           const PlyElement &element,
+                                           const int3 vertex_index,
+                                           const int3 color_index,
+                                           const int3 normal_index,
+                                           const int2 uv_index,
+                                           const int alpha_index,
+                                           const float4 color_norm,
+                                           const Span<int64_t> custom_attr_indices,
+                                           PlyData *data)
+{
+  const int64_t stride = element.stride;
+  const uint8_t *rows = file.map_bytes(size_t(stride) * size_t(element.count));
+  if (rows == nullptr) {
+    return "Could not read row of binary property";
+  }
+
+  /* Byte offset of each property within a row. */
+  Array<int> prop_offsets(element.properties.size());
+  int offset = 0;
+  for (const int64_t i : element.properties.index_range()) {
+    prop_offsets[i] = offset;
+    offset += data_type_size[element.properties[i].type];
+  }
+
+  const bool has_color = color_index.x >= 0;
+  const bool has_normal = normal_index.x >= 0;
+  const bool has_uv = uv_index.x >= 0;
+  const bool has_alpha = alpha_index >= 0;
+  /* Most common layout: positions stored as three consecutive floats, copy them as a whole. */
+  auto is_float_at = [&](const int prop_index, const int offset) {
+    return element.properties[prop_index].type == FLOAT && prop_offsets[prop_index] == offset;
+  };
+  const int pos_offset = prop_offsets[vertex_index.x];
+  const bool packed_float_positions = is_float_at(vertex_index.x, pos_offset) &&
+                                      is_float_at(vertex_index.y, pos_offset + 4) &&
+                                      is_float_at(vertex_index.z, pos_offset + 8);
+
+  data->vertices.resize(element.count);
+  if (has_color) {
+    data->vertex_colors.resize(element.count);
+  }
+  if (has_normal) {
+    data->vertex_normals.resize(element.count);
+  }
+  if (has_uv) {
+    data->uv_coordinates.resize(element.count);
+  }
+
+  MutableSpan<float3> vertices = data->vertices;
+  MutableSpan<float4> colors = data->vertex_colors;
+  MutableSpan<float3> normals = data->vertex_normals;
+  MutableSpan<float2> uvs = data->uv_coordinates;
+  MutableSpan<PlyCustomAttribute> custom_attrs = data->vertex_custom_attr;
+
+  threading::parallel_for(IndexRange(element.count), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const uint8_t *row = rows + i * stride;
+      auto value = [&](const int prop_index) {
+        const uint8_t *ptr = row + prop_offsets[prop_index];
+        return get_binary_value<float>(element.properties[prop_index].type, ptr);
+      };
+
+      if (packed_float_positions) {
+        memcpy(&vertices[i], row + pos_offset, sizeof(float3));
+      }
+      else {
+        vertices[i] = float3(value(vertex_index.x), value(vertex_index.y), value(vertex_index.z));
+      }
+      if (has_color) {
+        colors[i] = float4(value(color_index.x) / color_norm.x,
+                           value(color_index.y) / color_norm.y,
+                           value(color_index.z) / color_norm.z,
+                           has_alpha ? value(alpha_index) / color_norm.w : 1.0f);
+      }
+      if (has_normal) {
+        normals[i] = float3(value(normal_index.x), value(normal_index.y), value(normal_index.z));
+      }
+      if (has_uv) {
+        uvs[i] = float2(value(uv_index.x), value(uv_index.y));
+      }
+      for (const int64_t ci : custom_attr_indices.index_range()) {
+        custom_attrs[ci].data[i] = value(int(custom_attr_indices[ci]));
+      }
+    }
+  });
+  return nullptr;
+}
+
 static const char *load_vertex_element(PlyReadBuffer &file,
                                        const PlyHeader &header,
                                        const PlyElement &element,
@@ -287,6 +382,19 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     color_norm.w = data_type_normalizer[element.properties[alpha_index].type];
   }
 
+  if (header.type == PlyFormatType::BINARY_LE && element.stride != 0 && file.is_memory_mapped()) {
+    return load_vertex_rows_mapped(file,
+                                   element,
+                                   vertex_index,
+                                   has_color ? color_index : int3(-1),
+                                   has_normal ? normal_index : int3(-1),
+                                   has_uv ? uv_index : int2(-1),
+                                   alpha_index,
+                                   color_norm,
+                                   custom_attr_indices,
+                                   data);
+  }
+
   Vector<float> value_vec(element.properties.size());
   Vector<uint8_t> scratch;
   if (header.type != PlyFormatType::ASCII) {
@@ -673,6 +781,12 @@ std::unique_ptr<PlyData> import_ply_data(PlyReadBuffer &file, PlyHeader &header)
     }
   }
 
+  /* Reading from the memory mapping does not fail, but gives zeros instead when the file could
+   * not be read, e.g. because it was truncated while importing. */
+  if (file.any_io_error()) {
+    data->error = "Error reading file";
+  }
+
   return data;
 }
 
@@ -0,0 +1,144 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#include "BKE_attribute.hh"
+#include "BKE_pointcloud.hh"
+
+#include "BLI_array.hh"
+#include "BLI_array_utils.hh"
+#include "BLI_color.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_math_color.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_vector.hh"
+#include "BLI_sort.hh"
+#include "BLI_task.hh"
+
+#include "ply_import_pointcloud.hh"
+
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace blender::io::ply {
+
+/* Radius of the imported points when there is no voxel size to derive it from. */
+static constexpr float default_point_radius = 0.01f;
+
+/* Cell used for points with non-finite coordinates, which are never merged. */
+static const int3 invalid_cell(std::numeric_limits<int>::min());
+
+static int3 voxel_grid_cell(const float3 &position, const float inv_size)
+{
+  const float3 cell = math::floor(position * inv_size);
+  if (!std::isfinite(cell.x) || !std::isfinite(cell.y) || !std::isfinite(cell.z)) {
+    return invalid_cell;
+  }
+  /* Keep very large coordinates representable, they end up in the outermost cells. */
+  const float limit = float(1 << 30);
+  return int3(math::clamp(cell, float3(-limit), float3(limit)));
+}
+
+/**
+ * Keep only the first point (in file order) of every cell of a uniform grid with the given
+ * cell size. The remaining points keep their original order. Points with non-finite coordinates
+ * are all kept.
+ */
+static IndexMask voxel_grid_decimate(const Span<float3> positions,
+                                     const float voxel_size,
+                                     IndexMaskMemory &memory)
+{
+  const float inv_size = 1.0f / voxel_size;
+  Array<int3> cells(positions.size());
+  threading::parallel_for(positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      cells[i] = voxel_grid_cell(positions[i], inv_size);
+    }
+  });
+
+  /* Sort by cell, ties broken by index so the first point of each cell comes first. */
+  Array<int> order(positions.size());
+  array_utils::fill_index_range<int>(order);
+  parallel_sort(order.begin(), order.end(), [&](const int a, const int b) {
+    const int3 &cell_a = cells[a];
+    const int3 &cell_b = cells[b];
+    if (cell_a != cell_b) {
+      return std::tie(cell_a.x, cell_a.y, cell_a.z) < std::tie(cell_b.x, cell_b.y, cell_b.z);
+    }
+    return a < b;
+  });
+
+  Array<bool> keep(positions.size());
+  threading::parallel_for(order.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const int3 &cell = cells[order[i]];
+      keep[order[i]] = i == 0 || cell == invalid_cell || cell != cells[order[i - 1]];
+    }
+  });
+  return IndexMask::from_bools(keep, memory);
+}
+
+PointCloud *convert_ply_to_point_cloud(const PlyData &data, const PLYImportParams &params)
+{
+  IndexMaskMemory memory;
+  const IndexMask selection = params.point_cloud_voxel_size > 0.0f ?
+                                  voxel_grid_decimate(
+                                      data.vertices, params.point_cloud_voxel_size, memory) :
+                                  IndexMask(data.vertices.size());
+
+  PointCloud *pointcloud = BKE_pointcloud_new_nomain(int(selection.size()));
+  bke::MutableAttributeAccessor attributes = pointcloud->attributes_for_write();
+
+  array_utils::gather(data.vertices.as_span(), selection, pointcloud->positions_for_write());
+
+  const float radius = params.point_cloud_voxel_size > 0.0f ?
+                           params.point_cloud_voxel_size * 0.5f :
+                           default_point_radius;
+  attributes.add<float>(
+      POINTCLOUD_ATTR_RADIUS,
+      bke::AttrDomain::Point,
+      bke::AttributeInitVArray(VArray<float>::ForSingle(radius, selection.size())));
+
+  /* Vertex colors */
+  if (!data.vertex_colors.is_empty() && params.vertex_colors != PLY_VERTEX_COLOR_NONE) {
+    bke::SpanAttributeWriter colors =
+        attributes.lookup_or_add_for_write_only_span<ColorGeometry4f>("Col",
+                                                                      bke::AttrDomain::Point);
+    const bool is_srgb = params.vertex_colors == PLY_VERTEX_COLOR_SRGB;
+    selection.foreach_index(GrainSize(4096), [&](const int64_t src, const int64_t dst) {
+      if (is_srgb) {
+        srgb_to_linearrgb_v4(colors.span[dst], data.vertex_colors[src]);
+      }
+      else {
+        copy_v4_v4(colors.span[dst], data.vertex_colors[src]);
+      }
+    });
+    colors.finish();
+  }
+
+  if (params.import_attributes) {
+    if (!data.vertex_normals.is_empty()) {
+      bke::SpanAttributeWriter normals = attributes.lookup_or_add_for_write_only_span<float3>(
+          "normal", bke::AttrDomain::Point);
+      array_utils::gather(data.vertex_normals.as_span(), selection, normals.span);
+      normals.finish();
+    }
+    for (const PlyCustomAttribute &attr : data.vertex_custom_attr) {
+      bke::SpanAttributeWriter values = attributes.lookup_or_add_for_write_only_span<float>(
+          attr.name, bke::AttrDomain::Point);
+      if (values) {
+        array_utils::gather(attr.data.as_span(), selection, values.span);
+        values.finish();
+      }
+    }
+  }
+
+  return pointcloud;
+}
+
+}  // namespace blender::io::ply
@@ -0,0 +1,25 @@
+/* SPDX-FileCopyrightText: 2023 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup ply
+ */
+
+#pragma once
+
+#include "IO_ply.hh"
+#include "ply_data.hh"
+
+struct PointCloud;
+
+namespace blender::io::ply {
+
+/**
+ * Converts the vertices of a #PlyData data-structure to a point cloud. Faces and edges are
+ * ignored, so this is meant for files that only contain a vertex element.
+ * \return A new point cloud that can be used inside blender.
+ */
+PointCloud *convert_ply_to_point_cloud(const PlyData &data, const PLYImportParams &params);
+
+}  // namespace blender::io::ply
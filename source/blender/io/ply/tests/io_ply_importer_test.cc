@@ -4,12 +4,33 @@
 
 #include "testing/testing.h"
 
+#include <cmath>
+#include <fcntl.h>
+#include <limits>
+
+#include "BKE_attribute.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+
+#include "BLI_color.hh"
 #include "BLI_fileops.hh"
 #include "BLI_hash_mm2a.hh"
+#include "BLI_path_util.h"
+#include "BLI_system.h"
+#include "BLI_tempfile.h"
+
+#include "DNA_pointcloud_types.h"
 
 #include "ply_import.hh"
 #include "ply_import_buffer.hh"
 #include "ply_import_data.hh"
+#include "ply_import_pointcloud.hh"
+
+#include BLI_SYSTEM_PID_H
+
+#ifndef WIN32
+#  include <unistd.h>
+#endif
 
 namespace blender::io::ply {
 
@@ -25,12 +46,18 @@ struct Expectation {
 class PLYImportTest : public testing::Test {
  public:
   void import_and_check(const char *path, const Expectation &exp)
+  {
+    import_and_check(path, exp, false);
+    import_and_check(path, exp, true);
+  }
+
+  void import_and_check(const char *path, const Expectation &exp, const bool use_mmap)
   {
     std::string ply_path = blender::tests::flags_test_asset_dir() +
                            SEP_STR "io_tests" SEP_STR "ply" SEP_STR + path;
 
     /* Use a small read buffer size for better coverage of buffer refilling behavior. */
-    PlyReadBuffer infile(ply_path.c_str(), 128);
+    PlyReadBuffer infile(ply_path.c_str(), 128, use_mmap);
     PlyHeader header;
     const char *header_err = read_header(infile, header);
     if (header_err != nullptr) {
@@ -293,6 +320,131 @@ TEST_F(PLYImportTest, PlyImportVertexCompOrder)
   import_and_check("vertex_comp_order_b.ply", expect);
 }
 
+/* Truncating a file that is still mapped is not possible on Windows. */
+#ifndef WIN32
+
+TEST(PLYImportMmapTest, FileTruncatedWhileMapped)
+{
+  char temp_dir[FILE_MAX];
+  BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+  const std::string ply_path = std::string(temp_dir) + SEP_STR + "blender_ply_mmap_test_" +
+                               std::to_string(getpid()) + ".ply";
+
+  const int verts_num = 64 * 1024;
+  const std::string header_str =
+      "ply\nformat binary_little_endian 1.0\nelement vertex " + std::to_string(verts_num) +
+      "\nproperty float x\nproperty float y\nproperty float z\nend_header\n";
+  Array<float3> positions(verts_num);
+  for (const int i : positions.index_range()) {
+    positions[i] = float3(i, 1, 2);
+  }
+  FILE *f = BLI_fopen(ply_path.c_str(), "wb");
+  ASSERT_NE(f, nullptr);
+  fwrite(header_str.data(), 1, header_str.size(), f);
+  fwrite(positions.data(), sizeof(float3), verts_num, f);
+  fclose(f);
+
+  {
+    PlyReadBuffer infile(ply_path.c_str(), 128, true);
+    PlyHeader header;
+    ASSERT_EQ(read_header(infile, header), nullptr);
+    ASSERT_TRUE(infile.is_memory_mapped());
+    std::unique_ptr<PlyData> data = import_ply_data(infile, header);
+    EXPECT_TRUE(data->error.empty());
+    ASSERT_EQ(data->vertices.size(), verts_num);
+    EXPECT_EQ(data->vertices.last(), positions.last());
+  }
+  {
+    PlyReadBuffer infile(ply_path.c_str(), 128, true);
+    PlyHeader header;
+    ASSERT_EQ(read_header(infile, header), nullptr);
+    ASSERT_TRUE(infile.is_memory_mapped());
+
+    const int file = BLI_open(ply_path.c_str(), O_BINARY | O_WRONLY | O_TRUNC, 0);
+    ASSERT_NE(file, -1);
+    close(file);
+
+    /* The mapped vertex data can't be read anymore, which must fail the import. */
+    std::unique_ptr<PlyData> data = import_ply_data(infile, header);
+    EXPECT_FALSE(data->error.empty());
+  }
+
+  BLI_delete(ply_path.c_str(), false, false);
+}
+
+#endif
+
+class PLYImportPointCloudTest : public testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+TEST_F(PLYImportPointCloudTest, AllPoints)
+{
+  PlyData data;
+  data.vertices = {float3(0, 0, 0), float3(1, 2, 3), float3(-1, -2, -3)};
+  data.vertex_normals = {float3(0, 0, 1), float3(0, 1, 0), float3(1, 0, 0)};
+  data.vertex_colors = {float4(1, 0, 0, 1), float4(0, 1, 0, 1), float4(0, 0, 1, 1)};
+  data.vertex_custom_attr.append(PlyCustomAttribute("quality", 3));
+  data.vertex_custom_attr[0].data = {0.5f, 1.5f, 2.5f};
+
+  PLYImportParams params{};
+  params.vertex_colors = PLY_VERTEX_COLOR_LINEAR;
+  params.import_attributes = true;
+  params.import_as_point_cloud = true;
+
+  PointCloud *pointcloud = convert_ply_to_point_cloud(data, params);
+  ASSERT_EQ(pointcloud->totpoint, 3);
+  const bke::AttributeAccessor attributes = pointcloud->attributes();
+  EXPECT_EQ_ARRAY(data.vertices.data(), pointcloud->positions().data(), 3);
+  const VArraySpan normals = *attributes.lookup<float3>("normal");
+  EXPECT_EQ_ARRAY(data.vertex_normals.data(), normals.data(), 3);
+  const VArraySpan quality = *attributes.lookup<float>("quality");
+  EXPECT_EQ_ARRAY(data.vertex_custom_attr[0].data.data(), quality.data(), 3);
+  const VArraySpan colors = *attributes.lookup<ColorGeometry4f>("Col");
+  EXPECT_V4_NEAR(float4(colors[1]), data.vertex_colors[1], 1e-6f);
+  const VArraySpan radii = *attributes.lookup<float>("radius");
+  EXPECT_FLOAT_EQ(radii[0], 0.01f);
+  BKE_id_free(nullptr, pointcloud);
+}
+
+TEST_F(PLYImportPointCloudTest, VoxelDecimate)
+{
+  const float inf = std::numeric_limits<float>::infinity();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  PlyData data;
+  data.vertices = {float3(0.1f, 0.1f, 0.1f),
+                   float3(1.5f, 0.5f, 0.5f),
+                   float3(0.9f, 0.9f, 0.9f),
+                   float3(nan, 0, 0),
+                   float3(0, inf, 0),
+                   float3(nan, 0, 0),
+                   float3(1e30f, -1e30f, 0),
+                   float3(1.2f, 0.2f, 0.2f),
+                   float3(1e30f, -1e30f, 0)};
+
+  PLYImportParams params{};
+  params.import_as_point_cloud = true;
+  params.point_cloud_voxel_size = 1.0f;
+
+  PointCloud *pointcloud = convert_ply_to_point_cloud(data, params);
+  /* The first point of every cell is kept in file order, non-finite points are never merged. */
+  const Span<float3> positions = pointcloud->positions();
+  ASSERT_EQ(positions.size(), 6);
+  EXPECT_EQ(positions[0], data.vertices[0]);
+  EXPECT_EQ(positions[1], data.vertices[1]);
+  EXPECT_TRUE(std::isnan(positions[2].x));
+  EXPECT_TRUE(std::isinf(positions[3].y));
+  EXPECT_TRUE(std::isnan(positions[4].x));
+  EXPECT_EQ(positions[5], data.vertices[6]);
+  const VArraySpan radii = *pointcloud->attributes().lookup<float>("radius");
+  EXPECT_FLOAT_EQ(radii[0], 0.5f);
+  BKE_id_free(nullptr, pointcloud);
+}
+
 //@TODO: test with vertex element having list properties
 //@TODO: test with edges starting with non-vertex index properties
 //@TODO: test various malformed headers
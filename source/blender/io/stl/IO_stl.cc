@@ -18,6 +18,11 @@ void STL_import(bContext *C, const STLImportParams *import_params)
   blender::io::stl::importer_main(C, *import_params);
 }
 
+std::unique_ptr<blender::io::FileImportTask> STL_import_task(const STLImportParams *import_params)
+{
+  return blender::io::stl::create_import_task(*import_params);
+}
+
 void STL_export(bContext *C, const STLExportParams *export_params)
 {
   SCOPED_TIMER("STL Export");
@@ -8,10 +8,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "BLI_path_util.h"
 
 #include "DNA_ID.h"
 
+#include "IO_file_import_task.hh"
 #include "IO_orientation.hh"
 
 struct bContext;
@@ -47,4 +50,6 @@ struct STLExportParams {
 };
 
 void STL_import(bContext *C, const STLImportParams *import_params);
+/** Import that can run as a background job, see #blender::io::FileImportTask. */
+std::unique_ptr<blender::io::FileImportTask> STL_import_task(const STLImportParams *import_params);
 void STL_export(bContext *C, const STLExportParams *export_params);
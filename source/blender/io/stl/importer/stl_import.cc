@@ -10,6 +10,7 @@
 
 #include "BKE_context.hh"
 #include "BKE_layer.hh"
+#include "BKE_lib_id.hh"
 #include "BKE_mesh.hh"
 #include "BKE_object.hh"
 #include "BKE_report.hh"
@@ -55,97 +56,139 @@ void importer_main(const bContext *C, const STLImportParams &import_params)
   importer_main(bmain, scene, view_layer, import_params);
 }
 
-void importer_main(Main *bmain,
-                   Scene *scene,
-                   ViewLayer *view_layer,
-                   const STLImportParams &import_params)
-{
-  FILE *file = BLI_fopen(import_params.filepath, "rb");
-  if (!file) {
-    fprintf(stderr, "Failed to open STL file:'%s'.\n", import_params.filepath);
-    BKE_reportf(import_params.reports,
-                RPT_ERROR,
-                "STL Import: Cannot open file '%s'",
-                import_params.filepath);
-    return;
-  }
-  BLI_SCOPED_DEFER([&]() { fclose(file); });
-
-  /* Detect STL file type by comparing file size with expected file size,
-   * could check if file starts with "solid", but some files do not adhere,
-   * this is the same as the old Python importer.
-   */
-  uint32_t num_tri = 0;
-  size_t file_size = BLI_file_size(import_params.filepath);
-  fseek(file, BINARY_HEADER_SIZE, SEEK_SET);
-  if (fread(&num_tri, sizeof(uint32_t), 1, file) != 1) {
-    stl_import_report_error(file);
-    BKE_reportf(import_params.reports,
-                RPT_ERROR,
-                "STL Import: Failed to read file '%s'",
-                import_params.filepath);
-    return;
+/**
+ * Reads the file and builds the mesh outside of Main on a worker thread, then adds it to the
+ * scene on the main thread.
+ */
+class STLImportTask : public FileImportTask {
+  STLImportParams params_;
+  /** Name used for both mesh and object. */
+  char ob_name_[FILE_MAX];
+  Mesh *mesh_ = nullptr;
+
+ public:
+  STLImportTask(const STLImportParams &params) : params_(params)
+  {
+    STRNCPY(ob_name_, BLI_path_basename(params_.filepath));
+    BLI_path_extension_strip(ob_name_);
   }
-  bool is_ascii_stl = (file_size != (BINARY_HEADER_SIZE + 4 + BINARY_STRIDE * num_tri));
-
-  /* Name used for both mesh and object. */
-  char ob_name[FILE_MAX];
-  STRNCPY(ob_name, BLI_path_basename(import_params.filepath));
-  BLI_path_extension_strip(ob_name);
-
-  Mesh *mesh = is_ascii_stl ?
-                   read_stl_ascii(import_params.filepath, import_params.use_facet_normal) :
-                   read_stl_binary(file, import_params.use_facet_normal);
-
-  if (mesh == nullptr) {
-    fprintf(stderr, "STL Importer: Failed to import mesh '%s'\n", import_params.filepath);
-    BKE_reportf(import_params.reports,
-                RPT_ERROR,
-                "STL Import: Failed to import mesh from file '%s'",
-                import_params.filepath);
-    return;
+
+  ~STLImportTask() override
+  {
+    if (mesh_ != nullptr) {
+      BKE_id_free(nullptr, mesh_);
+    }
   }
 
-  if (import_params.use_mesh_validate) {
-    bool verbose_validate = false;
+  bool read(FileImportTaskStatus &status) override
+  {
+    FILE *file = BLI_fopen(params_.filepath, "rb");
+    if (!file) {
+      fprintf(stderr, "Failed to open STL file:'%s'.\n", params_.filepath);
+      BKE_reportf(
+          status.reports, RPT_ERROR, "STL Import: Cannot open file '%s'", params_.filepath);
+      return false;
+    }
+    BLI_SCOPED_DEFER([&]() { fclose(file); });
+
+    /* Detect STL file type by comparing file size with expected file size,
+     * could check if file starts with "solid", but some files do not adhere,
+     * this is the same as the old Python importer.
+     */
+    uint32_t num_tri = 0;
+    size_t file_size = BLI_file_size(params_.filepath);
+    fseek(file, BINARY_HEADER_SIZE, SEEK_SET);
+    if (fread(&num_tri, sizeof(uint32_t), 1, file) != 1) {
+      stl_import_report_error(file);
+      BKE_reportf(
+          status.reports, RPT_ERROR, "STL Import: Failed to read file '%s'", params_.filepath);
+      return false;
+    }
+    bool is_ascii_stl = (file_size != (BINARY_HEADER_SIZE + 4 + BINARY_STRIDE * num_tri));
+
+    mesh_ = is_ascii_stl ?
+                read_stl_ascii(params_.filepath, params_.use_facet_normal, &status, 0.9f) :
+                read_stl_binary(file, params_.use_facet_normal, &status, 0.9f);
+
+    if (status.stop_requested()) {
+      return false;
+    }
+    if (mesh_ == nullptr) {
+      fprintf(stderr, "STL Importer: Failed to import mesh '%s'\n", params_.filepath);
+      BKE_reportf(status.reports,
+                  RPT_ERROR,
+                  "STL Import: Failed to import mesh from file '%s'",
+                  params_.filepath);
+      return false;
+    }
+
+    if (params_.use_mesh_validate) {
+      bool verbose_validate = false;
 #ifndef NDEBUG
-    verbose_validate = true;
+      verbose_validate = true;
 #endif
-    BKE_mesh_validate(mesh, verbose_validate, false);
+      BKE_mesh_validate(mesh_, verbose_validate, false);
+    }
+    return true;
+  }
+
+  void add_to_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   ReportList * /*reports*/) override
+  {
+    Mesh *mesh_in_main = BKE_mesh_add(bmain, ob_name_);
+    BKE_mesh_nomain_to_mesh(mesh_, mesh_in_main, nullptr);
+    mesh_ = nullptr;
+    BKE_view_layer_base_deselect_all(scene, view_layer);
+    LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+    Object *obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name_);
+    obj->data = mesh_in_main;
+    BKE_collection_object_add(bmain, lc->collection, obj);
+    BKE_view_layer_synced_ensure(scene, view_layer);
+    Base *base = BKE_view_layer_base_find(view_layer, obj);
+    BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+    float global_scale = params_.global_scale;
+    if ((scene->unit.system != USER_UNIT_NONE) && params_.use_scene_unit) {
+      global_scale /= scene->unit.scale_length;
+    }
+    float scale_vec[3] = {global_scale, global_scale, global_scale};
+    float obmat3x3[3][3];
+    unit_m3(obmat3x3);
+    float obmat4x4[4][4];
+    unit_m4(obmat4x4);
+    /* +Y-forward and +Z-up are the Blender's default axis settings. */
+    mat3_from_axis_conversion(
+        IO_AXIS_Y, IO_AXIS_Z, params_.forward_axis, params_.up_axis, obmat3x3);
+    copy_m4_m3(obmat4x4, obmat3x3);
+    rescale_m4(obmat4x4, scale_vec);
+    BKE_object_apply_mat4(obj, obmat4x4, true, false);
+
+    DEG_id_tag_update(&lc->collection->id, ID_RECALC_SYNC_TO_EVAL);
+    int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+                ID_RECALC_BASE_FLAGS;
+    DEG_id_tag_update_ex(bmain, &obj->id, flags);
+    DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+    DEG_relations_tag_update(bmain);
   }
+};
+
+std::unique_ptr<FileImportTask> create_import_task(const STLImportParams &import_params)
+{
+  return std::make_unique<STLImportTask>(import_params);
+}
 
-  Mesh *mesh_in_main = BKE_mesh_add(bmain, ob_name);
-  BKE_mesh_nomain_to_mesh(mesh, mesh_in_main, nullptr);
-  BKE_view_layer_base_deselect_all(scene, view_layer);
-  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
-  Object *obj = BKE_object_add_only_object(bmain, OB_MESH, ob_name);
-  obj->data = mesh_in_main;
-  BKE_collection_object_add(bmain, lc->collection, obj);
-  BKE_view_layer_synced_ensure(scene, view_layer);
-  Base *base = BKE_view_layer_base_find(view_layer, obj);
-  BKE_view_layer_base_select_and_set_active(view_layer, base);
-
-  float global_scale = import_params.global_scale;
-  if ((scene->unit.system != USER_UNIT_NONE) && import_params.use_scene_unit) {
-    global_scale /= scene->unit.scale_length;
+void importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const STLImportParams &import_params)
+{
+  STLImportTask task(import_params);
+  FileImportTaskStatus status;
+  status.reports = import_params.reports;
+  if (task.read(status)) {
+    task.add_to_main(bmain, scene, view_layer, import_params.reports);
   }
-  float scale_vec[3] = {global_scale, global_scale, global_scale};
-  float obmat3x3[3][3];
-  unit_m3(obmat3x3);
-  float obmat4x4[4][4];
-  unit_m4(obmat4x4);
-  /* +Y-forward and +Z-up are the Blender's default axis settings. */
-  mat3_from_axis_conversion(
-      IO_AXIS_Y, IO_AXIS_Z, import_params.forward_axis, import_params.up_axis, obmat3x3);
-  copy_m4_m3(obmat4x4, obmat3x3);
-  rescale_m4(obmat4x4, scale_vec);
-  BKE_object_apply_mat4(obj, obmat4x4, true, false);
-
-  DEG_id_tag_update(&lc->collection->id, ID_RECALC_SYNC_TO_EVAL);
-  int flags = ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
-              ID_RECALC_BASE_FLAGS;
-  DEG_id_tag_update_ex(bmain, &obj->id, flags);
-  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
-  DEG_relations_tag_update(bmain);
 }
 }  // namespace blender::io::stl
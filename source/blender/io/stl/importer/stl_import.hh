@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "IO_file_import_task.hh"
 #include "IO_stl.hh"
 
 struct bContext;
@@ -22,6 +25,9 @@ void stl_import_report_error(FILE *file);
 /* Main import function used from within Blender. */
 void importer_main(const bContext *C, const STLImportParams &import_params);
 
+/** Import split into reading on a worker thread and adding to Main, see #FileImportTask. */
+std::unique_ptr<FileImportTask> create_import_task(const STLImportParams &import_params);
+
 /* Used from tests, where full bContext does not exist. */
 void importer_main(Main *bmain,
                    Scene *scene,
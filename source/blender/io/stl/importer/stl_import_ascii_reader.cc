@@ -46,6 +46,11 @@ class StringBuffer {
     return start == end;
   }
 
+  const char *position() const
+  {
+    return start;
+  }
+
   void drop_leading_control_chars()
   {
     while ((start < end) && (*start) <= ' ') {
@@ -111,7 +116,10 @@ static inline void parse_float3(StringBuffer &buf, float3 &out)
   }
 }
 
-Mesh *read_stl_ascii(const char *filepath, const bool use_custom_normals)
+Mesh *read_stl_ascii(const char *filepath,
+                     const bool use_custom_normals,
+                     FileImportTaskStatus *status,
+                     const float progress_end)
 {
   size_t buffer_len;
   void *buffer = BLI_file_read_text_as_mem(filepath, 0, &buffer_len);
@@ -126,6 +134,10 @@ Mesh *read_stl_ascii(const char *filepath, const bool use_custom_normals)
   StringBuffer str_buf(static_cast<char *>(buffer), buffer_len);
   STLMeshHelper stl_mesh(num_reserved_tris, use_custom_normals);
 
+  /* Number of triangles between progress updates. */
+  constexpr int status_interval = 16 * 1024;
+  int64_t num_tris = 0;
+
   PackedTriangle data{};
   str_buf.drop_line(); /* Skip header line */
   while (!str_buf.is_empty()) {
@@ -139,6 +151,15 @@ Mesh *read_stl_ascii(const char *filepath, const bool use_custom_normals)
       }
 
       stl_mesh.add_triangle(data);
+      num_tris++;
+      if (status && num_tris % status_interval == 0) {
+        if (status->stop_requested()) {
+          return nullptr;
+        }
+        const char *begin = static_cast<const char *>(buffer);
+        status->set_progress(progress_end * float(str_buf.position() - begin) /
+                             float(buffer_len));
+      }
     }
     else if (str_buf.parse_token("facet", 5)) {
       str_buf.drop_token(); /* Expecting "normal" */
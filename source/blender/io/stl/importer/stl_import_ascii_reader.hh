@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "IO_file_import_task.hh"
+
 struct Mesh;
 
 /**
@@ -28,6 +30,13 @@ struct Mesh;
 
 namespace blender::io::stl {
 
-Mesh *read_stl_ascii(const char *filepath, bool use_custom_normals);
+/**
+ * \param status: Optional, used to report progress and to stop when the import is canceled.
+ * The progress goes from zero to \a progress_end. Returns null when canceled.
+ */
+Mesh *read_stl_ascii(const char *filepath,
+                     bool use_custom_normals,
+                     FileImportTaskStatus *status = nullptr,
+                     float progress_end = 1.0f);
 
 }  // namespace blender::io::stl
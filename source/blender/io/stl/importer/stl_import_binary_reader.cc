@@ -22,7 +22,10 @@
 
 namespace blender::io::stl {
 
-Mesh *read_stl_binary(FILE *file, const bool use_custom_normals)
+Mesh *read_stl_binary(FILE *file,
+                      const bool use_custom_normals,
+                      FileImportTaskStatus *status,
+                      const float progress_end)
 {
   const int chunk_size = 1024;
   uint32_t num_tris = 0;
@@ -39,10 +42,18 @@ Mesh *read_stl_binary(FILE *file, const bool use_custom_normals)
   Array<PackedTriangle> tris_buf(chunk_size);
   STLMeshHelper stl_mesh(num_tris, use_custom_normals);
   size_t num_read_tris;
+  size_t total_read_tris = 0;
   while ((num_read_tris = fread(tris_buf.data(), sizeof(PackedTriangle), chunk_size, file))) {
     for (size_t i = 0; i < num_read_tris; i++) {
       stl_mesh.add_triangle(tris_buf[i]);
     }
+    if (status) {
+      if (status->stop_requested()) {
+        return nullptr;
+      }
+      total_read_tris += num_read_tris;
+      status->set_progress(progress_end * float(total_read_tris) / float(num_tris));
+    }
   }
 
   return stl_mesh.to_mesh();
@@ -10,6 +10,8 @@
 
 #include <cstdio>
 
+#include "IO_file_import_task.hh"
+
 struct Mesh;
 
 /*  Binary STL spec.:
@@ -25,6 +27,13 @@ struct Mesh;
 
 namespace blender::io::stl {
 
-Mesh *read_stl_binary(FILE *file, bool use_custom_normals);
+/**
+ * \param status: Optional, used to report progress and to stop when the import is canceled.
+ * The progress goes from zero to \a progress_end. Returns null when canceled.
+ */
+Mesh *read_stl_binary(FILE *file,
+                      bool use_custom_normals,
+                      FileImportTaskStatus *status = nullptr,
+                      float progress_end = 1.0f);
 
 }  // namespace blender::io::stl
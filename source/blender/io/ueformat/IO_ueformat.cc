@@ -23,3 +23,9 @@ void UEFORMAT_import(bContext *C, const UEFORMATImportParams *import_params)
     blender::io::ueformat::importer_main(C, *import_params);
     //report_duration("import", start_time, import_params->filepath);
 }
+
+std::unique_ptr<blender::io::FileImportTask> UEFORMAT_import_task(
+    const UEFORMATImportParams *import_params)
+{
+  return blender::io::ueformat::create_import_task(*import_params);
+}
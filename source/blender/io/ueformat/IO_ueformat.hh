@@ -8,10 +8,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "BLI_path_util.h"
 
 #include "DEG_depsgraph.hh"
 
+#include "IO_file_import_task.hh"
 #include "IO_orientation.hh"
 #include "IO_path_util_types.hh"
 
@@ -29,3 +32,7 @@ struct UEFORMATImportParams {
 };
 
 void UEFORMAT_import(bContext *C, const UEFORMATImportParams *import_params);
+
+/** Import that can run as a background job, see #blender::io::FileImportTask. */
+std::unique_ptr<blender::io::FileImportTask> UEFORMAT_import_task(
+    const UEFORMATImportParams *import_params);
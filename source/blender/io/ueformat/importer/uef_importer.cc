@@ -11,8 +11,10 @@
 #include "DNA_object_types.h"
 
 #include "BKE_context.hh"
+#include "BKE_lib_id.hh"
 #include "BKE_mesh.hh"
 #include "BKE_object.hh"
+#include "BKE_report.hh"
 
 #include "IO_ueformat.hh"
 #include "uef_importer.hh"
@@ -24,92 +26,139 @@
 namespace blender::io::ueformat {
 
 
-Object* BuildUEModel(bContext *C, const FUEModelData model, const UEFORMATImportParams &import_params) {
-  Main *bmain = CTX_data_main(C);
-  Scene *scene = CTX_data_scene(C);
-  ViewLayer *view_layer = CTX_data_view_layer(C);
-
-  if (model.LODs.empty()) {
+/** Build a mesh outside of Main for a single LOD. */
+static Mesh *build_lod_mesh(const FLODData &lod)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(lod.Vertices.size(), 0, lod.Indices.size() / 3, lod.Indices.size());
+  if (mesh == nullptr) {
     return nullptr;
   }
 
-  // if more than one lod parent lods to the first one
-  Object *parent = nullptr;
-  for (const auto &lod : model.LODs) {
-    Mesh* mesh = BKE_mesh_new_nomain(lod.Vertices.size(), 0, lod.Indices.size()/3, lod.Indices.size());
-    if (mesh == nullptr) {
-      return nullptr;
+  // vertices
+  mesh->vert_positions_for_write().copy_from(lod.Vertices);
+
+  // faces
+  MutableSpan<int> face_offsets = mesh->face_offsets_for_write(); // basically index where a face starts and goes till next entry(index)?
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
+  bke::SpanAttributeWriter<int> material_indices =
+      attributes.lookup_or_add_for_write_only_span<int>("material_index", bke::AttrDomain::Face);
+
+  corner_verts.copy_from(lod.Indices);
+  // TODO optimize this
+  int corner_index = 0;
+  for (int face_idx = 0; face_idx < mesh->faces_num; ++face_idx) {
+    face_offsets[face_idx] = corner_index;
+    int mat_index = 0;
+    for (int i = 0; i < lod.Materials.size(); i++) {
+      if (lod.Materials[i].FirstIndex > face_idx) {
+        mat_index = i - 1;
+        break;
+      }
     }
 
-    Object* ob;
-    if (parent == nullptr) {
-      ob = BKE_object_add(bmain, scene, view_layer, OB_MESH, (model.Header.ObjectName + lod.LODName).c_str());
-      ob->data = mesh;
-      parent = ob;
-    } else {
-      Object *ob = BKE_object_add_from(bmain, scene, view_layer, OB_MESH, (model.Header.ObjectName + lod.LODName).c_str(), parent);
-      ob->data = mesh;
+    material_indices.span[face_idx] = mat_index;
+    corner_index += 3;
+  }
+  material_indices.finish();
+  bke::mesh_calc_edges(*mesh, true, false);
+
+  // normals
+  if (!lod.Normals.empty()) {
+    Array<float3> normals = Array<float3>(lod.Normals.size());
+    for (int i = 0; i < lod.Normals.size(); i += 1) {
+      normals[i] = lod.Normals[i].yzw(); // serialized as float4(blender: XYZW) WXYZ and we need only XYZ
     }
 
-    // vertices
-    mesh->vert_positions_for_write().copy_from(lod.Vertices);
-
-    // faces
-    MutableSpan<int> face_offsets = mesh->face_offsets_for_write(); // basically index where a face starts and goes till next entry(index)?
-    MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
-    bke::MutableAttributeAccessor attributes = mesh->attributes_for_write();
-    bke::SpanAttributeWriter<int> material_indices =
-        attributes.lookup_or_add_for_write_only_span<int>("material_index", bke::AttrDomain::Face);
-
-    corner_verts.copy_from(lod.Indices);
-    // TODO optimize this
-    int corner_index = 0;
-    for (int face_idx = 0; face_idx < mesh->faces_num; ++face_idx) {
-      face_offsets[face_idx] = corner_index;
-      int mat_index = 0;
-      for (int i = 0; i < lod.Materials.size(); i++) {
-        if (lod.Materials[i].FirstIndex > face_idx) {
-          mat_index = i - 1;
-          break;
-        }
-      }
+    BKE_mesh_set_custom_normals_from_verts(mesh, reinterpret_cast<float(*)[3]>(normals.data()));
+  }
+  return mesh;
+}
 
-      material_indices.span[face_idx] = mat_index;
-      corner_index += 3;
-    }
-    material_indices.finish();
-    bke::mesh_calc_edges(*mesh, true, false);
-
-    // normals
-    if (!lod.Normals.empty()) {
-      Array<float3> normals = Array<float3>(lod.Normals.size());
-      for (int i = 0; i < lod.Normals.size(); i += 1) {
-        normals[i] = lod.Normals[i].yzw(); // serialized as float4(blender: XYZW) WXYZ and we need only XYZ
+/**
+ * Reads the file and builds the LOD meshes outside of Main on a worker thread, then creates the
+ * objects on the main thread.
+ */
+class UEFormatImportTask : public FileImportTask {
+  UEFORMATImportParams params_;
+  std::unique_ptr<FUEModelData> model_;
+  /** One mesh per LOD, moved into Main by #add_to_main. */
+  Vector<Mesh *> lod_meshes_;
+
+ public:
+  UEFormatImportTask(const UEFORMATImportParams &params) : params_(params) {}
+
+  ~UEFormatImportTask() override
+  {
+    for (Mesh *mesh : lod_meshes_) {
+      if (mesh != nullptr) {
+        BKE_id_free(nullptr, mesh);
       }
+    }
+  }
 
-      BKE_mesh_set_custom_normals_from_verts(mesh, reinterpret_cast<float(*)[3]>(normals.data()));
+  bool read(FileImportTaskStatus &status) override
+  {
+    model_.reset(ReadUEFModelData(params_.filepath));
+    if (model_ == nullptr || model_->LODs.empty()) {
+      BKE_reportf(status.reports, RPT_ERROR, "UEFormat: Failed to read '%s'", params_.filepath);
+      return false;
     }
 
+    for (const int i : IndexRange(model_->LODs.size())) {
+      if (status.stop_requested()) {
+        return false;
+      }
+      Mesh *mesh = build_lod_mesh(model_->LODs[i]);
+      if (mesh == nullptr) {
+        return false;
+      }
+      lod_meshes_.append(mesh);
+      status.set_progress(float(i + 1) / float(model_->LODs.size()));
+    }
+    return true;
+  }
 
-    float scale_vec[3] = {import_params.scale, import_params.scale, import_params.scale};
-    float obmat4x4[4][4];
-    unit_m4(obmat4x4);
-    rescale_m4(obmat4x4, scale_vec);
-    BKE_object_apply_mat4(ob, obmat4x4, true, false);
+  void add_to_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   ReportList * /*reports*/) override
+  {
+    // if more than one lod parent lods to the first one
+    Object *parent = nullptr;
+    for (const int i : lod_meshes_.index_range()) {
+      const std::string name = model_->Header.ObjectName + model_->LODs[i].LODName;
+      Object *ob;
+      if (parent == nullptr) {
+        ob = BKE_object_add(bmain, scene, view_layer, OB_MESH, name.c_str());
+        parent = ob;
+      } else {
+        ob = BKE_object_add_from(bmain, scene, view_layer, OB_MESH, name.c_str(), parent);
+      }
+      BKE_mesh_nomain_to_mesh(lod_meshes_[i], static_cast<Mesh *>(ob->data), ob);
+      lod_meshes_[i] = nullptr;
+
+      float scale_vec[3] = {params_.scale, params_.scale, params_.scale};
+      float obmat4x4[4][4];
+      unit_m4(obmat4x4);
+      rescale_m4(obmat4x4, scale_vec);
+      BKE_object_apply_mat4(ob, obmat4x4, true, false);
+    }
   }
+};
 
-  return parent;
+std::unique_ptr<FileImportTask> create_import_task(const UEFORMATImportParams &import_params)
+{
+  return std::make_unique<UEFormatImportTask>(import_params);
 }
 
 void importer_main(bContext *C, const UEFORMATImportParams &import_params) {
-  auto &filepath = import_params.filepath;
-  auto model = ReadUEFModelData(filepath);
-  if (model == nullptr) {
-      return;
-  }
-  Object* obj = BuildUEModel(C, *model, import_params);
-  if (obj == nullptr) {
-      return;
+  UEFormatImportTask task(import_params);
+  FileImportTaskStatus status;
+  status.reports = import_params.reports;
+  if (task.read(status)) {
+    task.add_to_main(
+        CTX_data_main(C), CTX_data_scene(C), CTX_data_view_layer(C), import_params.reports);
   }
 }
 }  // namespace blender::io::ueformat
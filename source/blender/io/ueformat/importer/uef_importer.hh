@@ -6,9 +6,15 @@
  * \ingroup ueformat
  */
 
+#include <memory>
+
+#include "IO_file_import_task.hh"
 #include "IO_ueformat.hh"
 
 namespace blender::io::ueformat {
 
 void importer_main(bContext *C, const UEFORMATImportParams &import_params);
+
+/** Import split into reading on a worker thread and adding to Main, see #FileImportTask. */
+std::unique_ptr<FileImportTask> create_import_task(const UEFORMATImportParams &import_params);
 }
@@ -39,3 +39,8 @@ void OBJ_import(bContext *C, const OBJImportParams *import_params)
   blender::io::obj::importer_main(C, *import_params);
   report_duration("import", start_time, import_params->filepath);
 }
+
+std::unique_ptr<blender::io::FileImportTask> OBJ_import_task(const OBJImportParams *import_params)
+{
+  return blender::io::obj::create_import_task(*import_params);
+}
@@ -8,10 +8,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "BLI_path_util.h"
 
 #include "DEG_depsgraph.hh"
 
+#include "IO_file_import_task.hh"
 #include "IO_orientation.hh"
 #include "IO_path_util_types.hh"
 
@@ -91,6 +94,9 @@ struct OBJImportParams {
  */
 void OBJ_import(bContext *C, const OBJImportParams *import_params);
 
+/** Import that can run as a background job, see #blender::io::FileImportTask. */
+std::unique_ptr<blender::io::FileImportTask> OBJ_import_task(const OBJImportParams *import_params);
+
 /**
  * Perform the full export process.
  */
@@ -501,11 +501,15 @@ static void use_all_vertices_if_no_faces(Geometry *geom,
 }
 
 void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
-                      GlobalVertices &r_global_vertices)
+                      GlobalVertices &r_global_vertices,
+                      FileImportTaskStatus *status,
+                      const float progress_end)
 {
   if (!obj_file_) {
     return;
   }
+  const size_t file_size = status ? BLI_file_size(import_params_.filepath) : 0;
+  size_t file_offset = 0;
 
   /* Use the filename as the default name given to the initial object. */
   char ob_name[FILE_MAXFILE];
@@ -534,6 +538,15 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     if (bytes_read == 0 && buffer_offset == 0) {
       break; /* No more data to read. */
     }
+    if (status) {
+      if (status->stop_requested()) {
+        break;
+      }
+      file_offset += bytes_read;
+      if (file_size > 0) {
+        status->set_progress(progress_end * float(file_offset) / float(file_size));
+      }
+    }
 
     /* Take care of line continuations now (turn them into spaces);
      * the rest of the parsing code does not need to worry about them anymore. */
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include "IO_file_import_task.hh"
 #include "IO_wavefront_obj.hh"
 
 #include "BLI_map.hh"
@@ -38,9 +39,14 @@ class OBJParser {
   /**
    * Read the OBJ file line by line and create OBJ Geometry instances. Also store all the vertex
    * and UV vertex coordinates in a struct accessible by all objects.
+   *
+   * \param status: Optional, used to report progress and to stop when the import is canceled.
+   * The progress goes from zero to \a progress_end.
    */
   void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
-             GlobalVertices &r_global_vertices);
+             GlobalVertices &r_global_vertices,
+             FileImportTaskStatus *status = nullptr,
+             float progress_end = 1.0f);
   /**
    * Return a list of all material library filepaths referenced by the OBJ file.
    */
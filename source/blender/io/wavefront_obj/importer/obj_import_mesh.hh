@@ -33,10 +33,20 @@ class MeshFromGeometry : NonMovable, NonCopyable {
   {
   }
 
-  Object *create_mesh(Main *bmain,
-                      Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
-                      Map<std::string, Material *> &created_materials,
-                      const OBJImportParams &import_params);
+  /**
+   * Build the mesh outside of Main. This does not access any global data, so it can run on a
+   * worker thread.
+   * \return Null for an empty mesh.
+   */
+  Mesh *create_mesh_nomain(const OBJImportParams &import_params);
+  /**
+   * Create the object for a mesh from #create_mesh_nomain, which is moved into Main.
+   */
+  Object *create_mesh_object(Main *bmain,
+                             Mesh *mesh,
+                             Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
+                             Map<std::string, Material *> &created_materials,
+                             const OBJImportParams &import_params);
 
  private:
   /**
@@ -16,6 +16,7 @@
 
 #include "BKE_context.hh"
 #include "BKE_layer.hh"
+#include "BKE_lib_id.hh"
 
 #include "DEG_depsgraph_build.hh"
 
@@ -72,38 +73,50 @@ static Collection *find_or_create_collection(Main *bmain,
   return target;
 }
 
+/**
+ * Sort objects by name: creating many objects is much faster if the creation order is sorted by
+ * name.
+ */
+static void sort_geometries_by_name(Vector<std::unique_ptr<Geometry>> &all_geometries)
+{
+  blender::parallel_sort(
+      all_geometries.begin(), all_geometries.end(), [](const auto &a, const auto &b) {
+        const char *na = a ? a->geometry_name_.c_str() : "";
+        const char *nb = b ? b->geometry_name_.c_str() : "";
+        return BLI_strcasecmp(na, nb) < 0;
+      });
+}
+
 /**
  * Make Blender Mesh, Curve etc from Geometry and add them to the import collection.
+ *
+ * \param meshes: The meshes built outside of Main for every geometry of #GEOM_MESH type, they
+ * are moved into Main and set to null.
  */
 static void geometry_to_blender_objects(Main *bmain,
                                         Scene *scene,
                                         ViewLayer *view_layer,
                                         const OBJImportParams &import_params,
                                         Vector<std::unique_ptr<Geometry>> &all_geometries,
+                                        MutableSpan<Mesh *> meshes,
                                         const GlobalVertices &global_vertices,
                                         Map<std::string, std::unique_ptr<MTLMaterial>> &materials,
                                         Map<std::string, Material *> &created_materials)
 {
   LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
 
-  /* Sort objects by name: creating many objects is much faster if the creation
-   * order is sorted by name. */
-  blender::parallel_sort(
-      all_geometries.begin(), all_geometries.end(), [](const auto &a, const auto &b) {
-        const char *na = a ? a->geometry_name_.c_str() : "";
-        const char *nb = b ? b->geometry_name_.c_str() : "";
-        return BLI_strcasecmp(na, nb) < 0;
-      });
-
   /* Create all the objects. */
   Vector<Object *> objects;
   objects.reserve(all_geometries.size());
   Set<Collection *> collections;
-  for (const std::unique_ptr<Geometry> &geometry : all_geometries) {
+  for (const int i : all_geometries.index_range()) {
+    const std::unique_ptr<Geometry> &geometry = all_geometries[i];
     Object *obj = nullptr;
-    if (geometry->geom_type_ == GEOM_MESH) {
+    if (geometry->geom_type_ == GEOM_MESH && meshes[i] != nullptr) {
       MeshFromGeometry mesh_ob_from_geometry{*geometry, global_vertices};
-      obj = mesh_ob_from_geometry.create_mesh(bmain, materials, created_materials, import_params);
+      obj = mesh_ob_from_geometry.create_mesh_object(
+          bmain, meshes[i], materials, created_materials, import_params);
+      meshes[i] = nullptr;
     }
     else if (geometry->geom_type_ == GEOM_CURVE) {
       CurveFromGeometry curve_ob_from_geometry(*geometry, global_vertices);
@@ -145,38 +158,106 @@ void importer_main(bContext *C, const OBJImportParams &import_params)
   importer_main(bmain, scene, view_layer, import_params);
 }
 
+/**
+ * Parses the OBJ and MTL files and builds the meshes on a worker thread, then creates the
+ * objects and materials on the main thread. Curves are created on the main thread, because
+ * legacy curves can't be built outside of Main.
+ */
+class OBJImportTask : public FileImportTask {
+  OBJImportParams params_;
+  size_t read_buffer_size_;
+  /** List of Geometry instances to be parsed from OBJ file. */
+  Vector<std::unique_ptr<Geometry>> all_geometries_;
+  /** Container for vertex and UV vertex coordinates. */
+  GlobalVertices global_vertices_;
+  /** List of MTLMaterial instances to be parsed from MTL file. */
+  Map<std::string, std::unique_ptr<MTLMaterial>> materials_;
+  /** Mesh of every geometry, built outside of Main. Null for other types and empty meshes. */
+  Array<Mesh *> meshes_;
+
+ public:
+  OBJImportTask(const OBJImportParams &params, const size_t read_buffer_size)
+      : params_(params), read_buffer_size_(read_buffer_size)
+  {
+  }
+
+  ~OBJImportTask() override
+  {
+    for (Mesh *mesh : meshes_) {
+      if (mesh != nullptr) {
+        BKE_id_free(nullptr, mesh);
+      }
+    }
+  }
+
+  bool read(FileImportTaskStatus &status) override
+  {
+    params_.reports = status.reports;
+
+    OBJParser obj_parser{params_, read_buffer_size_};
+    obj_parser.parse(all_geometries_, global_vertices_, &status, 0.3f);
+    if (status.stop_requested()) {
+      return false;
+    }
+
+    for (StringRefNull mtl_library : obj_parser.mtl_libraries()) {
+      MTLParser mtl_parser{mtl_library, params_.filepath};
+      mtl_parser.parse_and_store(materials_);
+    }
+    status.set_progress(0.3f);
+
+    sort_geometries_by_name(all_geometries_);
+    meshes_ = Array<Mesh *>(all_geometries_.size(), nullptr);
+    for (const int i : all_geometries_.index_range()) {
+      if (status.stop_requested()) {
+        return false;
+      }
+      Geometry &geometry = *all_geometries_[i];
+      if (geometry.geom_type_ == GEOM_MESH) {
+        MeshFromGeometry mesh_from_geometry{geometry, global_vertices_};
+        meshes_[i] = mesh_from_geometry.create_mesh_nomain(params_);
+      }
+      status.set_progress(0.3f + 0.7f * float(i + 1) / float(all_geometries_.size()));
+    }
+    return true;
+  }
+
+  void add_to_main(Main *bmain, Scene *scene, ViewLayer *view_layer, ReportList *reports) override
+  {
+    params_.reports = reports;
+    Map<std::string, Material *> created_materials;
+
+    if (params_.clear_selection) {
+      BKE_view_layer_base_deselect_all(scene, view_layer);
+    }
+    geometry_to_blender_objects(bmain,
+                                scene,
+                                view_layer,
+                                params_,
+                                all_geometries_,
+                                meshes_,
+                                global_vertices_,
+                                materials_,
+                                created_materials);
+  }
+};
+
+std::unique_ptr<FileImportTask> create_import_task(const OBJImportParams &import_params)
+{
+  return std::make_unique<OBJImportTask>(import_params, 256 * 1024);
+}
+
 void importer_main(Main *bmain,
                    Scene *scene,
                    ViewLayer *view_layer,
                    const OBJImportParams &import_params,
                    size_t read_buffer_size)
 {
-  /* List of Geometry instances to be parsed from OBJ file. */
-  Vector<std::unique_ptr<Geometry>> all_geometries;
-  /* Container for vertex and UV vertex coordinates. */
-  GlobalVertices global_vertices;
-  /* List of MTLMaterial instances to be parsed from MTL file. */
-  Map<std::string, std::unique_ptr<MTLMaterial>> materials;
-  Map<std::string, Material *> created_materials;
-
-  OBJParser obj_parser{import_params, read_buffer_size};
-  obj_parser.parse(all_geometries, global_vertices);
-
-  for (StringRefNull mtl_library : obj_parser.mtl_libraries()) {
-    MTLParser mtl_parser{mtl_library, import_params.filepath};
-    mtl_parser.parse_and_store(materials);
-  }
-
-  if (import_params.clear_selection) {
-    BKE_view_layer_base_deselect_all(scene, view_layer);
+  OBJImportTask task(import_params, read_buffer_size);
+  FileImportTaskStatus status;
+  status.reports = import_params.reports;
+  if (task.read(status)) {
+    task.add_to_main(bmain, scene, view_layer, import_params.reports);
   }
-  geometry_to_blender_objects(bmain,
-                              scene,
-                              view_layer,
-                              import_params,
-                              all_geometries,
-                              global_vertices,
-                              materials,
-                              created_materials);
 }
 }  // namespace blender::io::obj
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "IO_file_import_task.hh"
 #include "IO_wavefront_obj.hh"
 
 namespace blender::io::obj {
@@ -15,6 +18,9 @@ namespace blender::io::obj {
 /* Main import function used from within Blender. */
 void importer_main(bContext *C, const OBJImportParams &import_params);
 
+/** Import split into reading on a worker thread and adding to Main, see #FileImportTask. */
+std::unique_ptr<FileImportTask> create_import_task(const OBJImportParams &import_params);
+
 /* Used from tests, where full bContext does not exist. */
 void importer_main(Main *bmain,
                    Scene *scene,
@@ -21,6 +21,15 @@
 #  include <type_traits>
 #endif
 
+#ifdef __cplusplus
+namespace blender::bke {
+struct AnimDataPathCache;
+}
+using AnimDataPathCacheHandle = blender::bke::AnimDataPathCache;
+#else
+typedef struct AnimDataPathCacheHandle AnimDataPathCacheHandle;
+#endif
+
 /* ************************************************ */
 /* F-Curve DataTypes */
 
@@ -1165,6 +1174,8 @@ typedef struct AnimData {
 
   /** Runtime data, for depsgraph evaluation. */
   FCurve **driver_array;
+  /** Runtime data, resolved RNA paths of the animated properties of evaluated IDs. */
+  AnimDataPathCacheHandle *path_cache;
 
   /* settings for animation evaluation */
   /** User-defined settings. */
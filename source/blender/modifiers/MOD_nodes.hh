@@ -10,6 +10,9 @@ struct Object;
 namespace blender::bke::bake {
 struct ModifierCache;
 }
+namespace blender::nodes {
+class GeoNodesJoinCaches;
+}
 namespace blender::nodes::geo_eval_log {
 class GeoModifierLog;
 }
@@ -35,6 +38,11 @@ struct NodesModifierRuntime {
    * used by the evaluated modifier.
    */
   std::shared_ptr<bke::bake::ModifierCache> cache;
+  /**
+   * Caches of the Join Geometry nodes, which are shared between original and evaluated modifiers
+   * like the simulation cache, so that they are kept when the evaluated modifier is copied again.
+   */
+  std::shared_ptr<nodes::GeoNodesJoinCaches> join_caches;
 };
 
 void nodes_modifier_data_block_destruct(NodesModifierDataBlock *data_block, bool do_id_user);
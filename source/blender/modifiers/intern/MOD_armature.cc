@@ -56,6 +56,18 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   tamd->vert_coords_prev = nullptr;
 }
 
+static void free_runtime_data(void *runtime_data)
+{
+  blender::bke::armature_deform_weights_free(
+      static_cast<blender::bke::ArmatureDeformWeights *>(runtime_data));
+}
+
+static void free_data(ModifierData *md)
+{
+  free_runtime_data(md->runtime);
+  md->runtime = nullptr;
+}
+
 static void required_data_mask(ModifierData * /*md*/, CustomData_MeshMasks *r_cddata_masks)
 {
   /* Ask for vertex-groups. */
@@ -123,6 +135,8 @@ static void deform_verts(ModifierData *md,
   /* if next modifier needs original vertices */
   MOD_previous_vcos_store(md, reinterpret_cast<float(*)[3]>(positions.data()));
 
+  /* The vertex group weights are kept in the runtime data for the next evaluation. */
+  auto *weights = static_cast<blender::bke::ArmatureDeformWeights *>(md->runtime);
   BKE_armature_deform_coords_with_mesh(amd->object,
                                        ctx->object,
                                        reinterpret_cast<float(*)[3]>(positions.data()),
@@ -131,7 +145,9 @@ static void deform_verts(ModifierData *md,
                                        amd->deformflag,
                                        amd->vert_coords_prev,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       &weights);
+  md->runtime = weights;
 
   /* free cache */
   MEM_SAFE_FREE(amd->vert_coords_prev);
@@ -194,6 +210,7 @@ static void deform_matrices(ModifierData *md,
                             blender::MutableSpan<blender::float3x3> matrices)
 {
   ArmatureModifierData *amd = (ArmatureModifierData *)md;
+  auto *weights = static_cast<blender::bke::ArmatureDeformWeights *>(md->runtime);
   BKE_armature_deform_coords_with_mesh(amd->object,
                                        ctx->object,
                                        reinterpret_cast<float(*)[3]>(positions.data()),
@@ -202,7 +219,9 @@ static void deform_matrices(ModifierData *md,
                                        amd->deformflag,
                                        nullptr,
                                        amd->defgrp_name,
-                                       mesh);
+                                       mesh,
+                                       &weights);
+  md->runtime = weights;
 }
 
 static void panel_draw(const bContext * /*C*/, Panel *panel)
@@ -263,14 +282,14 @@ ModifierTypeInfo modifierType_Armature = {
 
     /*init_data*/ init_data,
     /*required_data_mask*/ required_data_mask,
-    /*free_data*/ nullptr,
+    /*free_data*/ free_data,
     /*is_disabled*/ is_disabled,
     /*update_depsgraph*/ update_depsgraph,
     /*depends_on_time*/ nullptr,
     /*depends_on_normals*/ nullptr,
     /*foreach_ID_link*/ foreach_ID_link,
     /*foreach_tex_link*/ nullptr,
-    /*free_runtime_data*/ nullptr,
+    /*free_runtime_data*/ free_runtime_data,
     /*panel_register*/ panel_register,
     /*blend_write*/ nullptr,
     /*blend_read*/ blend_read,
@@ -114,6 +114,7 @@ static void init_data(ModifierData *md)
   MEMCPY_STRUCT_AFTER(nmd, DNA_struct_default_get(NodesModifierData), modifier);
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->join_caches = std::make_shared<nodes::GeoNodesJoinCaches>();
 }
 
 static void find_used_ids_from_settings(const NodesModifierSettings &settings, Set<ID *> &ids)
@@ -1696,6 +1697,7 @@ static void modifyGeometry(ModifierData *md,
   nodes::GeoNodesModifierData modifier_eval_data{};
   modifier_eval_data.depsgraph = ctx->depsgraph;
   modifier_eval_data.self_object = ctx->object;
+  modifier_eval_data.join_caches = nmd->runtime->join_caches.get();
   auto eval_log = std::make_unique<geo_log::GeoModifierLog>();
   call_data.modifier_data = &modifier_eval_data;
 
@@ -1723,6 +1725,9 @@ static void modifyGeometry(ModifierData *md,
                                                            modifier_compute_context,
                                                            call_data,
                                                            std::move(geometry_set));
+  if (nmd->runtime->join_caches) {
+    nmd->runtime->join_caches->remove_unused();
+  }
 
   if (logging_enabled(ctx)) {
     nmd_orig->runtime->eval_log = std::move(eval_log);
@@ -2427,6 +2432,7 @@ static void blend_read(BlendDataReader *reader, ModifierData *md)
 
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->join_caches = std::make_shared<nodes::GeoNodesJoinCaches>();
 }
 
 static void copy_data(const ModifierData *md, ModifierData *target, const int flag)
@@ -2467,11 +2473,13 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   if (flag & LIB_ID_COPY_SET_COPIED_ON_WRITE) {
     /* Share the simulation cache between the original and evaluated modifier. */
     tnmd->runtime->cache = nmd->runtime->cache;
+    tnmd->runtime->join_caches = nmd->runtime->join_caches;
     /* Keep bake path in the evaluated modifier. */
     tnmd->bake_directory = nmd->bake_directory ? BLI_strdup(nmd->bake_directory) : nullptr;
   }
   else {
     tnmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+    tnmd->runtime->join_caches = std::make_shared<nodes::GeoNodesJoinCaches>();
     /* Clear the bake path when duplicating. */
     tnmd->bake_directory = nullptr;
   }
@@ -28,6 +28,8 @@
 
 #include "DEG_depsgraph_query.hh"
 
+#include "MEM_guardedalloc.h"
+
 #include "MOD_ui_common.hh"
 #include "MOD_util.hh"
 
@@ -40,6 +42,17 @@ static void init_data(ModifierData *md)
   MEMCPY_STRUCT_AFTER(smd, DNA_struct_default_get(ShrinkwrapModifierData), modifier);
 }
 
+static void free_runtime_data(void *runtime_data)
+{
+  MEM_delete(static_cast<blender::bke::shrinkwrap::NearestHitCache *>(runtime_data));
+}
+
+static void free_data(ModifierData *md)
+{
+  free_runtime_data(md->runtime);
+  md->runtime = nullptr;
+}
+
 static void required_data_mask(ModifierData *md, CustomData_MeshMasks *r_cddata_masks)
 {
   ShrinkwrapModifierData *smd = (ShrinkwrapModifierData *)md;
@@ -88,6 +101,8 @@ static void deform_verts(ModifierData *md,
   int defgrp_index = -1;
   MOD_get_vgroup(ctx->object, mesh, swmd->vgroup_name, &dvert, &defgrp_index);
 
+  /* The nearest target triangles are kept in the runtime data for the next evaluation. */
+  auto *hit_cache = static_cast<blender::bke::shrinkwrap::NearestHitCache *>(md->runtime);
   shrinkwrapModifier_deform(swmd,
                             ctx,
                             scene,
@@ -96,7 +111,9 @@ static void deform_verts(ModifierData *md,
                             dvert,
                             defgrp_index,
                             reinterpret_cast<float(*)[3]>(positions.data()),
-                            positions.size());
+                            positions.size(),
+                            &hit_cache);
+  md->runtime = hit_cache;
 }
 
 static void update_depsgraph(ModifierData *md, const ModifierUpdateDepsgraphContext *ctx)
@@ -212,14 +229,14 @@ ModifierTypeInfo modifierType_Shrinkwrap = {
 
     /*init_data*/ init_data,
     /*required_data_mask*/ required_data_mask,
-    /*free_data*/ nullptr,
+    /*free_data*/ free_data,
     /*is_disabled*/ is_disabled,
     /*update_depsgraph*/ update_depsgraph,
     /*depends_on_time*/ nullptr,
     /*depends_on_normals*/ nullptr,
     /*foreach_ID_link*/ foreach_ID_link,
     /*foreach_tex_link*/ nullptr,
-    /*free_runtime_data*/ nullptr,
+    /*free_runtime_data*/ free_runtime_data,
     /*panel_register*/ panel_register,
     /*blend_write*/ nullptr,
     /*blend_read*/ nullptr,
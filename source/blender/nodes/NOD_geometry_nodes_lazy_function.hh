@@ -20,6 +20,7 @@
  * #lazy_function::Graph is build that can be used when evaluating the graph (e.g. for logging).
  */
 
+#include <mutex>
 #include <variant>
 
 #include "FN_lazy_function_graph.hh"
@@ -37,6 +38,9 @@
 struct Object;
 struct Depsgraph;
 struct Scene;
+namespace blender::geometry {
+struct JoinAttributesCache;
+}
 
 namespace blender::nodes {
 
@@ -156,6 +160,45 @@ struct GeoNodesSideEffectNodes {
   MultiValueMap<std::pair<ComputeContextHash, int32_t>, int> iterations_by_repeat_zone;
 };
 
+/**
+ * Caches of the Join Geometry nodes in a modifier that are kept between evaluations. They allow
+ * reusing joined attribute arrays when the joined geometries didn't change (see
+ * #geometry::JoinAttributesCache).
+ *
+ * The joined arrays of nodes whose output isn't used anymore after the evaluation, e.g. because
+ * it was only an intermediate result, are kept alive by the caches alone. That memory is limited
+ * to #unshared_memory_budget, see #remove_unused.
+ */
+class GeoNodesJoinCaches : NonCopyable, NonMovable {
+ private:
+  struct NodeCache;
+  std::mutex mutex_;
+  /** The caches by the compute context and the identifier of the node. */
+  Map<std::pair<ComputeContextHash, int32_t>, std::unique_ptr<NodeCache>> caches_;
+
+ public:
+  GeoNodesJoinCaches();
+  ~GeoNodesJoinCaches();
+
+  /**
+   * Call \a fn with the cache of the node in the given compute context. The cache is null if it is
+   * used by another evaluation at the same time.
+   */
+  void use_cache(const ComputeContextHash &context_hash,
+                 int32_t node_id,
+                 FunctionRef<void(geometry::JoinAttributesCache *cache)> fn);
+
+  /** Memory in bytes that the caches may use for arrays that nothing else references. */
+  static constexpr int64_t unshared_memory_budget = 256 * 1024 * 1024;
+
+  /**
+   * Free the caches of nodes that haven't been evaluated since the last call. Then, while the
+   * arrays that only the caches reference use more than #unshared_memory_budget, free them from
+   * the caches using most of that memory.
+   */
+  void remove_unused();
+};
+
 /**
  * Data that is passed into geometry nodes evaluation from the modifier.
  */
@@ -164,6 +207,8 @@ struct GeoNodesModifierData {
   const Object *self_object = nullptr;
   /** Depsgraph that is evaluating the modifier. */
   Depsgraph *depsgraph = nullptr;
+  /** Caches of Join Geometry nodes that are kept between evaluations of the modifier. */
+  GeoNodesJoinCaches *join_caches = nullptr;
 };
 
 struct GeoNodesOperatorDepsgraphs {
@@ -4,6 +4,7 @@
 
 #include "BLI_array_utils.hh"
 #include "BLI_task.hh"
+#include "BLI_thread_local_arena.hh"
 
 #include "BKE_attribute_math.hh"
 #include "BKE_mesh.hh"
@@ -632,9 +633,13 @@ static Mesh *calc_dual_mesh(const Mesh &src_mesh,
   Array<int> vert_to_face_indices = src_mesh.vert_to_face_map().data;
   const OffsetIndices<int> vert_to_face_offsets = src_mesh.vert_to_face_map().offsets;
 
-  Array<Array<int>> vertex_shared_edges(src_mesh.verts_num);
-  Array<Array<int>> vertex_corners(src_mesh.verts_num);
+  /* The sorted edges and corners of all vertices are needed until the end, and they are small,
+   * so they are allocated together instead of separately for every vertex. */
+  threading::ThreadLocalArena arena;
+  Array<Span<int>> vertex_shared_edges(src_mesh.verts_num);
+  Array<Span<int>> vertex_corners(src_mesh.verts_num);
   threading::parallel_for(src_positions.index_range(), 512, [&](IndexRange range) {
+    threading::ThreadLocalArena::LocalAllocator &allocator = arena.local();
     for (const int i : range) {
       if (vertex_types[i] == VertexType::Loose || vertex_types[i] >= VertexType::NonManifold ||
           (!keep_boundaries && vertex_types[i] == VertexType::Boundary))
@@ -644,10 +649,10 @@ static Mesh *calc_dual_mesh(const Mesh &src_mesh,
       }
       MutableSpan<int> corner_indices = vert_to_face_indices.as_mutable_span().slice(
           vert_to_face_offsets[i]);
-      Array<int> sorted_corners(corner_indices.size());
+      MutableSpan<int> sorted_corners = allocator.allocate_array<int>(corner_indices.size());
       bool vertex_ok = true;
       if (vertex_types[i] == VertexType::Normal) {
-        Array<int> shared_edges(corner_indices.size());
+        MutableSpan<int> shared_edges = allocator.allocate_array<int>(corner_indices.size());
         vertex_ok = sort_vertex_faces(src_edges,
                                       src_faces,
                                       src_corner_verts,
@@ -658,10 +663,10 @@ static Mesh *calc_dual_mesh(const Mesh &src_mesh,
                                       corner_indices,
                                       shared_edges,
                                       sorted_corners);
-        vertex_shared_edges[i] = std::move(shared_edges);
+        vertex_shared_edges[i] = shared_edges;
       }
       else {
-        Array<int> shared_edges(corner_indices.size() - 1);
+        MutableSpan<int> shared_edges = allocator.allocate_array<int>(corner_indices.size() - 1);
         vertex_ok = sort_vertex_faces(src_edges,
                                       src_faces,
                                       src_corner_verts,
@@ -672,7 +677,7 @@ static Mesh *calc_dual_mesh(const Mesh &src_mesh,
                                       corner_indices,
                                       shared_edges,
                                       sorted_corners);
-        vertex_shared_edges[i] = std::move(shared_edges);
+        vertex_shared_edges[i] = shared_edges;
       }
       if (!vertex_ok) {
         /* The sorting failed which means that the vertex is non-manifold and should be ignored
@@ -680,7 +685,7 @@ static Mesh *calc_dual_mesh(const Mesh &src_mesh,
         vertex_types[i] = VertexType::NonManifold;
         continue;
       }
-      vertex_corners[i] = std::move(sorted_corners);
+      vertex_corners[i] = sorted_corners;
     }
   });
 
@@ -25,7 +25,21 @@ static void node_geo_exec(GeoNodeExecParams params)
     GeometryComponentEditData::remember_deformed_positions_if_necessary(geometry);
   }
 
-  GeometrySet geometry_set_result = geometry::join_geometries(geometry_sets, propagation_info);
+  GeometrySet geometry_set_result;
+  const GeoNodesLFUserData &user_data = *params.user_data();
+  const GeoNodesModifierData *modifier_data = user_data.call_data->modifier_data;
+  if (modifier_data && modifier_data->join_caches) {
+    /* Reuse the attributes joined in the previous evaluation of the modifier where possible. */
+    modifier_data->join_caches->use_cache(
+        user_data.compute_context->hash(),
+        params.node().identifier,
+        [&](geometry::JoinAttributesCache *cache) {
+          geometry_set_result = geometry::join_geometries(geometry_sets, propagation_info, cache);
+        });
+  }
+  else {
+    geometry_set_result = geometry::join_geometries(geometry_sets, propagation_info);
+  }
 
   params.set_output("Geometry", std::move(geometry_set_result));
 }
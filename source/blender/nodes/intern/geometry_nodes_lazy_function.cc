@@ -47,6 +47,8 @@
 #include "FN_lazy_function_execute.hh"
 #include "FN_lazy_function_graph_executor.hh"
 
+#include "GEO_join_geometries.hh"
+
 #include "DEG_depsgraph_query.hh"
 
 #include <fmt/format.h>
@@ -4367,6 +4369,81 @@ GeoNodesOperatorDepsgraphs::~GeoNodesOperatorDepsgraphs()
   }
 }
 
+struct GeoNodesJoinCaches::NodeCache {
+  std::mutex mutex;
+  geometry::JoinAttributesCache cache;
+  bool is_used = false;
+};
+
+GeoNodesJoinCaches::GeoNodesJoinCaches() = default;
+GeoNodesJoinCaches::~GeoNodesJoinCaches() = default;
+
+void GeoNodesJoinCaches::use_cache(
+    const ComputeContextHash &context_hash,
+    const int32_t node_id,
+    const FunctionRef<void(geometry::JoinAttributesCache *cache)> fn)
+{
+  geometry::JoinAttributesCache *cache = nullptr;
+  std::unique_lock<std::mutex> cache_lock;
+  {
+    std::lock_guard lock{mutex_};
+    NodeCache &node_cache = *caches_.lookup_or_add_cb(
+        {context_hash, node_id}, []() { return std::make_unique<NodeCache>(); });
+    /* Lock the node cache before the map is unlocked, so that it can't be removed meanwhile. */
+    cache_lock = std::unique_lock(node_cache.mutex, std::try_to_lock);
+    if (cache_lock.owns_lock()) {
+      node_cache.is_used = true;
+      cache = &node_cache.cache;
+    }
+  }
+  fn(cache);
+}
+
+void GeoNodesJoinCaches::remove_unused()
+{
+  std::lock_guard lock{mutex_};
+  caches_.remove_if([](const auto &item) {
+    NodeCache &node_cache = *item.value;
+    std::unique_lock cache_lock(node_cache.mutex, std::try_to_lock);
+    if (!cache_lock.owns_lock()) {
+      /* Used by another evaluation. */
+      return false;
+    }
+    const bool is_used = node_cache.is_used;
+    node_cache.is_used = false;
+    return !is_used;
+  });
+
+  Vector<std::pair<int64_t, NodeCache *>> unshared_sizes;
+  int64_t unshared_size = 0;
+  for (std::unique_ptr<NodeCache> &node_cache : caches_.values()) {
+    std::unique_lock cache_lock(node_cache->mutex, std::try_to_lock);
+    if (!cache_lock.owns_lock()) {
+      continue;
+    }
+    const int64_t size = node_cache->cache.unshared_memory_size();
+    unshared_sizes.append({size, node_cache.get()});
+    unshared_size += size;
+  }
+  if (unshared_size <= unshared_memory_budget) {
+    return;
+  }
+  std::sort(unshared_sizes.begin(), unshared_sizes.end(), [](const auto &a, const auto &b) {
+    return a.first > b.first;
+  });
+  for (const auto &[size, node_cache] : unshared_sizes) {
+    std::unique_lock cache_lock(node_cache->mutex, std::try_to_lock);
+    if (!cache_lock.owns_lock()) {
+      continue;
+    }
+    node_cache->cache.remove_unshared();
+    unshared_size -= size;
+    if (unshared_size <= unshared_memory_budget) {
+      break;
+    }
+  }
+}
+
 static const ID *get_only_evaluated_id(const Depsgraph &depsgraph, const ID &id_orig)
 {
   const ID *id = DEG_get_evaluated_id(&depsgraph, const_cast<ID *>(&id_orig));
@@ -28,6 +28,7 @@
 #  include "BLI_string.h"
 #  include "BLI_string_utf8.h"
 #  include "BLI_system.h"
+#  include "BLI_task_profile.hh"
 #  include "BLI_threads.h"
 #  include "BLI_utildefines.h"
 #  ifndef NDEBUG
@@ -35,6 +36,7 @@
 #  endif
 
 #  include "BKE_appdir.hh"
+#  include "BKE_blender.hh"
 #  include "BKE_blender_cli_command.hh"
 #  include "BKE_blender_version.h"
 #  include "BKE_blendfile.hh"
@@ -739,6 +741,7 @@ static void print_help(bArgs *ba, bool all)
   }
   BLI_args_print_arg_doc(ba, "--debug-memory");
   BLI_args_print_arg_doc(ba, "--debug-jobs");
+  BLI_args_print_arg_doc(ba, "--debug-tasks-trace");
   BLI_args_print_arg_doc(ba, "--debug-python");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-eval");
@@ -1385,6 +1388,34 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void * /*data
   return 0;
 }
 
+static const char arg_handle_debug_tasks_trace_set_doc[] =
+    "<filepath>\n"
+    "\tProfile the tasks run by the thread pool and write them to <filepath> on exit,\n"
+    "\tin the Chrome trace format.";
+static void callback_debug_tasks_trace_write(void *user_data)
+{
+  const char *filepath = static_cast<const char *>(user_data);
+  blender::threading::profile::stop();
+  if (!blender::threading::profile::write_chrome_trace(filepath)) {
+    fprintf(stderr, "Error: could not write task trace to '%s'\n", filepath);
+  }
+}
+static int arg_handle_debug_tasks_trace_set(int argc, const char **argv, void * /*data*/)
+{
+  if (argc > 1) {
+    static char filepath[FILE_MAX];
+    if (filepath[0] == '\0') {
+      BKE_blender_atexit_register(callback_debug_tasks_trace_write, filepath);
+    }
+    STRNCPY(filepath, argv[1]);
+    BLI_path_abs_from_cwd(filepath, sizeof(filepath));
+    blender::threading::profile::start();
+    return 1;
+  }
+  fprintf(stderr, "\nError: you must specify a file path after '--debug-tasks-trace'.\n");
+  return 0;
+}
+
 static const char arg_handle_debug_gpu_set_doc[] =
     "\n"
     "\tEnable GPU debug context and information for OpenGL 4.3+.";
@@ -2714,6 +2745,8 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
   BLI_args_add(ba, nullptr, "--debug-memory", CB(arg_handle_debug_mode_memory_set), nullptr);
 
   BLI_args_add(ba, nullptr, "--debug-value", CB(arg_handle_debug_value_set), nullptr);
+  BLI_args_add(
+      ba, nullptr, "--debug-tasks-trace", CB(arg_handle_debug_tasks_trace_set), nullptr);
   BLI_args_add(ba,
                nullptr,
                "--debug-jobs",